@@ -4,33 +4,457 @@
 #include "assert.h"
 #include "compress40.h"
 #include "readWriteImage.h"
+#include "stageTimer.h"
+#include "trace.h"
+#include "perfCounters.h"
+#include "batch40.h"
+#include "server40.h"
+#include "compressedOps.h"
+#include "checksum.h"
+#include "blockOperation.h"
+#include "blockTransform.h"
+#include "tiled40.h"
 
 static void (*compress_or_decompress)(FILE *input) = compress40;
 
+/* Set by --half, --partial and --crop; see decompressRegion */
+static bool half = false;
+static bool partial = false;
+static bool cropping = false;
+static struct cropRect crop;
+
+/* Set by --format and --block; see compressFormat */
+static unsigned format = 2;
+static int blockSize = DEFAULT_TRANSFORM_SIZE;
+
+/* Set by --scales, or by --target-rms and --target-size */
+static bool scaled = false;
+static struct quantScales scales;
+static bool targeted = false;
+static struct rateTarget target = { 0, 0, false };
+
+/* Compresses to stdout in the --format with the chosen scales */
+static void compressFormat(FILE *input)
+{
+        if (format == 7) {
+                compress40_blocks(input, stdout, blockSize);
+                return;
+        }
+        compress40_tuned(input, stdout, format, scaled ? &scales : NULL,
+                         targeted ? &target : NULL);
+}
+
+/* Set by --tiled; see compressTiled and decompressTiled */
+static bool tiled = false;
+
+/* Compresses to stdout a band at a time with the --scales, for --tiled */
+static void compressTiled(FILE *input)
+{
+        if (!compress40_tiled(input, stdout, scaled ? &scales : NULL)) {
+                exit(EXIT_FAILURE);
+        }
+}
+
+/* Decompresses to stdout a band at a time, for --tiled */
+static void decompressTiled(FILE *input)
+{
+        if (!decompress40_tiled(input, stdout)) {
+                exit(EXIT_FAILURE);
+        }
+}
+
+/* Prints the round-trip RMS error of compressing a PPM, for -q */
+static void reportQuality(FILE *input)
+{
+        if (format == 7) {
+                printf("%.4f\n", compress40_blocks_quality(input, blockSize));
+                return;
+        }
+        printf("%.4f\n", compress40_quality(input, format,
+                                             scaled ? &scales : NULL,
+                                             targeted ? &target : NULL));
+}
+
+/* Set by --transform; see transformInput */
+static enum transform transform;
+
+/* Applies the --transform to a compressed image, writing it to stdout */
+static void transformInput(FILE *input)
+{
+        if (!transformCompressed(input, stdout, transform)) {
+                exit(EXIT_FAILURE);
+        }
+}
+
+/* Set by --cut; see cutInput */
+static struct cropRect cut;
+
+/* Crops a compressed image to the --cut rectangle, writing it to stdout */
+static void cutInput(FILE *input)
+{
+        if (!cropCompressed(input, stdout, cut.x, cut.y, cut.width,
+                            cut.height)) {
+                exit(EXIT_FAILURE);
+        }
+}
+
+/* Decompresses with the --half, --partial and --crop settings to stdout */
+static void decompressRegion(FILE *input)
+{
+        decompress40_region(input, stdout, half, partial,
+                            cropping ? &crop : NULL);
+}
+
+/* Stitches the named compressed images for --hcat, --vcat or --mosaic */
+static int stitchFiles(char **paths, int count, int columns)
+{
+        if (count == 0) {
+                fprintf(stderr, "no images to stitch\n");
+                return EXIT_FAILURE;
+        }
+
+        FILE **inputs = malloc(count * sizeof(FILE *));
+        assert(inputs != NULL);
+        for (int k = 0; k < count; k++) {
+                inputs[k] = fopen(paths[k], "rb");
+                if (inputs[k] == NULL) {
+                        fprintf(stderr, "%s: cannot open\n", paths[k]);
+                        exit(EXIT_FAILURE);
+                }
+        }
+
+        bool stitched = mosaicCompressed(inputs, count, columns, stdout);
+
+        for (int k = 0; k < count; k++) {
+                fclose(inputs[k]);
+        }
+        free(inputs);
+        return stitched ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/* Checks the checksums of the named compressed images, or of stdin */
+static int verifyFiles(char **paths, int count)
+{
+        if (count == 0) {
+                return verifyChecksums(stdin, "(stdin)", stdout) ?
+                       EXIT_SUCCESS : EXIT_FAILURE;
+        }
+
+        int failures = 0;
+        for (int k = 0; k < count; k++) {
+                FILE *input = fopen(paths[k], "rb");
+                if (input == NULL) {
+                        fprintf(stdout, "%s: FAILED, cannot open\n",
+                                paths[k]);
+                        failures++;
+                        continue;
+                }
+                if (!verifyChecksums(input, paths[k], stdout)) {
+                        failures++;
+                }
+                fclose(input);
+        }
+        return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
 int main(int argc, char *argv[])
 {
         
         int i;
+        bool batch = false;
+        const char *serveSocket = NULL;
+        const char *connectSocket = NULL;
+        bool passFds = false;
+        int mosaicColumns = -1;         /* -1 unless stitching images */
+        bool verify = false;
+        bool blockGiven = false;
+        struct batchOptions options = { false, 0, NULL, NULL, NULL, NULL, 0 };
+        options.paths = malloc(argc * sizeof(char *));
+        assert(options.paths != NULL);
+
+        /* Timings may also be requested without changing the command line */
+        const char *timingsEnv = getenv("ARITH40_TIMINGS");
+        if (timingsEnv != NULL && *timingsEnv != '\0' && 
+            strcmp(timingsEnv, "0") != 0) {
+                timingsEnable();
+        }
 
         for (i = 1; i < argc; i++) {
                 if (strcmp(argv[i], "-c") == 0) {
                         compress_or_decompress = compress40;
                 } else if (strcmp(argv[i], "-d") == 0) {
                         compress_or_decompress = decompress40;
+                } else if (strcmp(argv[i], "-q") == 0) {
+                        compress_or_decompress = reportQuality;
+                } else if (strcmp(argv[i], "--transform") == 0 &&
+                           i + 1 < argc) {
+                        if (!parseTransform(argv[++i], &transform)) {
+                                fprintf(stderr, "%s: unknown transform '%s' "
+                                        "(flip-h, flip-v, transpose, "
+                                        "transverse, rot90, rot180, "
+                                        "rot270)\n", argv[0], argv[i]);
+                                exit(1);
+                        }
+                        compress_or_decompress = transformInput;
+                } else if (strcmp(argv[i], "--cut") == 0 && i + 1 < argc) {
+                        if (sscanf(argv[++i], "%u,%u,%u,%u", &cut.x, &cut.y,
+                                   &cut.width, &cut.height) != 4) {
+                                fprintf(stderr, "%s: --cut expects "
+                                        "X,Y,WIDTH,HEIGHT\n", argv[0]);
+                                exit(1);
+                        }
+                        compress_or_decompress = cutInput;
+                } else if (strcmp(argv[i], "--hcat") == 0) {
+                        mosaicColumns = 0;
+                } else if (strcmp(argv[i], "--vcat") == 0) {
+                        mosaicColumns = 1;
+                } else if (strcmp(argv[i], "--mosaic") == 0 && i + 1 < argc) {
+                        mosaicColumns = atoi(argv[++i]);
+                        if (mosaicColumns < 1) {
+                                fprintf(stderr, "%s: --mosaic expects a "
+                                        "positive number of columns\n",
+                                        argv[0]);
+                                exit(1);
+                        }
+                } else if (strcmp(argv[i], "--format") == 0 && 
+                           i + 1 < argc) {
+                        format = atoi(argv[++i]);
+                        if (format < 2 || format > 7) {
+                                fprintf(stderr, "%s: --format expects 2 to "
+                                        "7\n", argv[0]);
+                                exit(1);
+                        }
+                } else if (strcmp(argv[i], "--block") == 0 && i + 1 < argc) {
+                        blockSize = atoi(argv[++i]);
+                        blockGiven = true;
+                        if (!validTransformSize(blockSize)) {
+                                fprintf(stderr, "%s: --block expects 4 or "
+                                        "8\n", argv[0]);
+                                exit(1);
+                        }
+                } else if (strcmp(argv[i], "--scales") == 0 && 
+                           i + 1 < argc) {
+                        scaled = sscanf(argv[++i], "%u,%u,%u", &scales.a,
+                                        &scales.bcd, &scales.bcdMax) == 3 &&
+                                 validScales(&scales);
+                        if (!scaled) {
+                                fprintf(stderr, "%s: --scales expects "
+                                        "A,BCD,MAX with A 1-511, BCD "
+                                        "1-1000 and MAX 1-15\n", argv[0]);
+                                exit(1);
+                        }
+                } else if (strcmp(argv[i], "--target-rms") == 0 &&
+                           i + 1 < argc) {
+                        target.rms = atof(argv[++i]);
+                        targeted = target.rms > 0;
+                        if (!targeted) {
+                                fprintf(stderr, "%s: --target-rms expects "
+                                        "a positive error\n", argv[0]);
+                                exit(1);
+                        }
+                } else if (strcmp(argv[i], "--target-size") == 0 &&
+                           i + 1 < argc) {
+                        target.bytes = strtoull(argv[++i], NULL, 10);
+                        targeted = target.bytes > 0;
+                        if (!targeted) {
+                                fprintf(stderr, "%s: --target-size expects "
+                                        "a positive number of bytes\n",
+                                        argv[0]);
+                                exit(1);
+                        }
+                } else if (strcmp(argv[i], "--tiled") == 0) {
+                        tiled = true;
+                } else if (strcmp(argv[i], "--checksum") == 0) {
+                        checksumsEnable();
+                } else if (strcmp(argv[i], "--verify") == 0) {
+                        verify = true;
+                } else if (strcmp(argv[i], "--half") == 0) {
+                        half = true;
+                } else if (strcmp(argv[i], "--partial") == 0) {
+                        partial = true;
+                } else if (strcmp(argv[i], "--crop") == 0 && i + 1 < argc) {
+                        cropping = sscanf(argv[++i], "%u,%u,%u,%u", &crop.x,
+                                          &crop.y, &crop.width,
+                                          &crop.height) == 4;
+                        if (!cropping) {
+                                fprintf(stderr, "%s: --crop expects "
+                                        "X,Y,WIDTH,HEIGHT\n", argv[0]);
+                                exit(1);
+                        }
+                } else if (strcmp(argv[i], "--timings") == 0) {
+                        timingsEnable();
+                } else if (strcmp(argv[i], "--perf-counters") == 0) {
+                        timingsEnable();
+                        perfCountersEnable();
+                } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+                        traceOpen(argv[++i]);
+                } else if (strcmp(argv[i], "--serve") == 0 && i + 1 < argc) {
+                        serveSocket = argv[++i];
+                } else if (strcmp(argv[i], "--connect") == 0 && 
+                           i + 1 < argc) {
+                        connectSocket = argv[++i];
+                } else if (strcmp(argv[i], "--pass-fd") == 0) {
+                        passFds = true;
+                } else if (strcmp(argv[i], "--batch") == 0) {
+                        batch = true;
+                } else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+                        batch = true;
+                        options.numWorkers = atoi(argv[++i]);
+                } else if (strcmp(argv[i], "--list") == 0 && i + 1 < argc) {
+                        batch = true;
+                        options.listFile = argv[++i];
+                } else if (strcmp(argv[i], "--dir") == 0 && i + 1 < argc) {
+                        batch = true;
+                        options.dir = argv[++i];
+                } else if (strcmp(argv[i], "--out") == 0 && i + 1 < argc) {
+                        batch = true;
+                        options.outPattern = argv[++i];
                 } else if (*argv[i] == '-') {
                         fprintf(stderr, "%s: unknown option '%s'\n",
                                 argv[0], argv[i]);
                         exit(1);
+                } else if (batch || mosaicColumns >= 0 || verify) {
+                        options.paths[options.numPaths++] = argv[i];
                 } else if (argc - i > 2) {
-                        fprintf(stderr, "Usage: %s -d [filename]\n"
-                                "       %s -c [filename]\n",
+                        fprintf(stderr, "Usage: %s [options] -d [filename]\n"
+                                "       %s [options] -c [filename]\n"
+                                "       %s [options] -q [filename]\n"
+                                "       %s [options] -c|-d --batch "
+                                "[filename ...]\n"
+                                "       %s --transform NAME [filename]\n"
+                                "       %s --cut X,Y,WIDTH,HEIGHT [filename]\n"
+                                "       %s --verify [filename ...]\n"
+                                "       %s --hcat|--vcat|--mosaic COLUMNS "
+                                "filename ...\n"
+                                "       %s [options] --serve SOCKET\n"
+                                "       %s [options] -c|-d --connect SOCKET "
+                                "[--pass-fd] [filename]\n"
+                                "Options: --timings, --perf-counters, "
+                                "--trace FILE, --tiled\n"
+                                "Compress options: --format 2-7, "
+                                "--block 4|8 (format 7), --checksum,\n"
+                                "                  --scales A,BCD,MAX, "
+                                "--target-rms R, --target-size BYTES\n"
+                                "Decompress options: --half, --partial, "
+                                "--crop X,Y,WIDTH,HEIGHT\n"
+                                "Batch options: -j N, --list FILE, "
+                                "--dir DIR, --out PATTERN\n",
+                                argv[0], argv[0], argv[0], argv[0],
+                                argv[0], argv[0], argv[0], argv[0],
                                 argv[0], argv[0]);
                         exit(1);
                 } else {
                         break;
                 }
         }
+        /* Modes that run a single image through compress_or_decompress */
+        bool singleImage = !batch && serveSocket == NULL &&
+                           connectSocket == NULL && !verify &&
+                           mosaicColumns < 0;
+        if ((half || partial || cropping) &&
+            (compress_or_decompress != decompress40 || !singleImage)) {
+                fprintf(stderr, "%s: --half, --partial and --crop apply "
+                        "only to -d on one image\n", argv[0]);
+                exit(1);
+        }
+        bool compressing = compress_or_decompress == compress40 ||
+                           compress_or_decompress == reportQuality;
+        if (format != 2 && (!compressing || !singleImage)) {
+                fprintf(stderr, "%s: --format applies only to -c and -q on "
+                        "one image\n", argv[0]);
+                exit(1);
+        }
+        if (blockGiven && format != 7) {
+                fprintf(stderr, "%s: --block applies only to --format 7\n",
+                        argv[0]);
+                exit(1);
+        }
+        if ((scaled || targeted) && (!compressing || !singleImage)) {
+                fprintf(stderr, "%s: --scales and --target-* apply only to "
+                        "-c and -q on one image\n", argv[0]);
+                exit(1);
+        }
+        if (checksumsEnabled() &&
+            (format != 2 || compress_or_decompress != compress40 ||
+             serveSocket != NULL || connectSocket != NULL || verify ||
+             mosaicColumns >= 0)) {
+                fprintf(stderr, "%s: --checksum applies only to -c with "
+                        "format 2\n", argv[0]);
+                exit(1);
+        }
+        if (tiled && (batch || serveSocket != NULL || connectSocket != NULL ||
+                      verify || mosaicColumns >= 0)) {
+                fprintf(stderr, "%s: --tiled applies only to -c and -d on "
+                        "one image\n", argv[0]);
+                exit(1);
+        }
+        if (serveSocket != NULL) {
+                free(options.paths);
+                int status = serve40(serveSocket, options.numWorkers);
+                return status;
+        }
+        if (verify) {
+                int status = verifyFiles(options.paths, options.numPaths);
+                free(options.paths);
+                return status;
+        }
+        if (mosaicColumns >= 0) {
+                int status = stitchFiles(options.paths, options.numPaths,
+                                         mosaicColumns);
+                free(options.paths);
+                return status;
+        }
+        if (batch) {
+                options.decompress = compress_or_decompress == decompress40;
+                int failures = batch40(&options);
+                free(options.paths);
+                return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+        free(options.paths);
+
         assert(argc - i <= 1);    /* at most one file on command line */
+        if (connectSocket != NULL) {
+                FILE *fp = i < argc ? fopen(argv[i], "r") : stdin;
+                assert(fp != NULL);
+                int status = client40(connectSocket, 
+                                      compress_or_decompress == decompress40,
+                                      fp, passFds);
+                if (fp != stdin) {
+                        fclose(fp);
+                }
+                return status;
+        }
+        if (tiled) {
+                if (format != 2 || targeted || half || partial ||
+                    cropping) {
+                        fprintf(stderr, "%s: --tiled reads and writes "
+                                "format 2 and takes only --scales and "
+                                "--checksum\n", argv[0]);
+                        exit(1);
+                }
+                if (compress_or_decompress == compress40) {
+                        compress_or_decompress = compressTiled;
+                } else if (compress_or_decompress == decompress40) {
+                        compress_or_decompress = decompressTiled;
+                } else {
+                        fprintf(stderr, "%s: --tiled applies only to -c and "
+                                "-d on one image\n", argv[0]);
+                        exit(1);
+                }
+        }
+        if ((half || partial || cropping) &&
+            compress_or_decompress == decompress40) {
+                compress_or_decompress = decompressRegion;
+        }
+        if (format == 7 && (scaled || targeted)) {
+                fprintf(stderr, "%s: --scales and --target-* apply to "
+                        "formats 2 to 6\n", argv[0]);
+                exit(1);
+        }
+        if ((format != 2 || scaled || targeted) &&
+            compress_or_decompress == compress40) {
+                compress_or_decompress = compressFormat;
+        }
         if (i < argc) {
                 FILE *fp = fopen(argv[i], "r");
                 assert(fp != NULL);
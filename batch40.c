@@ -0,0 +1,809 @@
+/*
+ *      batch40.c
+ *      Kevin Lu (klu07), Justin Paik (jpaik03)
+ *      October 18, 2026
+ *      arith
+ *
+ *      Implementation of batch mode. The inputs are gathered into a job list
+ *      up front, each with its output name already expanded, and a pool of
+ *      worker threads takes jobs from the list in order. Two inputs whose
+ *      outputs would have the same name are caught before any job runs.
+ *
+ *      Jobs go through the in-memory interface (compress40mem.h), as in
+ *      server mode: every worker keeps its input, pixel and output buffers
+ *      for the life of the batch and only grows them, and the decoder's
+ *      chroma table is built once and shared by all of them. A PPM is read
+ *      with ppmStream and checked sample by sample as it is loaded, and
+ *      decompress40_mem reports a malformed compressed image instead of
+ *      failing a CRE, so a bad file is reported and skipped rather than
+ *      ending the whole batch.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include <limits.h>
+#include <errno.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include "batch40.h"
+#include "compress40mem.h"
+#include "ppmStream.h"
+#include "checksum.h"
+#include "tableDecode.h"
+#include "stageTimer.h"
+#include "trace.h"
+
+#define IO_BUFFER_SIZE (1 << 20)
+#define BLOCKSIZE 2
+#define BYTES_PER_WORD 4
+
+/******** job struct ********
+ *
+ * One input and where its output goes.
+ *
+ * Fields:
+ *      char *input:            Path of the input
+ *      char *output:           Path of the output, expanded from the pattern
+ *      const char *clash:      Another job's input with the same output, or
+ *                                NULL; such a job is reported, not run
+ ************************/
+struct job
+{
+        char *input;
+        char *output;
+        const char *clash;
+};
+
+/******** jobList struct ********
+ *
+ * A growable array of jobs.
+ *
+ * Fields:
+ *      struct job *jobs:       The jobs, in the order they are handed out
+ *      int length:             How many jobs there are
+ *      int capacity:           How many fit before jobs must grow
+ ************************/
+struct jobList
+{
+        struct job *jobs;
+        int length;
+        int capacity;
+};
+
+/******** batchState struct ********
+ *
+ * What the workers of one batch share.
+ *
+ * Fields:
+ *      struct jobList *list:   The jobs to run
+ *      bool decompress:        The direction to run them in
+ *      int next:               Index of the next job to hand out
+ *      int failures:           Jobs that failed so far
+ *      pthread_mutex_t lock:   Guards next and failures
+ ************************/
+struct batchState
+{
+        struct jobList *list;
+        bool decompress;
+        int next;
+        int failures;
+        pthread_mutex_t lock;
+};
+
+/******** workerBuffers struct ********
+ *
+ * A worker's buffers, kept for every job it runs and only ever grown.
+ *
+ * Fields:
+ *      unsigned char *in, *pixels, *out:       The input file, the image's
+ *                                                raster and the encoded result
+ *      size_t inCapacity, pixelsCapacity, outCapacity:  Their sizes
+ *      unsigned *samples:      One row of samples from ppmStream
+ *      size_t samplesCapacity: Its size in bytes
+ *      char *stdioBuffer:      IO_BUFFER_SIZE bytes for the input and output
+ *                                streams
+ ************************/
+struct workerBuffers
+{
+        unsigned char *in, *pixels, *out;
+        size_t inCapacity, pixelsCapacity, outCapacity;
+        unsigned *samples;
+        size_t samplesCapacity;
+        char *stdioBuffer;
+};
+
+static void addInput(struct jobList *list, const char *input);
+static void readListFile(struct jobList *list, const char *path);
+static void readDirectory(struct jobList *list, const char *dir,
+                          bool decompress);
+static bool hasExtension(const char *name, bool decompress);
+static int compareJobs(const void *a, const void *b);
+static int compareOutputs(const void *a, const void *b);
+static char *expandPattern(const char *pattern, const char *input);
+static void findClashes(struct jobList *list);
+static void *runWorker(void *cl);
+static bool runJob(struct job *job, bool decompress,
+                   struct workerBuffers *buffers);
+static bool compressJob(FILE *input, const char *path,
+                        struct workerBuffers *buffers, size_t *outLength,
+                        unsigned *width, unsigned *height);
+static bool decompressJob(FILE *input, const char *path,
+                          struct workerBuffers *buffers, size_t *outLength,
+                          unsigned *width, unsigned *height);
+static bool writeTrailer(FILE *output, const unsigned char *compressed,
+                         size_t length, unsigned width, unsigned height);
+static void *ensureCapacity(void *buffer, size_t *capacity, size_t needed);
+
+/******** batch40 ********
+ *
+ * Compresses or decompresses every input described by options.
+ *
+ * Parameters:
+ *      struct batchOptions *options:   What to process and how
+ * Returns:
+ *      The number of inputs that could not be processed.
+ * Expects:
+ *      options is not NULL.
+ * Notes:
+ *      Throws a CRE if options is NULL or a thread cannot be started.
+ *      Each failure is reported on stderr; the remaining jobs still run.
+ *      Inputs from --dir are processed in name order, after those named on
+ *        the command line and in the list file.
+ *      Of several inputs with the same output, only the first is run; the
+ *        others are reported and count as failures.
+ ************************/
+int batch40(struct batchOptions *options)
+{
+        assert(options != NULL);
+
+        struct jobList list = { NULL, 0, 0 };
+        for (int i = 0; i < options->numPaths; i++) {
+                addInput(&list, options->paths[i]);
+        }
+        if (options->listFile != NULL) {
+                readListFile(&list, options->listFile);
+        }
+        if (options->dir != NULL) {
+                int first = list.length;
+                readDirectory(&list, options->dir, options->decompress);
+                qsort(list.jobs + first, list.length - first,
+                      sizeof(struct job), compareJobs);
+        }
+
+        const char *pattern = options->outPattern;
+        if (pattern == NULL) {
+                pattern = options->decompress ? "%d/%s.ppm" : "%d/%s.c40";
+        }
+        for (int i = 0; i < list.length; i++) {
+                list.jobs[i].output = expandPattern(pattern,
+                                                    list.jobs[i].input);
+        }
+        findClashes(&list);
+        tableDecodeInit();
+
+        int numWorkers = options->numWorkers;
+        if (numWorkers <= 0) {
+                numWorkers = (int) sysconf(_SC_NPROCESSORS_ONLN);
+        }
+        if (numWorkers > list.length) {
+                numWorkers = list.length;
+        }
+        if (numWorkers < 1) {
+                numWorkers = 1;
+        }
+
+        struct batchState state;
+        state.list = &list;
+        state.decompress = options->decompress;
+        state.next = 0;
+        state.failures = 0;
+        pthread_mutex_init(&state.lock, NULL);
+
+        pthread_t *threads = malloc(numWorkers * sizeof(*threads));
+        assert(threads != NULL);
+        for (int i = 0; i < numWorkers; i++) {
+                int result = pthread_create(&threads[i], NULL, runWorker,
+                                            &state);
+                assert(result == 0);
+        }
+        for (int i = 0; i < numWorkers; i++) {
+                pthread_join(threads[i], NULL);
+        }
+        free(threads);
+        pthread_mutex_destroy(&state.lock);
+
+        for (int i = 0; i < list.length; i++) {
+                free(list.jobs[i].input);
+                free(list.jobs[i].output);
+        }
+        free(list.jobs);
+
+        return state.failures;
+}
+
+/******** addInput ********
+ *
+ * Appends a job for one input path to the job list.
+ *
+ * Parameters:
+ *      struct jobList *list:   The list to grow
+ *      const char *input:      Path of the input; copied
+ * Returns:
+ *      Nothing.
+ ************************/
+static void addInput(struct jobList *list, const char *input)
+{
+        if (list->length == list->capacity) {
+                list->capacity = list->capacity == 0 ? 16 :
+                                 list->capacity * 2;
+                list->jobs = realloc(list->jobs,
+                                     list->capacity * sizeof(struct job));
+                assert(list->jobs != NULL);
+        }
+
+        struct job *job = &list->jobs[list->length++];
+        job->input = strdup(input);
+        assert(job->input != NULL);
+        job->output = NULL;
+        job->clash = NULL;
+}
+
+/******** readListFile ********
+ *
+ * Adds a job for every non-empty line of a file.
+ *
+ * Parameters:
+ *      struct jobList *list:   The list to grow
+ *      const char *path:       The file of input paths, "-" for stdin
+ * Returns:
+ *      Nothing.
+ * Notes:
+ *      Exits if the file cannot be opened, since no jobs would be known.
+ ************************/
+static void readListFile(struct jobList *list, const char *path)
+{
+        FILE *fp = strcmp(path, "-") == 0 ? stdin : fopen(path, "r");
+        if (fp == NULL) {
+                fprintf(stderr, "40image: %s: %s\n", path, strerror(errno));
+                exit(EXIT_FAILURE);
+        }
+
+        char *line = NULL;
+        size_t size = 0;
+        ssize_t length;
+        while ((length = getline(&line, &size, fp)) != -1) {
+                while (length > 0 && (line[length - 1] == '\n' ||
+                                      line[length - 1] == '\r')) {
+                        line[--length] = '\0';
+                }
+                if (length > 0) {
+                        addInput(list, line);
+                }
+        }
+        free(line);
+
+        if (fp != stdin) {
+                fclose(fp);
+        }
+}
+
+/******** readDirectory ********
+ *
+ * Adds a job for every input file in a directory: *.ppm and *.pnm files when
+ * compressing, *.c40 files when decompressing.
+ *
+ * Parameters:
+ *      struct jobList *list:   The list to grow
+ *      const char *dir:        The directory to scan (not recursively)
+ *      bool decompress:        Which extensions to pick up
+ * Returns:
+ *      Nothing.
+ * Notes:
+ *      Exits if the directory cannot be opened.
+ ************************/
+static void readDirectory(struct jobList *list, const char *dir,
+                          bool decompress)
+{
+        DIR *d = opendir(dir);
+        if (d == NULL) {
+                fprintf(stderr, "40image: %s: %s\n", dir, strerror(errno));
+                exit(EXIT_FAILURE);
+        }
+
+        struct dirent *entry;
+        while ((entry = readdir(d)) != NULL) {
+                if (entry->d_name[0] == '.' ||
+                    !hasExtension(entry->d_name, decompress)) {
+                        continue;
+                }
+                size_t length = strlen(dir) + strlen(entry->d_name) + 2;
+                char *path = malloc(length);
+                assert(path != NULL);
+                snprintf(path, length, "%s/%s", dir, entry->d_name);
+                addInput(list, path);
+                free(path);
+        }
+        closedir(d);
+}
+
+/******** hasExtension ********
+ *
+ * Returns true if a file name ends in an extension batch mode picks up from
+ * a directory.
+ ************************/
+static bool hasExtension(const char *name, bool decompress)
+{
+        const char *dot = strrchr(name, '.');
+        if (dot == NULL) {
+                return false;
+        }
+        if (decompress) {
+                return strcmp(dot, ".c40") == 0;
+        }
+        return strcmp(dot, ".ppm") == 0 || strcmp(dot, ".pnm") == 0;
+}
+
+/******** compareJobs ********
+ *
+ * qsort comparison that orders jobs by input path.
+ ************************/
+static int compareJobs(const void *a, const void *b)
+{
+        const struct job *jobA = a;
+        const struct job *jobB = b;
+        return strcmp(jobA->input, jobB->input);
+}
+
+/******** compareOutputs ********
+ *
+ * qsort comparison over pointers to jobs that orders them by output path,
+ * then by position in the job list.
+ ************************/
+static int compareOutputs(const void *a, const void *b)
+{
+        const struct job *jobA = *(const struct job * const *) a;
+        const struct job *jobB = *(const struct job * const *) b;
+        int order = strcmp(jobA->output, jobB->output);
+        if (order != 0) {
+                return order;
+        }
+        return (jobA > jobB) - (jobA < jobB);
+}
+
+/******** findClashes ********
+ *
+ * Marks every job whose output path an earlier job in the list already
+ * has, so that two workers never write the same file (e.g. x.ppm and
+ * x.pnm both becoming x.c40).
+ *
+ * Parameters:
+ *      struct jobList *list:   The jobs, with their outputs expanded
+ * Returns:
+ *      Nothing.
+ * Notes:
+ *      Paths are compared as strings, so "a/x.c40" and "./a/x.c40" are not
+ *        caught.
+ ************************/
+static void findClashes(struct jobList *list)
+{
+        if (list->length < 2) {
+                return;
+        }
+        struct job **byOutput = malloc(list->length * sizeof(struct job *));
+        assert(byOutput != NULL);
+        for (int i = 0; i < list->length; i++) {
+                byOutput[i] = &list->jobs[i];
+        }
+        qsort(byOutput, list->length, sizeof(struct job *), compareOutputs);
+
+        /* The first of each run of equal outputs is the earliest job */
+        for (int i = 1; i < list->length; i++) {
+                if (strcmp(byOutput[i]->output, byOutput[i - 1]->output) ==
+                    0) {
+                        byOutput[i]->clash = byOutput[i - 1]->clash != NULL ?
+                                             byOutput[i - 1]->clash :
+                                             byOutput[i - 1]->input;
+                }
+        }
+        free(byOutput);
+}
+
+/******** expandPattern ********
+ *
+ * Builds the output path for one input.
+ *
+ * Parameters:
+ *      const char *pattern:    The output pattern, e.g. "%d/%s.c40"
+ *      const char *input:      The input path
+ * Returns:
+ *      A newly allocated output path, which the caller must free.
+ * Notes:
+ *      %d is the input's directory ("." if it has none), %s is its file name
+ *        up to the last '.', and %% is '%'. Any other character, including
+ *        a '%' before anything else, is copied as is.
+ ************************/
+static char *expandPattern(const char *pattern, const char *input)
+{
+        const char *slash = strrchr(input, '/');
+        const char *dirStart = slash == NULL ? "." : input;
+        size_t dirLength = slash == NULL ? 1 : (size_t) (slash - input);
+        if (slash == input) {
+                dirLength = 1;  /* the input is in the root directory */
+        }
+
+        const char *stem = slash == NULL ? input : slash + 1;
+        const char *dot = strrchr(stem, '.');
+        size_t stemLength = (dot == NULL || dot == stem) ? strlen(stem) :
+                            (size_t) (dot - stem);
+
+        /* Every %d or %s may expand to the longer of the two */
+        size_t longest = dirLength > stemLength ? dirLength : stemLength;
+        size_t capacity = strlen(pattern) * (longest + 1) + 1;
+        char *output = malloc(capacity);
+        assert(output != NULL);
+
+        char *out = output;
+        for (const char *p = pattern; *p != '\0'; p++) {
+                if (p[0] == '%' && p[1] == 'd') {
+                        memcpy(out, dirStart, dirLength);
+                        out += dirLength;
+                        p++;
+                } else if (p[0] == '%' && p[1] == 's') {
+                        memcpy(out, stem, stemLength);
+                        out += stemLength;
+                        p++;
+                } else if (p[0] == '%' && p[1] == '%') {
+                        *out++ = '%';
+                        p++;
+                } else {
+                        *out++ = *p;
+                }
+        }
+        *out = '\0';
+
+        return output;
+}
+
+/******** runWorker ********
+ *
+ * Thread body: takes jobs from the shared list until none remain.
+ *
+ * Parameters:
+ *      void *cl:       The struct batchState shared by all workers
+ * Returns:
+ *      NULL.
+ * Notes:
+ *      The worker's buffers are allocated once and reused for every job it
+ *        runs.
+ ************************/
+static void *runWorker(void *cl)
+{
+        struct batchState *state = cl;
+        struct workerBuffers buffers = { NULL, NULL, NULL, 0, 0, 0, NULL, 0,
+                                         NULL };
+        buffers.stdioBuffer = malloc(IO_BUFFER_SIZE);
+        assert(buffers.stdioBuffer != NULL);
+
+        for (;;) {
+                pthread_mutex_lock(&state->lock);
+                int index = state->next++;
+                pthread_mutex_unlock(&state->lock);
+                if (index >= state->list->length) {
+                        break;
+                }
+
+                if (!runJob(&state->list->jobs[index], state->decompress,
+                            &buffers)) {
+                        pthread_mutex_lock(&state->lock);
+                        state->failures++;
+                        pthread_mutex_unlock(&state->lock);
+                }
+        }
+
+        free(buffers.in);
+        free(buffers.pixels);
+        free(buffers.out);
+        free(buffers.samples);
+        free(buffers.stdioBuffer);
+        return NULL;
+}
+
+/******** runJob ********
+ *
+ * Compresses or decompresses one input into its output file.
+ *
+ * Parameters:
+ *      struct job *job:                The input and output paths
+ *      bool decompress:                The direction to run the pipeline in
+ *      struct workerBuffers *buffers:  The worker's reusable buffers
+ * Returns:
+ *      true if the output was written, false (after printing why) if not.
+ * Notes:
+ *      The whole result is made in memory before the output is opened, so
+ *        a bad input leaves no output behind, and a partly written output
+ *        is removed.
+ *      Appends the checksum trailer (see checksum.h) to compressed outputs
+ *        if checksums are on.
+ ************************/
+static bool runJob(struct job *job, bool decompress,
+                   struct workerBuffers *buffers)
+{
+        if (job->clash != NULL) {
+                fprintf(stderr, "40image: %s: %s is also the output of %s\n",
+                        job->input, job->output, job->clash);
+                return false;
+        }
+        if (strcmp(job->input, job->output) == 0) {
+                fprintf(stderr, "40image: %s: output would overwrite input\n",
+                        job->input);
+                return false;
+        }
+
+        FILE *input = fopen(job->input, "rb");
+        if (input == NULL) {
+                fprintf(stderr, "40image: %s: %s\n", job->input,
+                        strerror(errno));
+                return false;
+        }
+        setvbuf(input, buffers->stdioBuffer, _IOFBF, IO_BUFFER_SIZE);
+
+        traceBegin(decompress ? "decompress job" : "compress job", "worker");
+        size_t outLength = 0;
+        unsigned width = 0, height = 0;
+        bool made = decompress ?
+                    decompressJob(input, job->input, buffers, &outLength,
+                                  &width, &height) :
+                    compressJob(input, job->input, buffers, &outLength,
+                                &width, &height);
+        traceEnd();
+        fclose(input);
+        if (!made) {
+                return false;
+        }
+
+        FILE *output = fopen(job->output, "wb");
+        if (output == NULL) {
+                fprintf(stderr, "40image: %s: %s\n", job->output,
+                        strerror(errno));
+                return false;
+        }
+        setvbuf(output, buffers->stdioBuffer, _IOFBF, IO_BUFFER_SIZE);
+
+        traceBegin("write output", "io");
+        bool written = fwrite(buffers->out, 1, outLength, output) ==
+                       outLength;
+        if (written && !decompress && checksumsEnabled()) {
+                written = writeTrailer(output, buffers->out, outLength,
+                                       width, height);
+        }
+        traceEnd();
+        if (fclose(output) != 0 || !written) {
+                fprintf(stderr, "40image: %s: write failed\n", job->output);
+                remove(job->output);
+                return false;
+        }
+        stageReport(stderr, width, height);
+        return true;
+}
+
+/******** compressJob ********
+ *
+ * Loads a PPM into the worker's pixel buffer and compresses it into its
+ * output buffer.
+ *
+ * Parameters:
+ *      FILE *input:                    The opened PPM, at its start
+ *      const char *path:               Its path, for messages
+ *      struct workerBuffers *buffers:  The worker's reusable buffers
+ *      size_t *outLength:              Where to store the compressed size
+ *      unsigned *width, *height:       Where to store the trimmed size
+ * Returns:
+ *      true with the compressed image in buffers->out, or false, after
+ *      printing why, if the input is not a complete PPM, has a sample above
+ *      its maxval, or is too small or too large to compress.
+ ************************/
+static bool compressJob(FILE *input, const char *path,
+                        struct workerBuffers *buffers, size_t *outLength,
+                        unsigned *width, unsigned *height)
+{
+        struct ppmStream *stream = ppmStreamOpen(input);
+        if (stream == NULL) {
+                fprintf(stderr, "40image: %s: not a PPM image\n", path);
+                return false;
+        }
+        unsigned w = stream->width;
+        unsigned h = stream->height;
+        unsigned denominator = stream->denominator;
+        if (w < BLOCKSIZE || h < BLOCKSIZE || w > INT_MAX || h > INT_MAX) {
+                fprintf(stderr, "40image: %s: cannot compress a %ux%u "
+                        "image\n", path, w, h);
+                ppmStreamClose(&stream);
+                return false;
+        }
+
+        size_t bytesPerSample = denominator < 256 ? 1 : 2;
+        size_t count = (size_t) 3 * w;
+        size_t stride = count * bytesPerSample;
+        buffers->samples = ensureCapacity(buffers->samples,
+                                          &buffers->samplesCapacity,
+                                          count * sizeof(unsigned));
+        buffers->pixels = ensureCapacity(buffers->pixels,
+                                         &buffers->pixelsCapacity,
+                                         stride * h);
+
+        /* Load the raster as compress40_mem reads it, checking each sample
+         * so that nothing malformed reaches the pipeline */
+        const unsigned *samples = buffers->samples;
+        for (unsigned row = 0; row < h; row++) {
+                if (!ppmStreamReadRow(stream, buffers->samples)) {
+                        fprintf(stderr, "40image: %s: truncated at row %u\n",
+                                path, row);
+                        ppmStreamClose(&stream);
+                        return false;
+                }
+                unsigned char *dest = buffers->pixels + row * stride;
+                for (size_t k = 0; k < count; k++) {
+                        if (samples[k] > denominator) {
+                                fprintf(stderr, "40image: %s: sample above "
+                                        "maxval %u at row %u\n", path,
+                                        denominator, row);
+                                ppmStreamClose(&stream);
+                                return false;
+                        }
+                        if (bytesPerSample == 1) {
+                                dest[k] = samples[k];
+                        } else {
+                                dest[2 * k] = samples[k] >> 8;
+                                dest[2 * k + 1] = samples[k] & 0xff;
+                        }
+                }
+        }
+        ppmStreamClose(&stream);
+
+        buffers->out = ensureCapacity(buffers->out, &buffers->outCapacity,
+                                      compress40_bound(w, h));
+        *outLength = compress40_mem(buffers->pixels, w, h, stride,
+                                    denominator, &buffers->out,
+                                    buffers->outCapacity);
+        assert(*outLength > 0);
+        *width = w / BLOCKSIZE * BLOCKSIZE;
+        *height = h / BLOCKSIZE * BLOCKSIZE;
+        return true;
+}
+
+/******** decompressJob ********
+ *
+ * Reads a compressed image into the worker's input buffer and decodes it
+ * into its output buffer as a PPM.
+ *
+ * Parameters:
+ *      FILE *input:                    The opened compressed image
+ *      const char *path:               Its path, for messages
+ *      struct workerBuffers *buffers:  The worker's reusable buffers
+ *      size_t *outLength:              Where to store the PPM's size
+ *      unsigned *width, *height:       Where to store the image's size
+ * Returns:
+ *      true with the PPM in buffers->out, or false, after printing why, if
+ *      the input cannot be read, is not a format 2 image or is truncated.
+ * Notes:
+ *      The PPM is byte for byte what decompress40_to writes.
+ ************************/
+static bool decompressJob(FILE *input, const char *path,
+                          struct workerBuffers *buffers, size_t *outLength,
+                          unsigned *width, unsigned *height)
+{
+        size_t length = 0;
+        size_t read;
+        do {
+                buffers->in = ensureCapacity(buffers->in,
+                                             &buffers->inCapacity,
+                                             length + IO_BUFFER_SIZE);
+                read = fread(buffers->in + length, 1,
+                             buffers->inCapacity - length, input);
+                length += read;
+        } while (read > 0);
+        if (ferror(input)) {
+                fprintf(stderr, "40image: %s: %s\n", path, strerror(errno));
+                return false;
+        }
+
+        unsigned w, h;
+        if (!decompress40_info(buffers->in, length, &w, &h) || w == 0 ||
+            h == 0 || w % BLOCKSIZE != 0 || h % BLOCKSIZE != 0) {
+                fprintf(stderr, "40image: %s: not a compressed image\n",
+                        path);
+                return false;
+        }
+
+        /* Every 2x2 block takes BYTES_PER_WORD bytes; checked before the
+         * output is sized so a bad header cannot ask for a huge buffer */
+        uint64_t needed = (uint64_t) (w / BLOCKSIZE) * (h / BLOCKSIZE) *
+                          BYTES_PER_WORD;
+        if (needed > length) {
+                fprintf(stderr, "40image: %s: truncated (%zu of at least "
+                        "%llu bytes)\n", path, length,
+                        (unsigned long long) needed);
+                return false;
+        }
+
+        char header[64];
+        size_t headerLength = snprintf(header, sizeof(header),
+                                       "P6\n%u %u\n255\n", w, h);
+        size_t stride = (size_t) w * 3;
+        buffers->out = ensureCapacity(buffers->out, &buffers->outCapacity,
+                                      headerLength + stride * h);
+        memcpy(buffers->out, header, headerLength);
+
+        unsigned char *pixels = buffers->out + headerLength;
+        if (!decompress40_mem(buffers->in, length, &pixels, stride)) {
+                fprintf(stderr, "40image: %s: truncated\n", path);
+                return false;
+        }
+
+        *outLength = headerLength + stride * h;
+        *width = w;
+        *height = h;
+        return true;
+}
+
+/******** writeTrailer ********
+ *
+ * Writes the checksum trailer for a compressed image held in memory, with
+ * the same band CRCs printWords computes as it writes.
+ *
+ * Parameters:
+ *      FILE *output:                   Where the image was just written
+ *      const unsigned char *compressed:        The image, header included
+ *      size_t length:                  Its size in bytes
+ *      unsigned width, height:         Its dimensions
+ * Returns:
+ *      true if the trailer was written without error.
+ ************************/
+static bool writeTrailer(FILE *output, const unsigned char *compressed,
+                         size_t length, unsigned width, unsigned height)
+{
+        size_t rowBytes = (size_t) (width / BLOCKSIZE) * BYTES_PER_WORD;
+        int blocksHigh = height / BLOCKSIZE;
+        const unsigned char *words = compressed + length -
+                                     rowBytes * blocksHigh;
+
+        int numBands = (blocksHigh + CHECKSUM_BAND_ROWS - 1) /
+                       CHECKSUM_BAND_ROWS;
+        uint32_t *crcs = malloc(numBands * sizeof(uint32_t) + 1);
+        assert(crcs != NULL);
+        for (int band = 0; band < numBands; band++) {
+                int rows = blocksHigh - band * CHECKSUM_BAND_ROWS;
+                if (rows > CHECKSUM_BAND_ROWS) {
+                        rows = CHECKSUM_BAND_ROWS;
+                }
+                crcs[band] = crc32c(0, words + (size_t) band *
+                                       CHECKSUM_BAND_ROWS * rowBytes,
+                                    rows * rowBytes);
+        }
+        writeChecksumTrailer(output, crcs, numBands);
+        free(crcs);
+        return !ferror(output);
+}
+
+/******** ensureCapacity ********
+ *
+ * Grows a worker buffer to hold at least needed bytes (never shrinking it)
+ * and returns it, possibly moved.
+ ************************/
+static void *ensureCapacity(void *buffer, size_t *capacity, size_t needed)
+{
+        if (needed <= *capacity && buffer != NULL) {
+                return buffer;
+        }
+        size_t size = *capacity * 2 > needed ? *capacity * 2 : needed;
+        buffer = realloc(buffer, size + 1);
+        assert(buffer != NULL);
+        *capacity = size;
+        return buffer;
+}
@@ -0,0 +1,41 @@
+/*
+ *      batch40.h
+ *      Kevin Lu (klu07), Justin Paik (jpaik03)
+ *      October 18, 2026
+ *      arith
+ *
+ *      Interface for batch mode. Compresses or decompresses many files in one
+ *      process, on a pool of worker threads. Inputs come from the command
+ *      line, from a file listing one path per line, and/or from a directory.
+ *      Each output is named by expanding a pattern in which %d is the input's
+ *      directory, %s is its file name without the extension, and %% is a
+ *      literal '%'.
+ */
+
+#include <stdbool.h>
+
+/******** batchOptions struct ********
+ *
+ * What a batch should process and how, as given on the command line.
+ *
+ * Fields:
+ *      bool decompress:        -d rather than -c
+ *      int numWorkers:         Threads to run, 0 for one per CPU
+ *      const char *listFile:   File of input paths, or NULL
+ *      const char *dir:        Directory of inputs, or NULL
+ *      const char *outPattern: Output name pattern, or NULL for the default
+ *      char **paths:           Inputs named on the command line
+ *      int numPaths:           How many paths there are
+ ************************/
+struct batchOptions
+{
+        bool decompress;
+        int numWorkers;
+        const char *listFile;
+        const char *dir;
+        const char *outPattern;
+        char **paths;
+        int numPaths;
+};
+
+int batch40(struct batchOptions *options);
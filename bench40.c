@@ -0,0 +1,482 @@
+/*
+ *      bench40.c
+ *      Kevin Lu (klu07), Justin Paik (jpaik03)
+ *      October 18, 2026
+ *      arith
+ *
+ *      End-to-end benchmark for the compression pipeline. Runs compress40's
+ *      and decompress40's steps one at a time over synthetic images of
+ *      several sizes and reports, for every stage, the time per pixel, the
+ *      throughput in MB of raw RGB image data per second, and the peak
+ *      resident set size. Results are printed as text on stdout and may also
+ *      be written as JSON.
+ *
+ *      Usage: bench40 [--sizes WxH,WxH,...] [--reps N] [--json FILE]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <time.h>
+#include <sys/resource.h>
+
+#include "a2methods.h"
+#include "a2plain.h"
+#include "a2blocked.h"
+#include "readWriteImage.h"
+#include "pixelOperation.h"
+#include "blockOperation.h"
+#include "codewords.h"
+#include "tableDecode.h"
+
+#define MAX_SIZES 16
+#define MAX_STAGES 16
+#define DEFAULT_REPS 3
+
+/******** stageResult struct ********
+ *
+ * Measurements for one pipeline stage at one image size.
+ *
+ * Fields:
+ *      const char *name:       The stage's function name
+ *      const char *direction:  "compress" or "decompress"
+ *      double seconds:         Best wall time over all repetitions
+ *      long peakKB:            Largest peak RSS seen during the stage
+ ************************/
+struct stageResult
+{
+        const char *name;
+        const char *direction;
+        double seconds;
+        long peakKB;
+};
+
+/******** sizeResult struct ********
+ *
+ * All stage measurements for one image size.
+ *
+ * Fields:
+ *      unsigned width, height: Dimensions of the synthetic image
+ *      int numStages:          Number of filled entries in stages
+ *      struct stageResult stages[]: Per-stage measurements, in pipeline order
+ ************************/
+struct sizeResult
+{
+        unsigned width, height;
+        int numStages;
+        struct stageResult stages[MAX_STAGES];
+};
+
+/* Initialize helper functions, see function contracts below */
+static int parseSizes(const char *spec, unsigned *widths, unsigned *heights);
+static FILE *makeImage(unsigned width, unsigned height);
+static void runPipeline(FILE *ppm, struct sizeResult *result, int first);
+static void beginStage(void);
+static void endStage(struct sizeResult *result, int index, const char *name,
+                     const char *direction, int first);
+static double now(void);
+static long peakRSS(void);
+static void resetPeakRSS(void);
+static void printText(FILE *out, struct sizeResult *results, int numSizes);
+static void printJSON(FILE *out, struct sizeResult *results, int numSizes);
+
+/* Start time of the stage currently being measured */
+static double stageStart;
+
+int main(int argc, char *argv[])
+{
+        unsigned widths[MAX_SIZES] = { 256, 1024, 2048, 4096 };
+        unsigned heights[MAX_SIZES] = { 256, 768, 2048, 4096 };
+        int numSizes = 4;
+        int reps = DEFAULT_REPS;
+        const char *jsonPath = NULL;
+
+        for (int i = 1; i < argc; i++) {
+                if (strcmp(argv[i], "--sizes") == 0 && i + 1 < argc) {
+                        numSizes = parseSizes(argv[++i], widths, heights);
+                        if (numSizes == 0) {
+                                fprintf(stderr, "%s: --sizes expects 1 to %d "
+                                        "sizes WxH,WxH,... of at least "
+                                        "2x2\n", argv[0], MAX_SIZES);
+                                exit(1);
+                        }
+                } else if (strcmp(argv[i], "--reps") == 0 && i + 1 < argc) {
+                        reps = atoi(argv[++i]);
+                } else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+                        jsonPath = argv[++i];
+                } else {
+                        fprintf(stderr, "Usage: %s [--sizes WxH,...] "
+                                "[--reps N] [--json FILE]\n", argv[0]);
+                        exit(1);
+                }
+        }
+        if (numSizes <= 0 || reps <= 0) {
+                fprintf(stderr, "%s: need at least one size and one rep\n",
+                        argv[0]);
+                exit(1);
+        }
+
+        struct sizeResult *results = calloc(numSizes, sizeof(*results));
+        assert(results != NULL);
+
+        for (int s = 0; s < numSizes; s++) {
+                FILE *ppm = makeImage(widths[s], heights[s]);
+                for (int rep = 0; rep < reps; rep++) {
+                        rewind(ppm);
+                        runPipeline(ppm, &results[s], rep == 0);
+                }
+                fclose(ppm);
+        }
+
+        printText(stdout, results, numSizes);
+        if (jsonPath != NULL) {
+                FILE *json = fopen(jsonPath, "w");
+                assert(json != NULL);
+                printJSON(json, results, numSizes);
+                fclose(json);
+        }
+
+        free(results);
+        return EXIT_SUCCESS;
+}
+
+/******** parseSizes ********
+ *
+ * Parses a comma-separated list of WxH image sizes.
+ *
+ * Parameters:
+ *      const char *spec:       The list, e.g. "640x480,4096x4096"
+ *      unsigned *widths:       Array of MAX_SIZES to store widths in
+ *      unsigned *heights:      Array of MAX_SIZES to store heights in
+ * Returns:
+ *      The number of sizes parsed, or 0 if spec is malformed or lists more
+ *      than MAX_SIZES sizes.
+ * Expects:
+ *      All parameters are not NULL.
+ ************************/
+static int parseSizes(const char *spec, unsigned *widths, unsigned *heights)
+{
+        assert(spec != NULL);
+        assert(widths != NULL && heights != NULL);
+
+        int n = 0;
+        while (*spec != '\0') {
+                if (n == MAX_SIZES) {
+                        return 0;
+                }
+                int used;
+                if (sscanf(spec, "%ux%u%n", &widths[n], &heights[n],
+                           &used) != 2 || widths[n] < 2 || heights[n] < 2) {
+                        return 0;
+                }
+                n++;
+                spec += used;
+                if (*spec == ',') {
+                        spec++;
+                }
+        }
+        return n;
+}
+
+/******** makeImage ********
+ *
+ * Writes a deterministic synthetic PPM (smooth gradients plus noise, so that
+ * every quantizer range gets exercised) to a temporary file.
+ *
+ * Parameters:
+ *      unsigned width, height: Dimensions of the image
+ * Returns:
+ *      A temporary file holding the PPM, which the caller must fclose.
+ * Expects:
+ *      width and height are positive.
+ ************************/
+static FILE *makeImage(unsigned width, unsigned height)
+{
+        FILE *ppm = tmpfile();
+        assert(ppm != NULL);
+
+        fprintf(ppm, "P6\n%u %u\n255\n", width, height);
+
+        unsigned seed = 40;
+        for (unsigned row = 0; row < height; row++) {
+                for (unsigned col = 0; col < width; col++) {
+                        seed = seed * 1103515245 + 12345;
+                        unsigned noise = (seed >> 16) & 0x1F;
+                        putc((col * 255 / width + noise) & 0xFF, ppm);
+                        putc((row * 255 / height + noise) & 0xFF, ppm);
+                        putc(((col + row) / 2 + noise) & 0xFF, ppm);
+                }
+        }
+
+        return ppm;
+}
+
+/******** runPipeline ********
+ *
+ * Runs every compression step on the image in ppm, then every decompression
+ * step on the result, timing each step separately.
+ *
+ * Parameters:
+ *      FILE *ppm:                      The source image, positioned at start
+ *      struct sizeResult *result:      Where the measurements are recorded
+ *      int first:                      Nonzero on the first repetition
+ * Returns:
+ *      Nothing.
+ * Expects:
+ *      ppm and result are not NULL.
+ * Notes:
+ *      printWords writes to a temporary file and writeImage to /dev/null.
+ ************************/
+static void runPipeline(FILE *ppm, struct sizeResult *result, int first)
+{
+        assert(ppm != NULL);
+        assert(result != NULL);
+
+        A2Methods_T bMethods = uarray2_methods_blocked;
+        A2Methods_T pMethods = uarray2_methods_plain;
+        int stage = 0;
+
+        /* Compression, steps C1 to C4 */
+        beginStage();
+        Pnm_ppm img = readImage(ppm);
+        endStage(result, stage++, "readImage", "compress", first);
+        result->width = img->width;
+        result->height = img->height;
+
+        beginStage();
+        UArray2b_T RGBCompVid = getRGBCompVid(img, bMethods);
+        endStage(result, stage++, "getRGBCompVid", "compress", first);
+        img->methods->free(&(img->pixels));
+        free(img);
+
+        beginStage();
+        UArray2_T DCTSpace = pixelsToDCTBlock(RGBCompVid, bMethods, pMethods);
+        endStage(result, stage++, "pixelsToDCTBlock", "compress", first);
+        bMethods->free((A2Methods_UArray2 *) &RGBCompVid);
+
+        beginStage();
+        UArray2_T quantInts = quantizeValues(DCTSpace, pMethods,
+                                            &DEFAULT_SCALES);
+        endStage(result, stage++, "quantizeValues", "compress", first);
+        pMethods->free((A2Methods_UArray2 *) &DCTSpace);
+
+        FILE *compressed = tmpfile();
+        assert(compressed != NULL);
+        beginStage();
+        bool written = printWords(compressed, quantInts, pMethods,
+                                  &DEFAULT_SCALES);
+        assert(written && fflush(compressed) == 0);
+        endStage(result, stage++, "printWords", "compress", first);
+        pMethods->free((A2Methods_UArray2 *) &quantInts);
+
+        /* Decompression, steps (C4)' to (C1)' */
+        rewind(compressed);
+        unsigned width, height;
+        struct quantScales scales;
+        beginStage();
+        readCompressedHeader(compressed, &width, &height, &scales);
+        quantInts = readWords(compressed, pMethods, width, height);
+        endStage(result, stage++, "readWords", "decompress", first);
+        fclose(compressed);
+
+        beginStage();
+        Pnm_ppm tableImg = tableDecode(quantInts, pMethods, &scales);
+        endStage(result, stage++, "tableDecode", "decompress", first);
+        tableImg->methods->free(&(tableImg->pixels));
+        free(tableImg);
+
+        beginStage();
+        UArray2_T dequantFloats = dequantizeValues(quantInts, pMethods,
+                                                    &scales);
+        endStage(result, stage++, "dequantizeValues", "decompress", first);
+        pMethods->free((A2Methods_UArray2 *) &quantInts);
+
+        beginStage();
+        UArray2b_T deRGBCompVid = DCTBlockToPixels(dequantFloats, pMethods,
+                                                   bMethods);
+        endStage(result, stage++, "DCTBlockToPixels", "decompress", first);
+        pMethods->free((A2Methods_UArray2 *) &dequantFloats);
+
+        beginStage();
+        Pnm_ppm newImg = getRGBInts(deRGBCompVid, bMethods);
+        endStage(result, stage++, "getRGBInts", "decompress", first);
+        bMethods->free((A2Methods_UArray2 *) &deRGBCompVid);
+
+        FILE *devNull = fopen("/dev/null", "w");
+        assert(devNull != NULL);
+        beginStage();
+        writeImage(devNull, newImg);
+        fflush(devNull);
+        endStage(result, stage++, "writeImage", "decompress", first);
+        fclose(devNull);
+        newImg->methods->free(&(newImg->pixels));
+        free(newImg);
+
+        result->numStages = stage;
+}
+
+/******** beginStage ********
+ *
+ * Resets the peak RSS counter and starts the stage clock.
+ ************************/
+static void beginStage(void)
+{
+        resetPeakRSS();
+        stageStart = now();
+}
+
+/******** endStage ********
+ *
+ * Stops the stage clock and folds the measurement into result.
+ *
+ * Parameters:
+ *      struct sizeResult *result:      The size being measured
+ *      int index:                      Position of the stage in the pipeline
+ *      const char *name:               The stage's name
+ *      const char *direction:          "compress" or "decompress"
+ *      int first:                      Nonzero on the first repetition
+ * Returns:
+ *      Nothing.
+ * Expects:
+ *      result is not NULL and index < MAX_STAGES.
+ * Notes:
+ *      Keeps the fastest time and the largest peak RSS over repetitions.
+ ************************/
+static void endStage(struct sizeResult *result, int index, const char *name,
+                     const char *direction, int first)
+{
+        double elapsed = now() - stageStart;
+        long peak = peakRSS();
+
+        assert(result != NULL);
+        assert(index < MAX_STAGES);
+
+        struct stageResult *stage = &result->stages[index];
+        if (first || elapsed < stage->seconds) {
+                stage->seconds = elapsed;
+        }
+        if (first || peak > stage->peakKB) {
+                stage->peakKB = peak;
+        }
+        stage->name = name;
+        stage->direction = direction;
+}
+
+/******** now ********
+ *
+ * Returns the monotonic wall clock time in seconds.
+ ************************/
+static double now(void)
+{
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/******** peakRSS ********
+ *
+ * Returns the peak resident set size in kilobytes. Reads VmHWM, which
+ * resetPeakRSS can lower, and falls back on getrusage otherwise.
+ ************************/
+static long peakRSS(void)
+{
+        FILE *status = fopen("/proc/self/status", "r");
+        if (status != NULL) {
+                char line[256];
+                long kb = -1;
+                while (fgets(line, sizeof(line), status) != NULL) {
+                        if (sscanf(line, "VmHWM: %ld kB", &kb) == 1) {
+                                break;
+                        }
+                }
+                fclose(status);
+                if (kb >= 0) {
+                        return kb;
+                }
+        }
+
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+        return usage.ru_maxrss;
+}
+
+/******** resetPeakRSS ********
+ *
+ * Resets the kernel's peak RSS counter to the current RSS so that the next
+ * peakRSS reading covers only the following stage. Does nothing where
+ * /proc/self/clear_refs is unavailable.
+ ************************/
+static void resetPeakRSS(void)
+{
+        FILE *clear = fopen("/proc/self/clear_refs", "w");
+        if (clear != NULL) {
+                fputs("5", clear);
+                fclose(clear);
+        }
+}
+
+/******** printText ********
+ *
+ * Prints one table per image size with ns/pixel, MB/s, and peak RSS for
+ * every stage.
+ *
+ * Parameters:
+ *      FILE *out:                      Where to print
+ *      struct sizeResult *results:     The measurements
+ *      int numSizes:                   Number of entries in results
+ ************************/
+static void printText(FILE *out, struct sizeResult *results, int numSizes)
+{
+        for (int s = 0; s < numSizes; s++) {
+                struct sizeResult *r = &results[s];
+                double pixels = (double) r->width * r->height;
+
+                fprintf(out, "%ux%u (%.0f pixels)\n", r->width, r->height,
+                        pixels);
+                fprintf(out, "  %-11s %-17s %10s %10s %12s\n", "direction",
+                        "stage", "ns/pixel", "MB/s", "peak RSS kB");
+                for (int i = 0; i < r->numStages; i++) {
+                        struct stageResult *st = &r->stages[i];
+                        fprintf(out, "  %-11s %-17s %10.2f %10.1f %12ld\n",
+                                st->direction, st->name,
+                                st->seconds * 1e9 / pixels,
+                                pixels * 3 / 1e6 / st->seconds, st->peakKB);
+                }
+                fprintf(out, "\n");
+        }
+}
+
+/******** printJSON ********
+ *
+ * Prints the same measurements as printText as a JSON document.
+ *
+ * Parameters:
+ *      FILE *out:                      Where to print
+ *      struct sizeResult *results:     The measurements
+ *      int numSizes:                   Number of entries in results
+ ************************/
+static void printJSON(FILE *out, struct sizeResult *results, int numSizes)
+{
+        fprintf(out, "{\"sizes\": [");
+        for (int s = 0; s < numSizes; s++) {
+                struct sizeResult *r = &results[s];
+                double pixels = (double) r->width * r->height;
+
+                fprintf(out, "%s\n  {\"width\": %u, \"height\": %u, "
+                        "\"pixels\": %.0f, \"stages\": [", s ? "," : "",
+                        r->width, r->height, pixels);
+                for (int i = 0; i < r->numStages; i++) {
+                        struct stageResult *st = &r->stages[i];
+                        fprintf(out, "%s\n    {\"direction\": \"%s\", "
+                                "\"stage\": \"%s\", \"seconds\": %.9f, "
+                                "\"ns_per_pixel\": %.3f, \"mb_per_s\": %.3f, "
+                                "\"peak_rss_kb\": %ld}", i ? "," : "",
+                                st->direction, st->name, st->seconds,
+                                st->seconds * 1e9 / pixels,
+                                pixels * 3 / 1e6 / st->seconds, st->peakKB);
+                }
+                fprintf(out, "\n  ]}");
+        }
+        fprintf(out, "\n]}\n");
+}
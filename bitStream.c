@@ -0,0 +1,96 @@
+/*
+ *      bitStream.c
+ *      Kevin Lu (klu07), Justin Paik (jpaik03)
+ *      October 18, 2026
+ *      arith
+ *
+ *      Implementation of bit streams. Writing keeps fewer than 8 bits
+ *      buffered between calls, and reading takes whole bytes only when the
+ *      buffered bits run out, so each byte is touched once.
+ */
+
+#include <assert.h>
+
+#include "bitStream.h"
+
+/******** putBits ********
+ *
+ * Appends the low width bits of value to a stream, writing each byte as
+ * it fills.
+ *
+ * Parameters:
+ *      struct bitStream *stream:       The stream to write to
+ *      uint64_t value:                 The field; higher bits must be 0
+ *      int width:                      Number of bits, at most 32
+ * Returns:
+ *      Nothing.
+ ************************/
+void putBits(struct bitStream *stream, uint64_t value, int width)
+{
+        assert(stream != NULL);
+        assert(width >= 0 && width <= 32);
+
+        stream->buffer = (stream->buffer << width) | value;
+        stream->count += width;
+        while (stream->count >= 8) {
+                stream->count -= 8;
+                putc((stream->buffer >> stream->count) & 0xFF, stream->file);
+        }
+}
+
+/******** flushBits ********
+ *
+ * Writes any bits left in a stream, padded with zeros to a whole byte.
+ ************************/
+void flushBits(struct bitStream *stream)
+{
+        assert(stream != NULL);
+
+        if (stream->count > 0) {
+                putc((stream->buffer << (8 - stream->count)) & 0xFF,
+                     stream->file);
+                stream->count = 0;
+        }
+}
+
+/******** getBits ********
+ *
+ * Takes the next width bits from a stream.
+ *
+ * Parameters:
+ *      struct bitStream *stream:       The stream to read from
+ *      int width:                      Number of bits, at most 32
+ *      uint64_t *value:                Where to store them
+ * Returns:
+ *      false if the stream ends first, otherwise true with the bits in
+ *      *value.
+ ************************/
+bool getBits(struct bitStream *stream, int width, uint64_t *value)
+{
+        assert(stream != NULL && value != NULL);
+        assert(width >= 0 && width <= 32);
+
+        while (stream->count < width) {
+                int c = getc(stream->file);
+                if (c == EOF) {
+                        return false;
+                }
+                stream->buffer = (stream->buffer << 8) | c;
+                stream->count += 8;
+        }
+        stream->count -= width;
+        *value = (stream->buffer >> stream->count) &
+                 (((uint64_t) 1 << width) - 1);
+        return true;
+}
+
+/******** alignBits ********
+ *
+ * Drops the padding bits after the last field read, so the next field
+ * starts at a byte boundary.
+ ************************/
+void alignBits(struct bitStream *stream)
+{
+        assert(stream != NULL);
+        stream->count = 0;
+}
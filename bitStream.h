@@ -0,0 +1,39 @@
+/*
+ *      bitStream.h
+ *      Kevin Lu (klu07), Justin Paik (jpaik03)
+ *      October 18, 2026
+ *      arith
+ *
+ *      Interface for reading and writing fields of any width up to 32 bits
+ *      over a byte stream, most significant bit first, as the bit-packed
+ *      compressed formats (see progressive.h and planar.h) store them.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+/******** bitStream struct ********
+ *
+ * A stream of bits over a byte stream. Start one as { file, 0, 0 }.
+ *
+ * Fields:
+ *      FILE *file:             The byte stream
+ *      uint64_t buffer:        Bits not yet written, or read but not used
+ *      int count:              Number of such bits (the low count bits of
+ *                                buffer)
+ ************************/
+struct bitStream
+{
+        FILE *file;
+        uint64_t buffer;
+        int count;
+};
+
+/* Writing */
+void putBits(struct bitStream *stream, uint64_t value, int width);
+void flushBits(struct bitStream *stream);
+
+/* Reading */
+bool getBits(struct bitStream *stream, int width, uint64_t *value);
+void alignBits(struct bitStream *stream);
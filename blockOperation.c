@@ -20,6 +20,10 @@
 #include "arith40.h"
 
 #define BLOCKSIZE 2
+#define SAMPLE_BLOCKS 4096
+#define A_SYMBOLS 512
+#define BCD_SYMBOLS 31
+#define CHROMA_SYMBOLS 16
 
 /* Initialize helper functions, see function contracts below */
 static void applyCompVidToDCT(int col, int row, A2Methods_UArray2 pixels, 
@@ -28,10 +32,26 @@ static void applyDCTToPixel(int col, int row, A2Methods_UArray2 pixels,
                             void *elem, void *cl);
 static void applyQuantize(int col, int row, A2Methods_UArray2 pixels,
                           void *elem, void *cl);
-static int quantizeBCD(float coefficient);
+static int quantizeBCD(float coefficient, const struct quantScales *scales);
 static void applyDequantize(int col, int row, A2Methods_UArray2 pixels, 
                             void *elem, void *cl);
-static float dequantizeBCD(int quantizedCoeff);
+static float dequantizeBCD(int quantizedCoeff,
+                           const struct quantScales *scales);
+static double entropyBits(const unsigned *counts, int numSymbols,
+                          unsigned total);
+static void applyToPlanes(int col, int row, A2Methods_UArray2 quantInts,
+                          void *elem, void *cl);
+static void applyFromPlanes(int col, int row, A2Methods_UArray2 quantInts,
+                            void *elem, void *cl);
+
+const struct quantScales DEFAULT_SCALES = { 511, 50, 15 };
+
+/* The scales chooseScales tries, finest first */
+static const unsigned aCandidates[] = { 511, 383, 255, 191, 127, 95, 63, 47,
+                                        31 };
+static const unsigned bcdCandidates[] = { 140, 100, 70, 50, 35, 25, 18, 12 };
+#define NUM_A_CANDIDATES (sizeof(aCandidates) / sizeof(aCandidates[0]))
+#define NUM_BCD_CANDIDATES (sizeof(bcdCandidates) / sizeof(bcdCandidates[0]))
 
 /******** DCTVals struct ********
  *
@@ -95,12 +115,14 @@ struct applyDCTToPixelClosure
  *      UArray2_T quantInts:    The destination array for quantized integers
  *      A2Methods_T methods:    The method suite for array operations
  *      UArray2_T DCTSpace:     The source array of floating-point DCT data
+ *      const struct quantScales *scales:       The quantizer's scales
  ************************/
 struct applyQuantizeClosure
 {
         UArray2_T quantInts;
         A2Methods_T methods;
         UArray2_T DCTSpace;
+        const struct quantScales *scales;
 };
 
 /******** applyDequantizeClosure struct ********
@@ -113,12 +135,15 @@ struct applyQuantizeClosure
  *                                        floats
  *      A2Methods_T methods:            The method suite for array operations
  *      UArray2_T DCTSpace:             The source array of quantized int data
+ *      const struct quantScales *scales:       The scales it was quantized
+ *                                                with
  ************************/
 struct applyDequantizeClosure
 {
         UArray2_T dequantFloats;
         A2Methods_T methods;
         UArray2_T DCTSpace;
+        const struct quantScales *scales;
 };
 
 /******** pixelsToDCTBlock ********
@@ -251,17 +276,20 @@ static void applyCompVidToDCT(int col, int row, A2Methods_UArray2 pixels,
  * Parameters:
  *      UArray2_T DCTSpace:     An array where each element is a DCTVals struct
  *      A2Methods_T methods:    The method suite to use
+ *      const struct quantScales *scales:       The scales to quantize with
  * Returns:
  *      A UArray2_T where each element is a quantized struct.
  * Expects:
- *      DCTSpace and methods are not NULL.
+ *      DCTSpace, methods and scales are not NULL, and scales are valid.
  * Notes:
  *      Allocates memory for the returned UArray2_T, which the caller must free.
  ************************/
-UArray2_T quantizeValues(UArray2_T DCTSpace, A2Methods_T methods)
+UArray2_T quantizeValues(UArray2_T DCTSpace, A2Methods_T methods,
+                         const struct quantScales *scales)
 {
         assert(DCTSpace != NULL);
         assert(methods != NULL);
+        assert(validScales(scales));
 
         A2Methods_mapfun *map = methods->map_default;
         assert(map != NULL);
@@ -272,7 +300,8 @@ UArray2_T quantizeValues(UArray2_T DCTSpace, A2Methods_T methods)
                                            sizeof(struct quantized));
         assert(quantInts != NULL);
 
-        struct applyQuantizeClosure closure = {quantInts, methods, DCTSpace};
+        struct applyQuantizeClosure closure = {quantInts, methods, DCTSpace,
+                                               scales};
 
         map(DCTSpace, applyQuantize, &closure);
         
@@ -316,13 +345,15 @@ static void applyQuantize(int col, int row, A2Methods_UArray2 pixels,
         struct DCTVals *srcDCT = closure->methods->at(closure->DCTSpace,
                                                       col, row);
 
+        const struct quantScales *scales = closure->scales;
+
         /* Quantize DCT coefficient 'a' to a 9-bit unsigned integer */
-        unsigned a = (unsigned) round(srcDCT->a * 511);
+        unsigned a = (unsigned) round(srcDCT->a * scales->a);
 
         /* Quantize coefficients 'b', 'c', and 'd' to 5-bit signed integers */
-        int b = quantizeBCD(srcDCT->b);
-        int c = quantizeBCD(srcDCT->c);
-        int d = quantizeBCD(srcDCT->d);
+        int b = quantizeBCD(srcDCT->b, scales);
+        int c = quantizeBCD(srcDCT->c, scales);
+        int d = quantizeBCD(srcDCT->d, scales);
 
         /* Quantize chroma values to 4-bit indices */
         unsigned indexbpb = Arith40_index_of_chroma(srcDCT->bpb);
@@ -337,25 +368,260 @@ static void applyQuantize(int col, int row, A2Methods_UArray2 pixels,
 /******** quantizeBCD ********
  *
  * Helper to quantize a single b, c, or d coefficient. Forces the float value to
- * the range [-0.3, 0.3] and then scales it to a 5-bit signed integer in the
- * range [-15, 15].
+ * the range [-bcdMax / bcd, bcdMax / bcd] ([-0.3, 0.3] by default) and then
+ * scales it to a 5-bit signed integer in the range [-bcdMax, bcdMax].
  *
  * Parameters:
- *      float coefficient:      The floating-point coefficient to quantize
+ *      float coefficient:                      The coefficient to quantize
+ *      const struct quantScales *scales:       The quantizer's scales
  * Returns:
- *      An integer in the range [-15, 15].
+ *      An integer in the range [-bcdMax, bcdMax].
  * Expects:
- *      Nothing.
- * Notes:
- *      Forces the float to the range [-0.3, 0.3].
+ *      scales is not NULL.
  ************************/
-static int quantizeBCD(float coefficient)
+static int quantizeBCD(float coefficient, const struct quantScales *scales)
 {
         /* Force the float value to the specified range */
-        float quantizedCoeff = keepInRange(coefficient, -0.3, 0.3);
+        double limit = (double) scales->bcdMax / scales->bcd;
+        float quantizedCoeff = keepInRange(coefficient, -limit, limit);
 
         /* Scale and round to the nearest integer */
-        return (int) round(quantizedCoeff * 50);
+        return (int) round(quantizedCoeff * scales->bcd);
+}
+
+/******** validScales ********
+ *
+ * Checks that quantizer scales fit the codeword fields.
+ *
+ * Parameters:
+ *      const struct quantScales *scales:       The scales to check
+ * Returns:
+ *      true if scales is not NULL and every scale is within its range (see
+ *      blockOperation.h).
+ ************************/
+bool validScales(const struct quantScales *scales)
+{
+        return scales != NULL && scales->a >= 1 && scales->a <= 511 &&
+               scales->bcd >= 1 && scales->bcd <= 1000 &&
+               scales->bcdMax >= 1 && scales->bcdMax <= 15;
+}
+
+/******** sameScales ********
+ *
+ * Returns whether two sets of scales quantize identically.
+ ************************/
+bool sameScales(const struct quantScales *first,
+                const struct quantScales *second)
+{
+        assert(first != NULL && second != NULL);
+        return first->a == second->a && first->bcd == second->bcd &&
+               first->bcdMax == second->bcdMax;
+}
+
+/******** chooseScales ********
+ *
+ * Picks quantizer scales for one image from a sample of its blocks, to meet
+ * a quality or size target.
+ *
+ * Parameters:
+ *      UArray2_T DCTSpace:     An array where each element is a DCTVals struct
+ *      A2Methods_T pMethods:   The plain method suite for DCTSpace
+ *      UArray2b_T RGBCompVid:  The CVCS pixels DCTSpace was made from
+ *      A2Methods_T bMethods:   The blocked method suite for RGBCompVid
+ *      const struct rateTarget *target:        What to aim for
+ * Returns:
+ *      The chosen scales, with bcdMax 15. With no target set, or with a
+ *      size target when the size does not depend on the scales, the choice
+ *      with the least error.
+ * Expects:
+ *      No argument is NULL.
+ * Notes:
+ *      Throws a CRE if an argument is NULL or allocation fails.
+ *      Samples at most about SAMPLE_BLOCKS blocks on an even grid. For each
+ *        candidate a and bcd scale it quantizes the samples and estimates
+ *        - the RMS error: the luma DCT is orthogonal, so a block's luma
+ *          error per pixel is the sum of its squared coefficient errors,
+ *          to which the (fixed) chroma error, measured against each
+ *          pixel's own chroma so that averaging counts, and the final
+ *          rounding to 8 bits are added;
+ *        - the size: the order-0 entropy of each field over the samples,
+ *          which overstates what format 3's contexts and prediction
+ *          achieve, but ranks the candidates the same way.
+ *      With an RMS target it takes the smallest estimate meeting it (and
+ *        the size target, if any); with only a size target, the least
+ *        error within it. If nothing qualifies it takes the least error
+ *        (RMS target) or the smallest size.
+ ************************/
+struct quantScales chooseScales(UArray2_T DCTSpace, A2Methods_T pMethods,
+                                UArray2b_T RGBCompVid, A2Methods_T bMethods,
+                                const struct rateTarget *target)
+{
+        assert(DCTSpace != NULL && pMethods != NULL);
+        assert(RGBCompVid != NULL && bMethods != NULL);
+        assert(target != NULL);
+
+        int blocksWide = pMethods->width(DCTSpace);
+        int blocksHigh = pMethods->height(DCTSpace);
+        size_t numBlocks = (size_t) blocksWide * blocksHigh;
+        int step = (int) ceil(sqrt((double) numBlocks / SAMPLE_BLOCKS));
+        if (step < 1) {
+                step = 1;
+        }
+        int samplesWide = (blocksWide + step - 1) / step;
+        int samplesHigh = (blocksHigh + step - 1) / step;
+        unsigned numSamples = samplesWide * samplesHigh;
+        if (numSamples == 0) {
+                return DEFAULT_SCALES;
+        }
+
+        struct DCTVals *samples = malloc(numSamples * sizeof(*samples));
+        double *chromaSum = malloc(numSamples * sizeof(double));
+        assert(samples != NULL && chromaSum != NULL);
+
+        /* Chroma error is the same for every candidate. Per channel it is
+         * added to each pixel's luma error, so over a block's 12 samples it
+         * contributes its square and a cross term with the a error (the
+         * pixels' deviations from the block average sum to zero, so only
+         * the average meets a) */
+        unsigned pbCounts[CHROMA_SYMBOLS] = { 0 };
+        unsigned prCounts[CHROMA_SYMBOLS] = { 0 };
+        double chromaSquares = 0.0;
+        unsigned k = 0;
+        for (int row = 0; row < blocksHigh; row += step) {
+                for (int col = 0; col < blocksWide; col += step, k++) {
+                        samples[k] = *(struct DCTVals *) pMethods->at(DCTSpace,
+                                                                      col,
+                                                                      row);
+                        unsigned ipb = Arith40_index_of_chroma(samples[k].bpb);
+                        unsigned ipr = Arith40_index_of_chroma(samples[k].bpr);
+                        pbCounts[ipb]++;
+                        prCounts[ipr]++;
+                        double pb = Arith40_chroma_of_index(ipb);
+                        double pr = Arith40_chroma_of_index(ipr);
+
+                        chromaSum[k] = 0.0;
+                        for (int p = 0; p < BLOCKSIZE * BLOCKSIZE; p++) {
+                                struct pixInfo *pix = bMethods->at(
+                                        RGBCompVid, col * BLOCKSIZE + p % 2,
+                                        row * BLOCKSIZE + p / 2);
+                                double dpb = pb - pix->pb;
+                                double dpr = pr - pix->pr;
+                                double dr = 1.402 * dpr;
+                                double dg = -0.344136 * dpb - 0.714136 * dpr;
+                                double db = 1.772 * dpb;
+                                chromaSum[k] += (dr + dg + db) / 4;
+                                chromaSquares += (dr * dr + dg * dg +
+                                                  db * db) / 12;
+                        }
+                }
+        }
+        double chromaBits = entropyBits(pbCounts, CHROMA_SYMBOLS, numSamples) +
+                            entropyBits(prCounts, CHROMA_SYMBOLS, numSamples);
+
+        /* Rounding each channel to 1/255 adds a uniform error */
+        double baseError = chromaSquares / numSamples +
+                           1.0 / (255.0 * 255.0 * 12.0);
+
+        /* Error and bits of each a scale and each bcd scale on their own */
+        double aError[NUM_A_CANDIDATES], aBits[NUM_A_CANDIDATES];
+        for (unsigned i = 0; i < NUM_A_CANDIDATES; i++) {
+                struct quantScales scales = { aCandidates[i], 50, 15 };
+                unsigned counts[A_SYMBOLS] = { 0 };
+                double error = 0.0;
+                for (k = 0; k < numSamples; k++) {
+                        unsigned a = (unsigned) round(samples[k].a * 
+                                                      scales.a);
+                        counts[a < A_SYMBOLS ? a : A_SYMBOLS - 1]++;
+                        double ea = keepInRange(a / (double) scales.a, 0, 1)
+                                    - samples[k].a;
+                        error += ea * ea + 2.0 / 3 * ea * chromaSum[k];
+                }
+                aError[i] = error / numSamples;
+                aBits[i] = entropyBits(counts, A_SYMBOLS, numSamples);
+        }
+        double bcdError[NUM_BCD_CANDIDATES], bcdBits[NUM_BCD_CANDIDATES];
+        for (unsigned i = 0; i < NUM_BCD_CANDIDATES; i++) {
+                struct quantScales scales = { 511, bcdCandidates[i], 15 };
+                unsigned counts[3][BCD_SYMBOLS] = { { 0 } };
+                double error = 0.0;
+                for (k = 0; k < numSamples; k++) {
+                        float coeffs[3] = { samples[k].b, samples[k].c,
+                                            samples[k].d };
+                        for (int j = 0; j < 3; j++) {
+                                int q = quantizeBCD(coeffs[j], &scales);
+                                counts[j][q + BCD_SYMBOLS / 2]++;
+                                double e = dequantizeBCD(q, &scales) - 
+                                           coeffs[j];
+                                error += e * e;
+                        }
+                }
+                bcdError[i] = error / numSamples;
+                bcdBits[i] = 0.0;
+                for (int j = 0; j < 3; j++) {
+                        bcdBits[i] += entropyBits(counts[j], BCD_SYMBOLS,
+                                                  numSamples);
+                }
+        }
+        free(samples);
+        free(chromaSum);
+
+        /* Best qualifying candidate, and the fallbacks */
+        bool sizeMatters = target->entropyCoded && target->bytes > 0;
+        bool haveChoice = false;
+        struct quantScales choice = DEFAULT_SCALES, leastError = choice,
+                           smallest = choice;
+        double choiceKey = 0.0, leastRms = INFINITY, leastBytes = INFINITY;
+        for (unsigned i = 0; i < NUM_A_CANDIDATES; i++) {
+                for (unsigned j = 0; j < NUM_BCD_CANDIDATES; j++) {
+                        struct quantScales scales = { aCandidates[i],
+                                                      bcdCandidates[j], 15 };
+                        double mse = aError[i] + bcdError[j] + baseError;
+                        double rms = sqrt(mse > 0 ? mse : 0);
+                        double bytes = numBlocks * (aBits[i] + bcdBits[j] +
+                                                    chromaBits) / 8;
+                        if (rms < leastRms) {
+                                leastRms = rms;
+                                leastError = scales;
+                        }
+                        if (bytes < leastBytes) {
+                                leastBytes = bytes;
+                                smallest = scales;
+                        }
+
+                        bool meets = (target->rms <= 0 || 
+                                      rms <= target->rms) &&
+                                     (!sizeMatters || 
+                                      bytes <= target->bytes);
+                        double key = target->rms > 0 && 
+                                     target->entropyCoded ? bytes : rms;
+                        if (meets && (!haveChoice || key < choiceKey)) {
+                                haveChoice = true;
+                                choice = scales;
+                                choiceKey = key;
+                        }
+                }
+        }
+        if (haveChoice) {
+                return choice;
+        }
+        return target->rms > 0 || !sizeMatters ? leastError : smallest;
+}
+
+/******** entropyBits ********
+ *
+ * Returns the order-0 entropy, in bits per symbol, of a histogram.
+ ************************/
+static double entropyBits(const unsigned *counts, int numSymbols,
+                          unsigned total)
+{
+        double bits = 0.0;
+        for (int i = 0; i < numSymbols; i++) {
+                if (counts[i] > 0) {
+                        double p = (double) counts[i] / total;
+                        bits -= p * log2(p);
+                }
+        }
+        return bits;
 }
 
 /******** dequantizeValues ********
@@ -367,17 +633,21 @@ static int quantizeBCD(float coefficient)
  *      UArray2_T DCTSpace:     An array where each element is a quantized
  *                                struct
  *      A2Methods_T methods:    The method suite to use
+ *      const struct quantScales *scales:       The scales it was quantized
+ *                                                with
  * Returns:
  *      A UArray2_T where each element is a DCTVals struct.
  * Expects:
- *      DCTSpace and methods are not NULL.
+ *      DCTSpace, methods and scales are not NULL, and scales are valid.
  * Notes:
  *      Allocates memory for the returned UArray2_T, which the caller must free.
  ************************/
-UArray2_T dequantizeValues(UArray2_T DCTSpace, A2Methods_T methods)
+UArray2_T dequantizeValues(UArray2_T DCTSpace, A2Methods_T methods,
+                           const struct quantScales *scales)
 {       
         assert(DCTSpace != NULL);
         assert(methods != NULL);
+        assert(validScales(scales));
 
         A2Methods_mapfun *map = methods->map_default;
         assert(map != NULL);
@@ -389,7 +659,7 @@ UArray2_T dequantizeValues(UArray2_T DCTSpace, A2Methods_T methods)
         assert(dequantFloats != NULL);
 
         struct applyDequantizeClosure closure = {dequantFloats, methods,
-                                                 DCTSpace};
+                                                 DCTSpace, scales};
                                                         
         map(DCTSpace, applyDequantize, &closure);
 
@@ -432,13 +702,15 @@ static void applyDequantize(int col, int row, A2Methods_UArray2 pixels,
         struct quantized *srcQuant = closure->methods->at(closure->DCTSpace,
                                                           col, row);
 
+        const struct quantScales *scales = closure->scales;
+
         /* Dequantize 'a' by dividing by given factor */
-        float a = keepInRange(srcQuant->a / 511.0, 0, 1);
+        float a = keepInRange(srcQuant->a / (double) scales->a, 0, 1);
 
         /* Dequantize 'b', 'c', and 'd' */
-        float b = dequantizeBCD(srcQuant->b);
-        float c = dequantizeBCD(srcQuant->c);
-        float d = dequantizeBCD(srcQuant->d);
+        float b = dequantizeBCD(srcQuant->b, scales);
+        float c = dequantizeBCD(srcQuant->c, scales);
+        float d = dequantizeBCD(srcQuant->d, scales);
 
         /* Dequantize chroma indices  */
         float pb_bar = Arith40_chroma_of_index(srcQuant->indexbpb);
@@ -457,17 +729,19 @@ static void applyDequantize(int col, int row, A2Methods_UArray2 pixels,
  * representation back to a float.
  *
  * Parameters:
- *      int quantizedCoeff:     An integer in the range [-15, 15]
+ *      int quantizedCoeff:     An integer in the range [-bcdMax, bcdMax]
+ *      const struct quantScales *scales:       The quantizer's scales
  * Returns:
  *      A float representing the dequantized coefficient.
  * Expects:
- *      Nothing.
+ *      scales is not NULL.
  * Notes:
  *      Reverses the scaling from quantizeBCD.
  ************************/
-static float dequantizeBCD(int quantizedCoeff)
+static float dequantizeBCD(int quantizedCoeff,
+                           const struct quantScales *scales)
 {
-        float coefficient = quantizedCoeff / 50.0;
+        float coefficient = quantizedCoeff / (double) scales->bcd;
         return coefficient;
 }
 
@@ -587,3 +861,164 @@ static void applyDCTToPixel(int col, int row, A2Methods_UArray2 pixels,
         destPix->pb = pb_bar;
         destPix->pr = pr_bar;
 }
+
+/******** newQuantizedPlanes ********
+ *
+ * Allocates the planes for an image, with every field 0.
+ *
+ * Parameters:
+ *      int blocksWide:         Width of the image in blocks
+ *      int blocksHigh:         Height of the image in blocks
+ * Returns:
+ *      The new planes, to be freed with freeQuantizedPlanes.
+ * Expects:
+ *      blocksWide and blocksHigh are not negative.
+ * Notes:
+ *      Throws a CRE if memory allocation fails.
+ ************************/
+struct quantizedPlanes *newQuantizedPlanes(int blocksWide, int blocksHigh)
+{
+        assert(blocksWide >= 0 && blocksHigh >= 0);
+
+        size_t count = (size_t) blocksWide * blocksHigh + 1;
+        struct quantizedPlanes *planes = malloc(sizeof(*planes));
+        assert(planes != NULL);
+        planes->blocksWide = blocksWide;
+        planes->blocksHigh = blocksHigh;
+        planes->a = calloc(count, sizeof(uint16_t));
+        planes->b = calloc(count, sizeof(int8_t));
+        planes->c = calloc(count, sizeof(int8_t));
+        planes->d = calloc(count, sizeof(int8_t));
+        planes->indexbpb = calloc(count, sizeof(uint8_t));
+        planes->indexbpr = calloc(count, sizeof(uint8_t));
+        assert(planes->a != NULL && planes->b != NULL && planes->c != NULL &&
+               planes->d != NULL && planes->indexbpb != NULL &&
+               planes->indexbpr != NULL);
+        return planes;
+}
+
+/******** freeQuantizedPlanes ********
+ *
+ * Frees planes from newQuantizedPlanes and sets the pointer to NULL.
+ ************************/
+void freeQuantizedPlanes(struct quantizedPlanes **planes)
+{
+        assert(planes != NULL && *planes != NULL);
+
+        free((*planes)->a);
+        free((*planes)->b);
+        free((*planes)->c);
+        free((*planes)->d);
+        free((*planes)->indexbpb);
+        free((*planes)->indexbpr);
+        free(*planes);
+        *planes = NULL;
+}
+
+/******** quantizedToPlanes ********
+ *
+ * Copies an array of 'quantized' structs into planes.
+ *
+ * Parameters:
+ *      UArray2_T quantInts:    An array of 'quantized' structs
+ *      A2Methods_T methods:    The method suite for quantInts
+ * Returns:
+ *      New planes holding the same fields.
+ * Expects:
+ *      quantInts and methods are not NULL.
+ * Notes:
+ *      Throws a CRE if quantInts or methods is NULL or allocation fails.
+ ************************/
+struct quantizedPlanes *quantizedToPlanes(UArray2_T quantInts,
+                                          A2Methods_T methods)
+{
+        assert(quantInts != NULL);
+        assert(methods != NULL);
+
+        struct quantizedPlanes *planes =
+                newQuantizedPlanes(methods->width(quantInts),
+                                   methods->height(quantInts));
+        methods->map_default(quantInts, applyToPlanes, planes);
+        return planes;
+}
+
+/******** planesToQuantized ********
+ *
+ * Copies planes back into a new array of 'quantized' structs.
+ *
+ * Parameters:
+ *      const struct quantizedPlanes *planes:   The planes
+ *      A2Methods_T methods:                    The method suite to use
+ * Returns:
+ *      A UArray2_T where each element is a 'quantized' struct.
+ * Expects:
+ *      planes and methods are not NULL.
+ * Notes:
+ *      Throws a CRE if planes or methods is NULL or allocation fails.
+ ************************/
+UArray2_T planesToQuantized(const struct quantizedPlanes *planes,
+                            A2Methods_T methods)
+{
+        assert(planes != NULL);
+        assert(methods != NULL);
+
+        UArray2_T quantInts = methods->new(planes->blocksWide,
+                                           planes->blocksHigh,
+                                           sizeof(struct quantized));
+        assert(quantInts != NULL);
+        methods->map_default(quantInts, applyFromPlanes, (void *) planes);
+        return quantInts;
+}
+
+/******** applyToPlanes ********
+ *
+ * Apply function that copies one 'quantized' struct into its slot of each
+ * plane.
+ *
+ * Parameters:
+ *      int col, row:                   Position of the block
+ *      A2Methods_UArray2 quantInts:    The array being mapped over (unused)
+ *      void *elem:                     The 'quantized' struct
+ *      void *cl:                       The struct quantizedPlanes
+ ************************/
+static void applyToPlanes(int col, int row, A2Methods_UArray2 quantInts,
+                          void *elem, void *cl)
+{
+        (void) quantInts;
+        const struct quantized *quant = elem;
+        struct quantizedPlanes *planes = cl;
+        size_t i = (size_t) row * planes->blocksWide + col;
+
+        planes->a[i] = quant->a;
+        planes->b[i] = quant->b;
+        planes->c[i] = quant->c;
+        planes->d[i] = quant->d;
+        planes->indexbpb[i] = quant->indexbpb;
+        planes->indexbpr[i] = quant->indexbpr;
+}
+
+/******** applyFromPlanes ********
+ *
+ * Apply function that fills one 'quantized' struct from each plane.
+ *
+ * Parameters:
+ *      int col, row:                   Position of the block
+ *      A2Methods_UArray2 quantInts:    The array being mapped over (unused)
+ *      void *elem:                     The 'quantized' struct to fill
+ *      void *cl:                       The struct quantizedPlanes
+ ************************/
+static void applyFromPlanes(int col, int row, A2Methods_UArray2 quantInts,
+                            void *elem, void *cl)
+{
+        (void) quantInts;
+        struct quantized *quant = elem;
+        const struct quantizedPlanes *planes = cl;
+        size_t i = (size_t) row * planes->blocksWide + col;
+
+        quant->a = planes->a[i];
+        quant->b = planes->b[i];
+        quant->c = planes->c[i];
+        quant->d = planes->d[i];
+        quant->indexbpb = planes->indexbpb[i];
+        quant->indexbpr = planes->indexbpr[i];
+}
@@ -9,6 +9,10 @@
  *      into a block-based representation of quantized coefficients.
  */
 
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+
 #include "a2methods.h"
 #include "uarray2b.h"
 #include "uarray2.h"
@@ -34,12 +38,90 @@ struct quantized
         int b, c, d;
 };
 
+/******** quantScales struct ********
+ *
+ * How the quantizer turns the luma coefficients into codeword fields: a is
+ * stored as round(a * a), and b, c and d as round(x * bcd) after clamping
+ * x to +/- bcdMax / bcd. Images whose scales differ from DEFAULT_SCALES
+ * record them in their header (see codewords.h).
+ *
+ * Fields:
+ *      unsigned a:             Steps per unit of a, 1 to 511 (9 bits)
+ *      unsigned bcd:           Steps per unit of b, c and d, 1 to 1000
+ *      unsigned bcdMax:        Largest magnitude stored for b, c and d, 1 to
+ *                                15 (5 bits)
+ ************************/
+struct quantScales
+{
+        unsigned a, bcd, bcdMax;
+};
+
+/* 511, 50 and 15: b, c and d are clamped to +/- 0.3 */
+extern const struct quantScales DEFAULT_SCALES;
+
+/******** rateTarget struct ********
+ *
+ * What chooseScales aims for.
+ *
+ * Fields:
+ *      double rms:             Largest acceptable RMS error (as ppmdiff
+ *                                reports it), or 0 for none
+ *      size_t bytes:           Largest acceptable compressed size, or 0 for
+ *                                none
+ *      bool entropyCoded:      Whether the size depends on the scales
+ *                                (formats 3 and 4); otherwise every choice
+ *                                costs the same and only quality counts
+ ************************/
+struct rateTarget
+{
+        double rms;
+        size_t bytes;
+        bool entropyCoded;
+};
+
+/******** quantizedPlanes struct ********
+ *
+ * The 'quantized' fields of every block in an image, as one contiguous
+ * array per field (structure of arrays) in row-major block order. A loop
+ * over one field reads only that field's memory, a unit stride of small
+ * integers that vectorizes directly.
+ *
+ * Fields:
+ *      int blocksWide, blocksHigh:     Size of the image in blocks
+ *      uint16_t *a:                    a of each block
+ *      int8_t *b, *c, *d:              b, c and d of each block
+ *      uint8_t *indexbpb, *indexbpr:   Chroma indices of each block
+ ************************/
+struct quantizedPlanes
+{
+        int blocksWide, blocksHigh;
+        uint16_t *a;
+        int8_t *b, *c, *d;
+        uint8_t *indexbpb, *indexbpr;
+};
+
 /* Compression */
 UArray2_T pixelsToDCTBlock(UArray2b_T RGBCompVid, A2Methods_T bMethods, 
                            A2Methods_T pMethods);
-UArray2_T quantizeValues(UArray2_T DCTSpace, A2Methods_T methods);
+UArray2_T quantizeValues(UArray2_T DCTSpace, A2Methods_T methods,
+                         const struct quantScales *scales);
+bool validScales(const struct quantScales *scales);
+bool sameScales(const struct quantScales *first,
+                const struct quantScales *second);
+struct quantScales chooseScales(UArray2_T DCTSpace, A2Methods_T pMethods,
+                                UArray2b_T RGBCompVid, A2Methods_T bMethods,
+                                const struct rateTarget *target);
 
 /* Decompression */
 UArray2b_T DCTBlockToPixels(UArray2_T DCTSpace, A2Methods_T pMethods, 
                             A2Methods_T bMethods);
-UArray2_T dequantizeValues(UArray2_T DCTSpace, A2Methods_T methods);
+UArray2_T dequantizeValues(UArray2_T DCTSpace, A2Methods_T methods,
+                           const struct quantScales *scales);
+
+/* Structure-of-arrays form of an array of 'quantized' structs */
+struct quantizedPlanes *newQuantizedPlanes(int blocksWide, int blocksHigh);
+void freeQuantizedPlanes(struct quantizedPlanes **planes);
+struct quantizedPlanes *quantizedToPlanes(UArray2_T quantInts,
+                                          A2Methods_T methods);
+UArray2_T planesToQuantized(const struct quantizedPlanes *planes,
+                            A2Methods_T methods);
@@ -0,0 +1,450 @@
+/*
+ *      blockTransform.c
+ *      Kevin Lu (klu07), Justin Paik (jpaik03)
+ *      October 18, 2026
+ *      arith
+ *
+ *      Implementation of the 4x4 and 8x8 block transform of format 7.
+ *
+ *      Samples are fixed point with SAMPLE_BITS fraction bits over the
+ *      0-255 scale (Y centred on 0 by subtracting 128). The DCT is the
+ *      orthonormal DCT-II as a size x size integer matrix with COS_BITS
+ *      fraction bits, applied to the rows and then the columns (2 * size^3
+ *      multiplies per block rather than size^4). The first pass keeps
+ *      PASS_BITS extra bits, and every product is summed in 64 bits, so no
+ *      intermediate can overflow.
+ *
+ *      The quantizer steps are the JPEG example tables (ITU T.81 Annex K)
+ *      scaled by QUALITY_PERCENT. For 4x4 blocks the step of frequency
+ *      (u, v) is half that of (2u, 2v) in the 8x8 table: the same spatial
+ *      frequency, and a 4x4 orthonormal coefficient is half the size.
+ */
+
+#include <stdlib.h>
+#include <math.h>
+#include <assert.h>
+
+#include "blockTransform.h"
+#include "pixelOperation.h"
+
+#define CHANNELS 3
+#define SAMPLE_BITS 4
+#define SAMPLE_SCALE (1 << SAMPLE_BITS)
+#define Y_OFFSET (128 * SAMPLE_SCALE)
+#define COS_BITS 14
+#define PASS_BITS 2
+#define QUALITY_PERCENT 50
+#define MAX_COEFFS (MAX_TRANSFORM_SIZE * MAX_TRANSFORM_SIZE)
+
+static const uint8_t lumaSteps[MAX_COEFFS] = {
+        16, 11, 10, 16, 24, 40, 51, 61,
+        12, 12, 14, 19, 26, 58, 60, 55,
+        14, 13, 16, 24, 40, 57, 69, 56,
+        14, 17, 22, 29, 51, 87, 80, 62,
+        18, 22, 37, 56, 68, 109, 103, 77,
+        24, 35, 55, 64, 81, 104, 113, 92,
+        49, 64, 78, 87, 103, 121, 120, 101,
+        72, 92, 95, 98, 112, 100, 103, 99
+};
+
+static const uint8_t chromaSteps[MAX_COEFFS] = {
+        17, 18, 24, 47, 99, 99, 99, 99,
+        18, 21, 26, 66, 99, 99, 99, 99,
+        24, 26, 56, 99, 99, 99, 99, 99,
+        47, 66, 99, 99, 99, 99, 99, 99,
+        99, 99, 99, 99, 99, 99, 99, 99,
+        99, 99, 99, 99, 99, 99, 99, 99,
+        99, 99, 99, 99, 99, 99, 99, 99,
+        99, 99, 99, 99, 99, 99, 99, 99
+};
+
+static const uint8_t zigzag4[16] = {
+        0, 1, 4, 8, 5, 2, 3, 6, 9, 12, 13, 10, 7, 11, 14, 15
+};
+
+static const uint8_t zigzag8[MAX_COEFFS] = {
+        0, 1, 8, 16, 9, 2, 3, 10, 17, 24, 32, 25, 18, 11, 4, 5,
+        12, 19, 26, 33, 40, 48, 41, 34, 27, 20, 13, 6, 7, 14, 21, 28,
+        35, 42, 49, 56, 57, 50, 43, 36, 29, 22, 15, 23, 30, 37, 44, 51,
+        58, 59, 52, 45, 38, 31, 39, 46, 53, 60, 61, 54, 47, 55, 62, 63
+};
+
+/******** kernel struct ********
+ *
+ * Everything the transform needs for one block size, built once per image.
+ *
+ * Fields:
+ *      int size:                       The side of a block
+ *      int32_t basis[8][8]:            basis[k][n] is the DCT-II basis
+ *                                        function k at sample n, scaled by
+ *                                        2^COS_BITS
+ *      int32_t steps[3][64]:           Each channel's quantizer step per
+ *                                        coefficient, in fixed point
+ ************************/
+struct kernel
+{
+        int size;
+        int32_t basis[MAX_TRANSFORM_SIZE][MAX_TRANSFORM_SIZE];
+        int32_t steps[CHANNELS][MAX_COEFFS];
+};
+
+/******** transformClosure struct ********
+ *
+ * The closure for the apply functions in both directions.
+ *
+ * Fields:
+ *      UArray2b_T RGBCompVid:  The CVCS pixels
+ *      A2Methods_T bMethods:   The blocked method suite for RGBCompVid
+ *      const struct kernel *kernel:    The transform for this block size
+ *      bool half:              Whether RGBCompVid has one pixel per 2x2
+ ************************/
+struct transformClosure
+{
+        UArray2b_T RGBCompVid;
+        A2Methods_T bMethods;
+        const struct kernel *kernel;
+        bool half;
+};
+
+static void makeKernel(struct kernel *kernel, int size);
+static void applyPixelsToTransform(int col, int row, A2Methods_UArray2 blocks,
+                                   void *elem, void *cl);
+static void applyTransformToPixels(int col, int row, A2Methods_UArray2 blocks,
+                                   void *elem, void *cl);
+static void forwardDCT(const struct kernel *kernel, const int32_t *samples,
+                       int32_t *coeffs);
+static void inverseDCT(const struct kernel *kernel, const int32_t *coeffs,
+                       int32_t *samples);
+static int32_t descale(int64_t value, int bits);
+static int32_t divideRounded(int32_t value, int32_t divisor);
+
+/******** validTransformSize ********
+ *
+ * Returns whether size is a block size format 7 supports (4 or 8).
+ ************************/
+bool validTransformSize(int size)
+{
+        return size == 4 || size == MAX_TRANSFORM_SIZE;
+}
+
+/******** zigzagOrder ********
+ *
+ * Returns the coefficient indices of a size x size block in zigzag order,
+ * from the DC coefficient to the highest frequency.
+ *
+ * Parameters:
+ *      int size:       The side of a block, 4 or 8
+ * Returns:
+ *      size * size row-major indices, in static storage.
+ * Expects:
+ *      size is valid.
+ * Notes:
+ *      Throws a CRE if size is not valid.
+ ************************/
+const uint8_t *zigzagOrder(int size)
+{
+        assert(validTransformSize(size));
+        return size == 4 ? zigzag4 : zigzag8;
+}
+
+/******** pixelsToTransformBlocks ********
+ *
+ * Transforms and quantizes every size x size block of an image.
+ *
+ * Parameters:
+ *      UArray2b_T RGBCompVid:  Source array of pixInfo structs
+ *      A2Methods_T bMethods:   Blocked method suite for the source array
+ *      A2Methods_T pMethods:   Plain method suite for the destination array
+ *      int size:               The side of a block, 4 or 8
+ * Returns:
+ *      A UArray2_T with one transformBlock per block, which the caller must
+ *      free.
+ * Expects:
+ *      All parameters are not NULL, size is valid, and the width and height
+ *      of RGBCompVid are multiples of size.
+ * Notes:
+ *      Throws a CRE if an expectation is violated or allocation fails.
+ ************************/
+UArray2_T pixelsToTransformBlocks(UArray2b_T RGBCompVid, A2Methods_T bMethods,
+                                  A2Methods_T pMethods, int size)
+{
+        assert(RGBCompVid != NULL);
+        assert(bMethods != NULL);
+        assert(pMethods != NULL);
+        assert(validTransformSize(size));
+        assert(bMethods->width(RGBCompVid) % size == 0);
+        assert(bMethods->height(RGBCompVid) % size == 0);
+
+        UArray2_T blocks = pMethods->new(bMethods->width(RGBCompVid) / size,
+                                         bMethods->height(RGBCompVid) / size,
+                                         sizeof(struct transformBlock));
+        assert(blocks != NULL);
+
+        struct kernel kernel;
+        makeKernel(&kernel, size);
+        struct transformClosure closure = { RGBCompVid, bMethods, &kernel,
+                                            false };
+        pMethods->map_default(blocks, applyPixelsToTransform, &closure);
+        return blocks;
+}
+
+/******** transformBlocksToPixels ********
+ *
+ * Dequantizes and inverse transforms every block back to CVCS pixels.
+ *
+ * Parameters:
+ *      UArray2_T blocks:       An array of transformBlock structs
+ *      A2Methods_T pMethods:   Plain method suite for blocks
+ *      A2Methods_T bMethods:   Blocked method suite for the result
+ *      int size:               The side of a block, 4 or 8
+ *      bool half:              Whether to average each 2x2 of the decoded
+ *                                pixels into one
+ * Returns:
+ *      A UArray2b_T of pixInfo structs, blocks wide times size pixels wide
+ *      (half that if half), which the caller must free.
+ * Expects:
+ *      All parameters are not NULL and size is valid.
+ * Notes:
+ *      Throws a CRE if an expectation is violated or allocation fails.
+ ************************/
+UArray2b_T transformBlocksToPixels(UArray2_T blocks, A2Methods_T pMethods,
+                                   A2Methods_T bMethods, int size, bool half)
+{
+        assert(blocks != NULL);
+        assert(pMethods != NULL);
+        assert(bMethods != NULL);
+        assert(validTransformSize(size));
+
+        int outSize = half ? size / 2 : size;
+        UArray2b_T RGBCompVid = bMethods->new_with_blocksize(
+                pMethods->width(blocks) * outSize,
+                pMethods->height(blocks) * outSize, sizeof(struct pixInfo),
+                outSize);
+        assert(RGBCompVid != NULL);
+
+        struct kernel kernel;
+        makeKernel(&kernel, size);
+        struct transformClosure closure = { RGBCompVid, bMethods, &kernel,
+                                            half };
+        pMethods->map_default(blocks, applyTransformToPixels, &closure);
+        return RGBCompVid;
+}
+
+/******** makeKernel ********
+ *
+ * Fills in the DCT basis and quantizer steps for one block size.
+ ************************/
+static void makeKernel(struct kernel *kernel, int size)
+{
+        kernel->size = size;
+        for (int k = 0; k < size; k++) {
+                double norm = sqrt((k == 0 ? 1.0 : 2.0) / size);
+                for (int n = 0; n < size; n++) {
+                        double basis = norm * cos((2 * n + 1) * k * M_PI /
+                                                  (2 * size));
+                        kernel->basis[k][n] = lround(basis * (1 << COS_BITS));
+                }
+        }
+
+        /* An 8x8 table entry for each frequency, then scaled by size */
+        int stride = MAX_TRANSFORM_SIZE / size;
+        for (int u = 0; u < size; u++) {
+                for (int v = 0; v < size; v++) {
+                        int source = u * stride * MAX_TRANSFORM_SIZE +
+                                     v * stride;
+                        int table[CHANNELS] = { lumaSteps[source],
+                                                chromaSteps[source],
+                                                chromaSteps[source] };
+                        for (int ch = 0; ch < CHANNELS; ch++) {
+                                long step = lround((double) table[ch] *
+                                                   QUALITY_PERCENT * size /
+                                                   (100 *
+                                                    MAX_TRANSFORM_SIZE));
+                                kernel->steps[ch][u * size + v] =
+                                        (step < 1 ? 1 : step) * SAMPLE_SCALE;
+                        }
+                }
+        }
+}
+
+/******** applyPixelsToTransform ********
+ *
+ * Apply function for pixelsToTransformBlocks: reads one block of pixels,
+ * and transforms and quantizes each channel into the transformBlock.
+ ************************/
+static void applyPixelsToTransform(int col, int row, A2Methods_UArray2 blocks,
+                                   void *elem, void *cl)
+{
+        (void) blocks;
+        assert(elem != NULL && cl != NULL);
+
+        struct transformClosure *closure = cl;
+        const struct kernel *kernel = closure->kernel;
+        struct transformBlock *block = elem;
+        int size = kernel->size;
+
+        int32_t samples[CHANNELS][MAX_COEFFS];
+        for (int r = 0; r < size; r++) {
+                for (int c = 0; c < size; c++) {
+                        const struct pixInfo *pix = closure->bMethods->at(
+                                closure->RGBCompVid, col * size + c,
+                                row * size + r);
+                        float scale = DENOMINATOR * SAMPLE_SCALE;
+                        samples[0][r * size + c] =
+                                lroundf(pix->y * scale) - Y_OFFSET;
+                        samples[1][r * size + c] = lroundf(pix->pb * scale);
+                        samples[2][r * size + c] = lroundf(pix->pr * scale);
+                }
+        }
+
+        for (int ch = 0; ch < CHANNELS; ch++) {
+                int32_t coeffs[MAX_COEFFS];
+                forwardDCT(kernel, samples[ch], coeffs);
+                for (int i = 0; i < size * size; i++) {
+                        block->coeffs[ch][i] =
+                                divideRounded(coeffs[i],
+                                              kernel->steps[ch][i]);
+                }
+        }
+}
+
+/******** applyTransformToPixels ********
+ *
+ * Apply function for transformBlocksToPixels: dequantizes and inverse
+ * transforms one block, and writes its pixels (or 2x2 averages of them).
+ ************************/
+static void applyTransformToPixels(int col, int row, A2Methods_UArray2 blocks,
+                                   void *elem, void *cl)
+{
+        (void) blocks;
+        assert(elem != NULL && cl != NULL);
+
+        struct transformClosure *closure = cl;
+        const struct kernel *kernel = closure->kernel;
+        const struct transformBlock *block = elem;
+        int size = kernel->size;
+
+        int32_t samples[CHANNELS][MAX_COEFFS];
+        for (int ch = 0; ch < CHANNELS; ch++) {
+                int32_t coeffs[MAX_COEFFS];
+                for (int i = 0; i < size * size; i++) {
+                        coeffs[i] = block->coeffs[ch][i] *
+                                    kernel->steps[ch][i];
+                }
+                inverseDCT(kernel, coeffs, samples[ch]);
+        }
+
+        int factor = closure->half ? 2 : 1;
+        int outSize = size / factor;
+        float scale = 1.0f / (DENOMINATOR * SAMPLE_SCALE * factor * factor);
+        for (int r = 0; r < outSize; r++) {
+                for (int c = 0; c < outSize; c++) {
+                        int32_t sums[CHANNELS] = { 0, 0, 0 };
+                        for (int ch = 0; ch < CHANNELS; ch++) {
+                                for (int i = 0; i < factor * factor; i++) {
+                                        sums[ch] += samples[ch][
+                                                (r * factor + i / factor) *
+                                                size + c * factor +
+                                                i % factor];
+                                }
+                        }
+                        struct pixInfo *pix = closure->bMethods->at(
+                                closure->RGBCompVid, col * outSize + c,
+                                row * outSize + r);
+                        pix->y = (sums[0] + Y_OFFSET * factor * factor) *
+                                 scale;
+                        pix->pb = sums[1] * scale;
+                        pix->pr = sums[2] * scale;
+                }
+        }
+}
+
+/******** forwardDCT ********
+ *
+ * Transforms one channel of a block: each row, then each column of the
+ * result. Both arrays are row major, size x size.
+ ************************/
+static void forwardDCT(const struct kernel *kernel, const int32_t *samples,
+                       int32_t *coeffs)
+{
+        int size = kernel->size;
+        int32_t rows[MAX_COEFFS];
+
+        for (int r = 0; r < size; r++) {
+                for (int k = 0; k < size; k++) {
+                        int64_t sum = 0;
+                        for (int n = 0; n < size; n++) {
+                                sum += (int64_t) samples[r * size + n] *
+                                       kernel->basis[k][n];
+                        }
+                        rows[r * size + k] = descale(sum,
+                                                     COS_BITS - PASS_BITS);
+                }
+        }
+        for (int c = 0; c < size; c++) {
+                for (int k = 0; k < size; k++) {
+                        int64_t sum = 0;
+                        for (int n = 0; n < size; n++) {
+                                sum += (int64_t) rows[n * size + c] *
+                                       kernel->basis[k][n];
+                        }
+                        coeffs[k * size + c] = descale(sum,
+                                                       COS_BITS + PASS_BITS);
+                }
+        }
+}
+
+/******** inverseDCT ********
+ *
+ * Inverts forwardDCT: each column, then each row of the result.
+ ************************/
+static void inverseDCT(const struct kernel *kernel, const int32_t *coeffs,
+                       int32_t *samples)
+{
+        int size = kernel->size;
+        int32_t cols[MAX_COEFFS];
+
+        for (int c = 0; c < size; c++) {
+                for (int n = 0; n < size; n++) {
+                        int64_t sum = 0;
+                        for (int k = 0; k < size; k++) {
+                                sum += (int64_t) coeffs[k * size + c] *
+                                       kernel->basis[k][n];
+                        }
+                        cols[n * size + c] = descale(sum,
+                                                     COS_BITS - PASS_BITS);
+                }
+        }
+        for (int r = 0; r < size; r++) {
+                for (int n = 0; n < size; n++) {
+                        int64_t sum = 0;
+                        for (int k = 0; k < size; k++) {
+                                sum += (int64_t) cols[r * size + k] *
+                                       kernel->basis[k][n];
+                        }
+                        samples[r * size + n] = descale(sum,
+                                                        COS_BITS + PASS_BITS);
+                }
+        }
+}
+
+/******** descale ********
+ *
+ * Divides by 2^bits, rounding to nearest. Relies on >> of a negative
+ * value being arithmetic, as it is with every compiler we build with.
+ ************************/
+static int32_t descale(int64_t value, int bits)
+{
+        return (value + ((int64_t) 1 << (bits - 1))) >> bits;
+}
+
+/******** divideRounded ********
+ *
+ * Divides by a positive divisor, rounding halves away from zero, as
+ * quantizeValues does for the 2x2 coefficients.
+ ************************/
+static int32_t divideRounded(int32_t value, int32_t divisor)
+{
+        return value >= 0 ? (value + divisor / 2) / divisor :
+                            -((-value + divisor / 2) / divisor);
+}
@@ -0,0 +1,51 @@
+/*
+ *      blockTransform.h
+ *      Kevin Lu (klu07), Justin Paik (jpaik03)
+ *      October 18, 2026
+ *      arith
+ *
+ *      Interface for the block-level step of compressed image format 7,
+ *      which transforms 4x4 or 8x8 blocks instead of 2x2 ones. Each of Y,
+ *      Pb and Pr is transformed at full resolution with a fixed-point
+ *      separable DCT and quantized with a per-frequency step, so most of
+ *      the high frequencies become 0 and cost almost nothing once coded
+ *      (see transformCoding.h).
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "a2methods.h"
+#include "uarray2b.h"
+#include "uarray2.h"
+
+#define MAX_TRANSFORM_SIZE 8
+#define DEFAULT_TRANSFORM_SIZE 8
+
+/******** transformBlock struct ********
+ *
+ * The quantized DCT coefficients of one block.
+ *
+ * Fields:
+ *      int16_t coeffs[3][64]:  For Y, Pb and Pr, the coefficients in
+ *                                row-major frequency order; only the first
+ *                                size * size of each are used
+ ************************/
+struct transformBlock
+{
+        int16_t coeffs[3][MAX_TRANSFORM_SIZE * MAX_TRANSFORM_SIZE];
+};
+
+/* Whether size is a block size format 7 supports (4 or 8) */
+bool validTransformSize(int size);
+
+/* Compression */
+UArray2_T pixelsToTransformBlocks(UArray2b_T RGBCompVid, A2Methods_T bMethods,
+                                  A2Methods_T pMethods, int size);
+
+/* Decompression: half gives one pixel per 2x2 of the image */
+UArray2b_T transformBlocksToPixels(UArray2_T blocks, A2Methods_T pMethods,
+                                   A2Methods_T bMethods, int size, bool half);
+
+/* The order the coefficients are coded in, low frequencies first */
+const uint8_t *zigzagOrder(int size);
@@ -0,0 +1,339 @@
+/*
+ *      checksum.c
+ *      Kevin Lu (klu07), Justin Paik (jpaik03)
+ *      October 18, 2026
+ *      arith
+ *
+ *      Implementation of CRC32C (the Castagnoli polynomial, as used by iSCSI
+ *      and ext4) and the format 2 checksum trailer. On x86-64 CPUs with
+ *      SSE4.2 the CRC comes from the crc32 instruction, 8 bytes at a time;
+ *      elsewhere from slicing-by-8 tables, built once on first use.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <assert.h>
+#include <pthread.h>
+
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#endif
+
+#include "checksum.h"
+
+#define BLOCKSIZE 2
+#define BYTES_PER_WORD 4
+#define POLYNOMIAL 0x82F63B78u          /* reflected */
+#define TRAILER_MAGIC "CRC32C\n"
+#define MAGIC_LENGTH 7
+
+/* Initialize helper functions, see function contracts below */
+static void buildTables(void);
+static uint32_t crc32cSoftware(uint32_t state, const unsigned char *bytes,
+                               size_t length);
+#if defined(__x86_64__)
+static uint32_t crc32cHardware(uint32_t state, const unsigned char *bytes,
+                               size_t length);
+#endif
+static uint32_t loadLittle(const unsigned char *bytes);
+static bool skipScalesLine(FILE *input);
+
+static bool enabled = false;
+
+/* tables[k][b]: CRC of byte b followed by k zero bytes */
+static uint32_t tables[8][256];
+static pthread_once_t tablesOnce = PTHREAD_ONCE_INIT;
+
+/******** checksumsEnable ********
+ *
+ * Turns on checksum trailers for every subsequent format 2 file written by
+ * printWords in this process.
+ ************************/
+void checksumsEnable(void)
+{
+        enabled = true;
+}
+
+/******** checksumsEnabled ********
+ *
+ * Returns true if checksum trailers are turned on.
+ ************************/
+bool checksumsEnabled(void)
+{
+        return enabled;
+}
+
+/******** crc32c ********
+ *
+ * Computes the CRC32C of a run of bytes, optionally continuing an earlier
+ * one.
+ *
+ * Parameters:
+ *      uint32_t crc:           The CRC of the bytes before data, or 0
+ *      const void *data:       The bytes
+ *      size_t length:          Number of bytes
+ * Returns:
+ *      The CRC of everything so far.
+ * Expects:
+ *      data is not NULL unless length is 0.
+ ************************/
+uint32_t crc32c(uint32_t crc, const void *data, size_t length)
+{
+        assert(data != NULL || length == 0);
+
+#if defined(__x86_64__)
+        if (__builtin_cpu_supports("sse4.2")) {
+                return ~crc32cHardware(~crc, data, length);
+        }
+#endif
+        pthread_once(&tablesOnce, buildTables);
+        return ~crc32cSoftware(~crc, data, length);
+}
+
+/******** writeChecksumTrailer ********
+ *
+ * Writes the trailer that follows a format 2 file's codewords.
+ *
+ * Parameters:
+ *      FILE *output:           The stream to write to
+ *      const uint32_t *crcs:   The CRC32C of each band's codeword bytes
+ *      int numBands:           Number of bands
+ * Returns:
+ *      Nothing.
+ * Expects:
+ *      output is not NULL, and crcs is not NULL unless numBands is 0.
+ ************************/
+void writeChecksumTrailer(FILE *output, const uint32_t *crcs, int numBands)
+{
+        assert(output != NULL);
+        assert(crcs != NULL || numBands == 0);
+
+        fputs(TRAILER_MAGIC, output);
+        for (int band = 0; band < numBands; band++) {
+                unsigned char bytes[4] = { crcs[band] >> 24, crcs[band] >> 16,
+                                           crcs[band] >> 8, crcs[band] };
+                fwrite(bytes, 1, 4, output);
+        }
+}
+
+/******** verifyChecksums ********
+ *
+ * Checks a format 2 file's codewords against its checksum trailer, without
+ * unpacking or decoding anything, and reports the result.
+ *
+ * Parameters:
+ *      FILE *input:            The compressed image, at its start
+ *      const char *name:       The name to report it under
+ *      FILE *report:           Where to print "name: OK" or "name: FAILED"
+ *                                with the reason
+ * Returns:
+ *      true if the file is complete and every band matches.
+ * Expects:
+ *      All parameters are not NULL.
+ * Notes:
+ *      Never throws a CRE for a bad file: a malformed header, truncation, a
+ *        missing trailer, a mismatched band and trailing bytes are all
+ *        reported as failures.
+ *      Throws a CRE if memory allocation fails.
+ ************************/
+bool verifyChecksums(FILE *input, const char *name, FILE *report)
+{
+        assert(input != NULL);
+        assert(name != NULL);
+        assert(report != NULL);
+
+        char problem[128] = "";
+        unsigned format;
+        unsigned long long width, height;
+        if (fscanf(input, "COMP40 Compressed image format %u\n",
+                   &format) != 1 || !skipScalesLine(input) ||
+            fscanf(input, "%llu %llu", &width, &height) != 2 ||
+            getc(input) != '\n' || width > INT_MAX || height > INT_MAX) {
+                fprintf(report, "%s: FAILED, not a compressed image\n", name);
+                return false;
+        }
+        if (format != 2) {
+                fprintf(report, "%s: FAILED, format %u has no checksums\n",
+                        name, format);
+                return false;
+        }
+
+        size_t rowBytes = (size_t) (width / BLOCKSIZE) * BYTES_PER_WORD;
+        int blocksHigh = height / BLOCKSIZE;
+        int numBands = (blocksHigh + CHECKSUM_BAND_ROWS - 1) /
+                       CHECKSUM_BAND_ROWS;
+        unsigned char *buffer = malloc(rowBytes * CHECKSUM_BAND_ROWS + 1);
+        uint32_t *computed = malloc(numBands * sizeof(uint32_t) + 1);
+        unsigned char *stored = malloc(numBands * 4 + 1);
+        assert(buffer != NULL && computed != NULL && stored != NULL);
+
+        /* CRC each band as it is read; nothing is unpacked */
+        for (int band = 0; band < numBands && problem[0] == '\0'; band++) {
+                int rows = blocksHigh - band * CHECKSUM_BAND_ROWS;
+                if (rows > CHECKSUM_BAND_ROWS) {
+                        rows = CHECKSUM_BAND_ROWS;
+                }
+                size_t length = rows * rowBytes;
+                if (fread(buffer, 1, length, input) != length) {
+                        snprintf(problem, sizeof(problem),
+                                 "truncated in pixel rows %d-%d",
+                                 band * CHECKSUM_BAND_ROWS * BLOCKSIZE,
+                                 (band * CHECKSUM_BAND_ROWS + rows) *
+                                 BLOCKSIZE - 1);
+                        break;
+                }
+                computed[band] = crc32c(0, buffer, length);
+        }
+
+        char magic[MAGIC_LENGTH];
+        if (problem[0] == '\0' &&
+            (fread(magic, 1, MAGIC_LENGTH, input) != MAGIC_LENGTH ||
+             memcmp(magic, TRAILER_MAGIC, MAGIC_LENGTH) != 0)) {
+                snprintf(problem, sizeof(problem), "no checksum trailer");
+        }
+        if (problem[0] == '\0' &&
+            fread(stored, 4, numBands, input) != (size_t) numBands) {
+                snprintf(problem, sizeof(problem),
+                         "truncated checksum trailer");
+        }
+
+        int badBands = 0, firstBad = 0;
+        for (int band = 0; band < numBands && problem[0] == '\0'; band++) {
+                uint32_t crc = (uint32_t) stored[4 * band] << 24 |
+                               (uint32_t) stored[4 * band + 1] << 16 |
+                               (uint32_t) stored[4 * band + 2] << 8 |
+                               stored[4 * band + 3];
+                if (crc != computed[band] && badBands++ == 0) {
+                        firstBad = band;
+                }
+        }
+        if (problem[0] == '\0' && badBands > 0) {
+                snprintf(problem, sizeof(problem),
+                         "%d of %d row bands corrupt, first at pixel rows "
+                         "%d-%d", badBands, numBands,
+                         firstBad * CHECKSUM_BAND_ROWS * BLOCKSIZE,
+                         (firstBad + 1) * CHECKSUM_BAND_ROWS * BLOCKSIZE - 1);
+        }
+        if (problem[0] == '\0' && getc(input) != EOF) {
+                snprintf(problem, sizeof(problem),
+                         "unexpected data after checksums");
+        }
+
+        free(buffer);
+        free(computed);
+        free(stored);
+
+        if (problem[0] != '\0') {
+                fprintf(report, "%s: FAILED, %s\n", name, problem);
+                return false;
+        }
+        fprintf(report, "%s: OK\n", name);
+        return true;
+}
+
+/******** buildTables ********
+ *
+ * Fills the slicing-by-8 tables. Run once, through pthread_once.
+ ************************/
+static void buildTables(void)
+{
+        for (int b = 0; b < 256; b++) {
+                uint32_t crc = b;
+                for (int bit = 0; bit < 8; bit++) {
+                        crc = (crc >> 1) ^ ((crc & 1) ? POLYNOMIAL : 0);
+                }
+                tables[0][b] = crc;
+        }
+        for (int k = 1; k < 8; k++) {
+                for (int b = 0; b < 256; b++) {
+                        uint32_t previous = tables[k - 1][b];
+                        tables[k][b] = (previous >> 8) ^
+                                       tables[0][previous & 0xFF];
+                }
+        }
+}
+
+/******** crc32cSoftware ********
+ *
+ * Advances a raw (uninverted) CRC32C state over some bytes, 8 at a time
+ * with the slicing tables.
+ ************************/
+static uint32_t crc32cSoftware(uint32_t state, const unsigned char *bytes,
+                               size_t length)
+{
+        while (length >= 8) {
+                uint32_t low = state ^ loadLittle(bytes);
+                uint32_t high = loadLittle(bytes + 4);
+                state = tables[7][low & 0xFF] ^
+                        tables[6][(low >> 8) & 0xFF] ^
+                        tables[5][(low >> 16) & 0xFF] ^
+                        tables[4][low >> 24] ^
+                        tables[3][high & 0xFF] ^
+                        tables[2][(high >> 8) & 0xFF] ^
+                        tables[1][(high >> 16) & 0xFF] ^
+                        tables[0][high >> 24];
+                bytes += 8;
+                length -= 8;
+        }
+        while (length-- > 0) {
+                state = (state >> 8) ^ tables[0][(state ^ *bytes++) & 0xFF];
+        }
+        return state;
+}
+
+#if defined(__x86_64__)
+/******** crc32cHardware ********
+ *
+ * Advances a raw CRC32C state with the SSE4.2 crc32 instruction. Compiled
+ * for SSE4.2 on its own, so the rest of the program runs on any x86-64.
+ ************************/
+__attribute__((target("sse4.2")))
+static uint32_t crc32cHardware(uint32_t state, const unsigned char *bytes,
+                               size_t length)
+{
+        uint64_t wide = state;
+        while (length >= 8) {
+                uint64_t word;
+                memcpy(&word, bytes, 8);
+                wide = _mm_crc32_u64(wide, word);
+                bytes += 8;
+                length -= 8;
+        }
+        state = wide;
+        while (length-- > 0) {
+                state = _mm_crc32_u8(state, *bytes++);
+        }
+        return state;
+}
+#endif
+
+/******** loadLittle ********
+ *
+ * Reads four bytes as a little-endian integer.
+ ************************/
+static uint32_t loadLittle(const unsigned char *bytes)
+{
+        return (uint32_t) bytes[0] | (uint32_t) bytes[1] << 8 |
+               (uint32_t) bytes[2] << 16 | (uint32_t) bytes[3] << 24;
+}
+
+/******** skipScalesLine ********
+ *
+ * Skips the optional "q A BCD BCDMAX" header line that follows the format
+ * line when an image was quantized with non-default scales. The scales do
+ * not change the codeword layout, so they are not needed here. Returns
+ * false if the line is not terminated.
+ ************************/
+static bool skipScalesLine(FILE *input)
+{
+        int c = getc(input);
+        if (c != 'q') {
+                ungetc(c, input);
+                return true;
+        }
+        while (c != EOF && c != '\n') {
+                c = getc(input);
+        }
+        return c == '\n';
+}
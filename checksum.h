@@ -0,0 +1,27 @@
+/*
+ *      checksum.h
+ *      Kevin Lu (klu07), Justin Paik (jpaik03)
+ *      October 18, 2026
+ *      arith
+ *
+ *      Interface for optional CRC32C checksums on format 2 files. When
+ *      enabled, the compressor appends a trailer after the codewords:
+ *      "CRC32C\n" followed by one big-endian CRC32C for each band of
+ *      CHECKSUM_BAND_ROWS block rows. Readers that stop after the codewords
+ *      are unaffected. verifyChecksums checks a file without decoding it.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define CHECKSUM_BAND_ROWS 16
+
+void checksumsEnable(void);
+bool checksumsEnabled(void);
+
+/* Extends crc (0 to start) over length bytes of data */
+uint32_t crc32c(uint32_t crc, const void *data, size_t length);
+
+void writeChecksumTrailer(FILE *output, const uint32_t *crcs, int numBands);
+bool verifyChecksums(FILE *input, const char *name, FILE *report);
@@ -6,45 +6,99 @@
  * 
  *      Implementation for the final stage of the compression process. This
  *      module handles packing quantized integers into 32-bit codewords,
- *      printing them to standard output, and reading codewords from a
+ *      printing them to an output stream, and reading codewords from a
  *      compressed file to unpack them back into integers. This module handles
  *      the C4 and (C4)' steps.  
  */
 
 #include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <limits.h>
 #include <assert.h>
+#include <unistd.h>
+#include <sys/stat.h>
 
 #include "a2methods.h"
 #include "blockOperation.h"
 #include "codewords.h"
 #include "bitpack.h"
+#include "trace.h"
+#include "checksum.h"
 
 #define BLOCKSIZE 2
+#define BYTES_PER_WORD 4
+#define FORMAT 2
+#define HEADER_FORMAT "COMP40 Compressed image format %u\n%u %u\n"
+#define SCALED_HEADER_FORMAT "COMP40 Compressed image format %u\n" \
+                             "q %u %u %u\n%u %u\n"
+#define MAX_HEADER 96
 
 /* Initialize helper functions, see function contracts below */
 static void applyPrintWord(int col, int row, A2Methods_UArray2 quantInts,
                            void *elem, void *cl);
 static uint64_t packBits(uint64_t a, int64_t b, int64_t c, int64_t d, 
                          uint64_t indexbpb, uint64_t indexbpr);
-static uint64_t readCodeword(FILE *input);
+static void unpackRow(const unsigned char *rowBytes, UArray2_T quantInts,
+                      A2Methods_T methods, int row);
+static void skipBytes(FILE *input, size_t count, unsigned char *scratch,
+                      size_t scratchSize);
+static uint64_t assembleCodeword(const unsigned char *bytes);
 static struct quantized unpackCodeword(uint64_t word);
+static bool validDimensions(unsigned long long width,
+                            unsigned long long height);
+
+/******** printWordClosure struct ********
+ *
+ * A closure passed to the apply function that packs codewords. Codewords
+ * are collected one block row at a time. When writing to a stream, each row
+ * is written with a single fwrite and the buffer is reused; when writing to
+ * memory, the buffer pointer moves on to the next row instead.
+ *
+ * Fields:
+ *      unsigned char *rowBytes:        Where the current row is packed
+ *      int width:                      Number of codewords in a row
+ *      FILE *out:                      Destination stream, or NULL when
+ *                                        packing into memory
+ *      uint32_t *bandCrcs:             CRC32C of each band of rows written,
+ *                                        or NULL when not checksumming
+ *      bool failed:                    Whether a row write came up short;
+ *                                        later rows are then not written
+ ************************/
+struct printWordClosure
+{
+        unsigned char *rowBytes;
+        int width;
+        FILE *out;
+        uint32_t *bandCrcs;
+        bool failed;
+};
 
 /******** printWords ********
  *
- * Prints the compressed image header and all codewords to standard output.
+ * Prints the compressed image header and all codewords to an output stream.
  *
  * Parameters:
+ *      FILE *output:           The stream to write to, normally stdout
  *      UArray2_T quantInts:    An array of 'quantized' structs to be packed
  *      A2Methods_T methods:    The method suite for array operations
+ *      const struct quantScales *scales:       The scales quantInts was
+ *                                                quantized with, for the
+ *                                                header
  * Returns:
- *      Nothing.s
+ *      true if every codeword was written, false if a write came up short.
  * Expects:
- *      quantInts and methods are not NULL.
+ *      output, quantInts and methods are not NULL.
  * Notes:
- *      Throws a CRE if quantInts or methods is NULL.
+ *      Throws a CRE if output, quantInts or methods is NULL.
+ *      Throws a CRE if memory allocation fails.
+ *      Relies on the plain methods' row-major default mapping order.
+ *      Appends the checksum trailer (see checksum.h) if checksums are on.
  ************************/
-void printWords(UArray2_T quantInts, A2Methods_T methods)
+bool printWords(FILE *output, UArray2_T quantInts, A2Methods_T methods,
+                const struct quantScales *scales)
 {
+        assert(output != NULL);
         assert(quantInts != NULL);
         assert(methods != NULL);
 
@@ -54,45 +108,235 @@ void printWords(UArray2_T quantInts, A2Methods_T methods)
         /* Print the header with original image's trimmed dimensions */
         unsigned width = methods->width(quantInts) * BLOCKSIZE;
         unsigned height = methods->height(quantInts) * BLOCKSIZE;
-        printf("COMP40 Compressed image format 2\n%u %u\n", width, height);
+        writeCompressedHeader(output, width, height, scales);
         
+        int numBands = (methods->height(quantInts) + CHECKSUM_BAND_ROWS - 1)
+                       / CHECKSUM_BAND_ROWS;
+        uint32_t *bandCrcs = NULL;
+        if (checksumsEnabled()) {
+                bandCrcs = calloc(numBands + 1, sizeof(uint32_t));
+                assert(bandCrcs != NULL);
+        }
+
+        bool written = printWordRows(output, quantInts, methods, bandCrcs);
+
+        if (bandCrcs != NULL) {
+                if (written) {
+                        writeChecksumTrailer(output, bandCrcs, numBands);
+                }
+                free(bandCrcs);
+        }
+        return written;
+}
+
+/******** printWordRows ********
+ *
+ * Prints the codewords of every block row of quantInts, with no header or
+ * trailer, so that an image can be written a band of rows at a time.
+ *
+ * Parameters:
+ *      FILE *output:           The stream to write to
+ *      UArray2_T quantInts:    An array of 'quantized' structs to be packed
+ *      A2Methods_T methods:    The method suite for array operations
+ *      uint32_t *bandCrcs:     The checksums to extend, band 0 being the
+ *                                band of quantInts' first row, or NULL
+ * Returns:
+ *      true if every row was written, false if a write came up short.
+ * Expects:
+ *      output, quantInts and methods are not NULL.
+ *      If bandCrcs is not NULL, quantInts starts on a checksum band
+ *        boundary of the image (a multiple of CHECKSUM_BAND_ROWS block rows)
+ *        and bandCrcs has room for each band it touches.
+ * Notes:
+ *      Throws a CRE if output, quantInts or methods is NULL, or allocation
+ *        fails.
+ *      Relies on the plain methods' row-major default mapping order.
+ ************************/
+bool printWordRows(FILE *output, UArray2_T quantInts, A2Methods_T methods,
+                   uint32_t *bandCrcs)
+{
+        assert(output != NULL);
+        assert(quantInts != NULL);
+        assert(methods != NULL);
+
+        A2Methods_mapfun *map = methods->map_default;
+        assert(map != NULL);
+
+        /* Buffer one row of codewords at a time */
+        struct printWordClosure closure;
+        closure.out = output;
+        closure.width = methods->width(quantInts);
+        closure.rowBytes = malloc((size_t) closure.width * BYTES_PER_WORD + 1);
+        assert(closure.rowBytes != NULL);
+        closure.bandCrcs = bandCrcs;
+        closure.failed = false;
+
         /* Map over the array of quantized ints, printing each as a codeword */
-        map(quantInts, applyPrintWord, NULL);
+        map(quantInts, applyPrintWord, &closure);
+
+        free(closure.rowBytes);
+        return !closure.failed;
 }
 
 /******** applyPrintWord ********
  *
  * Apply function that packs a single 'quantized' struct into a 32-bit codeword
- * and prints its four bytes to standard output in big-endian order.
+ * and stores its four bytes in the row buffer in big-endian order. Once the
+ * last codeword of a row is stored, the whole row is written to the closure's
+ * stream (and added to its band's checksum), or the buffer is advanced past
+ * it when packing into memory. After a short write no further rows are
+ * written.
  *
  * Parameters:
- *      int col:                     Column index of the current block (unused)
- *      int row:                     Row index of the current block (unused)
+ *      int col:                     Column index of the current block
+ *      int row:                     Row index of the current block
  *      A2Methods_UArray2 quantInts: The array being mapped over (unused)
  *      void *elem:                  Pointer to the current 'quantized' struct
- *      void *cl:                    Closure pointer (unused)
+ *      void *cl:                    Pointer to the printWordClosure
  * Returns:
  *      Nothing.
  * Expects:
- *      elem is not NULL.
+ *      elem and cl are not NULL.
+ * Notes:
+ *      Each row write is recorded as an "io" span when tracing is on.
  ************************/
 static void applyPrintWord(int col, int row, A2Methods_UArray2 quantInts,
                            void *elem, void *cl)
 {       
-        (void) col;
-        (void) row;
         (void) quantInts;
-        (void) cl;
         assert(elem != NULL);
+        assert(cl != NULL);
+
+        struct printWordClosure *closure = cl;
 
         struct quantized *originalQuant = elem;
 
-        uint64_t a = originalQuant->a;
-        int64_t b = originalQuant->b;
-        int64_t c =  originalQuant->c;
-        int64_t d = originalQuant->d;
-        uint64_t indexbpb = originalQuant->indexbpb;
-        uint64_t indexbpr = originalQuant->indexbpr;
+        /* Pack the struct into the row buffer */
+        codewordToBytes(originalQuant, closure->rowBytes + 
+                                       (size_t) col * BYTES_PER_WORD);
+
+        /* Write the row once it is complete */
+        if (col == closure->width - 1) {
+                if (closure->out == NULL) {
+                        closure->rowBytes += (size_t) closure->width *
+                                             BYTES_PER_WORD;
+                        return;
+                }
+                if (closure->failed) {
+                        return;
+                }
+                traceBegin("write codeword row", "io");
+                size_t written = fwrite(closure->rowBytes, BYTES_PER_WORD,
+                                        closure->width, closure->out);
+                traceEnd();
+                if (written != (size_t) closure->width) {
+                        closure->failed = true;
+                        return;
+                }
+                if (closure->bandCrcs != NULL) {
+                        int band = row / CHECKSUM_BAND_ROWS;
+                        closure->bandCrcs[band] =
+                                crc32c(closure->bandCrcs[band],
+                                       closure->rowBytes,
+                                       (size_t) closure->width *
+                                       BYTES_PER_WORD);
+                }
+        }
+}
+
+/******** compressedSize ********
+ *
+ * Computes the exact number of bytes printWords or packWords produces for an
+ * image of the given (even) dimensions, header included.
+ *
+ * Parameters:
+ *      unsigned width:         Width of the trimmed image in pixels
+ *      unsigned height:        Height of the trimmed image in pixels
+ * Returns:
+ *      The size of the compressed image in bytes.
+ * Expects:
+ *      Nothing.
+ ************************/
+size_t compressedSize(unsigned width, unsigned height)
+{
+        size_t header = snprintf(NULL, 0, HEADER_FORMAT, FORMAT, width,
+                                 height);
+        return header + (size_t) (width / BLOCKSIZE) * (height / BLOCKSIZE) * 
+                        BYTES_PER_WORD;
+}
+
+/******** packWords ********
+ *
+ * Writes the compressed image header and all codewords into memory, in
+ * exactly the format printWords prints.
+ *
+ * Parameters:
+ *      UArray2_T quantInts:    An array of 'quantized' structs to be packed
+ *      A2Methods_T methods:    The method suite for array operations
+ *      unsigned char *dest:    Where to write the compressed image
+ * Returns:
+ *      The number of bytes written.
+ * Expects:
+ *      quantInts, methods and dest are not NULL.
+ *      dest has room for compressedSize(width, height) bytes.
+ * Notes:
+ *      Throws a CRE if quantInts, methods or dest is NULL.
+ ************************/
+size_t packWords(UArray2_T quantInts, A2Methods_T methods, 
+                 unsigned char *dest)
+{
+        assert(quantInts != NULL);
+        assert(methods != NULL);
+        assert(dest != NULL);
+
+        A2Methods_mapfun *map = methods->map_default;
+        assert(map != NULL);
+
+        unsigned width = methods->width(quantInts) * BLOCKSIZE;
+        unsigned height = methods->height(quantInts) * BLOCKSIZE;
+        size_t total = compressedSize(width, height);
+
+        char header[MAX_HEADER];
+        size_t headerLength = snprintf(header, sizeof(header), HEADER_FORMAT,
+                                       FORMAT, width, height);
+        memcpy(dest, header, headerLength);
+
+        struct printWordClosure closure;
+        closure.out = NULL;
+        closure.bandCrcs = NULL;
+        closure.failed = false;
+        closure.width = methods->width(quantInts);
+        closure.rowBytes = dest + headerLength;
+
+        map(quantInts, applyPrintWord, &closure);
+
+        return total;
+}       
+
+/******** codewordToBytes ********
+ *
+ * Packs a 'quantized' struct into a 32-bit codeword and stores its four
+ * bytes in big-endian order.
+ *
+ * Parameters:
+ *      const struct quantized *quant:  The fields to pack
+ *      unsigned char *bytes:           Where to store the four bytes
+ * Returns:
+ *      Nothing.
+ * Expects:
+ *      quant and bytes are not NULL.
+ ************************/
+void codewordToBytes(const struct quantized *quant, unsigned char *bytes)
+{
+        assert(quant != NULL);
+        assert(bytes != NULL);
+
+        uint64_t a = quant->a;
+        int64_t b = quant->b;
+        int64_t c = quant->c;
+        int64_t d = quant->d;
+        uint64_t indexbpb = quant->indexbpb;
+        uint64_t indexbpr = quant->indexbpr;
 
         /* Pack the integer fields from the struct into a single 64-bit word */
         uint64_t word = packBits(a, b, c, d, indexbpb, indexbpr);
@@ -100,12 +344,83 @@ static void applyPrintWord(int col, int row, A2Methods_UArray2 quantInts,
         /* Mask to isolate one byte at a time */
         uint64_t mask = 0xFF;
 
-        /* Print the 4 bytes of the codeword in big-endian order */
-        putchar((word >> 24) & mask);
-        putchar((word >> 16) & mask);
-        putchar((word >> 8) & mask);
-        putchar(word & mask);
-}       
+        /* Store the 4 bytes of the codeword in big-endian order */
+        bytes[0] = (word >> 24) & mask;
+        bytes[1] = (word >> 16) & mask;
+        bytes[2] = (word >> 8) & mask;
+        bytes[3] = word & mask;
+}
+
+/******** codewordFromBytes ********
+ *
+ * Unpacks the four big-endian bytes of a codeword into a 'quantized' struct.
+ *
+ * Parameters:
+ *      const unsigned char *bytes:     The codeword's four bytes
+ *      struct quantized *quant:        Where to store the fields
+ * Returns:
+ *      Nothing.
+ * Expects:
+ *      bytes and quant are not NULL.
+ ************************/
+void codewordFromBytes(const unsigned char *bytes, struct quantized *quant)
+{
+        assert(quant != NULL);
+        *quant = unpackCodeword(assembleCodeword(bytes));
+}
+
+/******** writeCompressedHeader ********
+ *
+ * Prints the header of a compressed image.
+ *
+ * Parameters:
+ *      FILE *output:           The stream to write to
+ *      unsigned width:         Width of the image in pixels
+ *      unsigned height:        Height of the image in pixels
+ *      const struct quantScales *scales:       The quantizer's scales, or
+ *                                                NULL for the defaults
+ * Returns:
+ *      Nothing.
+ * Expects:
+ *      output is not NULL.
+ ************************/
+void writeCompressedHeader(FILE *output, unsigned width, unsigned height,
+                           const struct quantScales *scales)
+{
+        writeFormatHeader(output, FORMAT, width, height, scales);
+}
+
+/******** writeFormatHeader ********
+ *
+ * Prints the header of a compressed image in the given format.
+ *
+ * Parameters:
+ *      FILE *output:           The stream to write to
+ *      unsigned format:        The format number
+ *      unsigned width:         Width of the image in pixels
+ *      unsigned height:        Height of the image in pixels
+ *      const struct quantScales *scales:       The quantizer's scales, or
+ *                                                NULL for the defaults
+ * Returns:
+ *      Nothing.
+ * Expects:
+ *      output is not NULL.
+ * Notes:
+ *      Scales other than DEFAULT_SCALES go on a "q A BCD BCDMAX" line
+ *        between the format line and the dimensions, so images with the
+ *        default scales have the same header as always.
+ ************************/
+void writeFormatHeader(FILE *output, unsigned format, unsigned width,
+                       unsigned height, const struct quantScales *scales)
+{
+        assert(output != NULL);
+        if (scales == NULL || sameScales(scales, &DEFAULT_SCALES)) {
+                fprintf(output, HEADER_FORMAT, format, width, height);
+        } else {
+                fprintf(output, SCALED_HEADER_FORMAT, format, scales->a,
+                        scales->bcd, scales->bcdMax, width, height);
+        }
+}
 
 /******** packBits ********
  *
@@ -134,6 +449,262 @@ static uint64_t packBits(uint64_t a, int64_t b, int64_t c, int64_t d,
         return word;
 }
 
+/******** readCompressedHeader ********
+ *
+ * Reads the required header from a compressed image file.
+ *
+ * Parameters:
+ *      FILE *input:            File pointer to the compressed image
+ *      unsigned *width:        Pointer to store the read width
+ *      unsigned *height:       Pointer to store the read height
+ *      struct quantScales *scales:     Pointer to store the scales
+ * Returns:
+ *      Nothing.
+ * Expects:
+ *      All parameters are not NULL.
+ *      The input file has a correctly formatted header.
+ * Notes:
+ *      Throws a CRE if the header format does not match the spec.
+ ************************/
+void readCompressedHeader(FILE *input, unsigned *width, unsigned *height,
+                          struct quantScales *scales)
+{
+        unsigned format = readFormatHeader(input, width, height, scales);
+        assert(format == FORMAT);
+}
+
+/******** readFormatHeader ********
+ *
+ * Reads the header of a compressed image in any format.
+ *
+ * Parameters:
+ *      FILE *input:            File pointer to the compressed image
+ *      unsigned *width:        Pointer to store the read width
+ *      unsigned *height:       Pointer to store the read height
+ *      struct quantScales *scales:     Pointer to store the scales,
+ *                                        DEFAULT_SCALES if the header has
+ *                                        none
+ * Returns:
+ *      The format number from the header.
+ * Expects:
+ *      All parameters are not NULL.
+ * Notes:
+ *      Throws a CRE if the header is malformed, its scales are out of
+ *        range or its dimensions do not fit an array (see
+ *        validDimensions). Leaves checking the format number to the
+ *        caller.
+ ************************/
+unsigned readFormatHeader(FILE *input, unsigned *width, unsigned *height,
+                          struct quantScales *scales)
+{
+        assert(input != NULL);
+        assert(width != NULL);
+        assert(height != NULL);
+        assert(scales != NULL);
+
+        /* Use fscanf with the provided string to read the header */
+        unsigned format;
+        int read = fscanf(input, "COMP40 Compressed image format %u\n",
+                          &format);
+        assert(read == 1);
+
+        /* The dimensions start with a digit, so a 'q' means scales */
+        *scales = DEFAULT_SCALES;
+        int next = getc(input);
+        if (next == 'q') {
+                read = fscanf(input, "%u %u %u", &scales->a, &scales->bcd,
+                              &scales->bcdMax);
+                assert(read == 3 && validScales(scales));
+        } else {
+                ungetc(next, input);
+        }
+        unsigned long long wide, high;
+        read = fscanf(input, "%llu %llu", &wide, &high);
+        assert(read == 2 && validDimensions(wide, high));
+        *width = wide;
+        *height = high;
+
+        /* Verify final newline character */
+        int c = getc(input);
+        assert(c == '\n');
+
+        return format;
+}
+
+/******** readWordsRegion ********
+ *
+ * Reads and unpacks only the codewords of a rectangle of blocks. Codewords
+ * are a fixed 4 bytes in row-major block order, so each row of the
+ * rectangle is one contiguous run at a known offset.
+ *
+ * Parameters:
+ *      FILE *input:            File pointer positioned after the header
+ *      A2Methods_T methods:    The method suite for array operations
+ *      unsigned width:         The width of the whole image in pixels
+ *      unsigned height:        The height of the whole image in pixels
+ *      int blockCol:           First block column of the rectangle
+ *      int blockRow:           First block row of the rectangle
+ *      int blocksWide:         Width of the rectangle in blocks
+ *      int blocksHigh:         Height of the rectangle in blocks
+ * Returns:
+ *      A blocksWide x blocksHigh UArray2_T of 'quantized' structs.
+ * Expects:
+ *      input and methods are not NULL.
+ *      The rectangle is non-empty and lies within the image's blocks.
+ * Notes:
+ *      Throws a CRE if an expectation is violated or allocation fails.
+ *      Throws a CRE if EOF is reached before the rectangle's last row.
+ *      When input is a regular file each row is one pread at its offset and
+ *        nothing else is read; the stream's position is left unchanged.
+ *        Otherwise (a pipe) the codewords before and between the rows are
+ *        read and discarded, and reading stops after the last row.
+ ************************/
+UArray2_T readWordsRegion(FILE *input, A2Methods_T methods, unsigned width,
+                          unsigned height, int blockCol, int blockRow,
+                          int blocksWide, int blocksHigh)
+{
+        assert(input != NULL);
+        assert(methods != NULL);
+        int blockedWidth = width / BLOCKSIZE;
+        int blockedHeight = height / BLOCKSIZE;
+        assert(blocksWide > 0 && blocksHigh > 0);
+        assert(blockCol >= 0 && blockCol + blocksWide <= blockedWidth);
+        assert(blockRow >= 0 && blockRow + blocksHigh <= blockedHeight);
+
+        UArray2_T quantInts = methods->new(blocksWide, blocksHigh, 
+                                           sizeof(struct quantized));
+        assert(quantInts != NULL);
+
+        size_t rowLength = (size_t) blocksWide * BYTES_PER_WORD;
+        unsigned char *rowBytes = malloc(rowLength + 1);
+        assert(rowBytes != NULL);
+
+        struct stat info;
+        off_t start = ftello(input);
+        bool seekable = start >= 0 && fstat(fileno(input), &info) == 0 &&
+                        S_ISREG(info.st_mode);
+
+        if (!seekable) {
+                skipBytes(input, ((size_t) blockRow * blockedWidth + 
+                                  blockCol) * BYTES_PER_WORD, rowBytes, 
+                          rowLength);
+        }
+        for (int row = 0; row < blocksHigh; row++) {
+                traceBegin("read codeword row", "io");
+                size_t read;
+                if (seekable) {
+                        off_t offset = start + ((off_t) (blockRow + row) * 
+                                                blockedWidth + blockCol) * 
+                                               BYTES_PER_WORD;
+                        ssize_t got = pread(fileno(input), rowBytes, 
+                                            rowLength, offset);
+                        read = got < 0 ? 0 : (size_t) got;
+                } else {
+                        read = fread(rowBytes, 1, rowLength, input);
+                }
+                traceEnd();
+                assert(read == rowLength);
+
+                unpackRow(rowBytes, quantInts, methods, row);
+
+                if (!seekable && row + 1 < blocksHigh) {
+                        skipBytes(input, (size_t) (blockedWidth - 
+                                                   blocksWide) * 
+                                         BYTES_PER_WORD, rowBytes, 
+                                  rowLength);
+                }
+        }
+
+        free(rowBytes);
+        return quantInts;
+}
+
+/******** skipBytes ********
+ *
+ * Reads and discards bytes from a stream that cannot seek.
+ *
+ * Parameters:
+ *      FILE *input:            The stream
+ *      size_t count:           How many bytes to discard
+ *      unsigned char *scratch: A buffer to read into
+ *      size_t scratchSize:     Its size in bytes, at least 1
+ * Returns:
+ *      Nothing.
+ * Notes:
+ *      Throws a CRE if EOF is reached first.
+ ************************/
+static void skipBytes(FILE *input, size_t count, unsigned char *scratch,
+                      size_t scratchSize)
+{
+        while (count > 0) {
+                size_t chunk = count < scratchSize ? count : scratchSize;
+                size_t read = fread(scratch, 1, chunk, input);
+                assert(read == chunk);
+                count -= chunk;
+        }
+}
+
+/******** parseCompressedHeader ********
+ *
+ * Parses the header at the start of a compressed image held in memory.
+ *
+ * Parameters:
+ *      const unsigned char *bytes:     The compressed image
+ *      size_t length:                  Number of bytes available
+ *      unsigned *width:                Pointer to store the width
+ *      unsigned *height:               Pointer to store the height
+ *      struct quantScales *scales:     Pointer to store the scales
+ * Returns:
+ *      The length of the header in bytes, or 0 if it is malformed.
+ * Expects:
+ *      All pointers are not NULL.
+ * Notes:
+ *      Accepts exactly what readCompressedHeader accepts.
+ ************************/
+size_t parseCompressedHeader(const unsigned char *bytes, size_t length, 
+                             unsigned *width, unsigned *height,
+                             struct quantScales *scales)
+{
+        assert(bytes != NULL);
+        assert(width != NULL);
+        assert(height != NULL);
+        assert(scales != NULL);
+
+        /* Copy into a terminated string so sscanf cannot run off the end */
+        char header[MAX_HEADER + 1];
+        size_t copied = length < MAX_HEADER ? length : MAX_HEADER;
+        memcpy(header, bytes, copied);
+        header[copied] = '\0';
+
+        int used = 0;
+        sscanf(header, "COMP40 Compressed image format 2\n%n", &used);
+        if (used == 0) {
+                return 0;
+        }
+
+        *scales = DEFAULT_SCALES;
+        int more = 0;
+        if (header[used] == 'q') {
+                int read = sscanf(header + used, "q %u %u %u%n", &scales->a,
+                                  &scales->bcd, &scales->bcdMax, &more);
+                if (read != 3 || !validScales(scales)) {
+                        return 0;
+                }
+                used += more;
+        }
+
+        more = 0;
+        unsigned long long wide, high;
+        int read = sscanf(header + used, "%llu %llu%n", &wide, &high, &more);
+        if (read != 2 || header[used + more] != '\n' ||
+            !validDimensions(wide, high)) {
+                return 0;
+        }
+        *width = wide;
+        *height = high;
+        return used + more + 1;
+}
+
 /******** readWords ********
  *
  * Reads all codewords from a compressed file, unpacks them, and stores the
@@ -151,6 +722,9 @@ static uint64_t packBits(uint64_t a, int64_t b, int64_t c, int64_t d,
  * Notes:
  *      Throws a CRE if input or methods is NULL.
  *      Throws a CRE if memory allocation fails.
+ *      Throws a CRE if EOF is reached prematurely.
+ *      Reads one row of codewords per fread; each is recorded as an "io"
+ *        span when tracing is on.
  ************************/
 UArray2_T readWords(FILE *input, A2Methods_T methods, unsigned width, 
                     unsigned height)
@@ -164,59 +738,127 @@ UArray2_T readWords(FILE *input, A2Methods_T methods, unsigned width,
                                            sizeof(struct quantized));
         assert(quantInts != NULL);
 
+        int blockedWidth = width / BLOCKSIZE;
+        unsigned char *rowBytes = malloc((size_t) blockedWidth * 
+                                         BYTES_PER_WORD + 1);
+        assert(rowBytes != NULL);
+
         /* Iterate through the expected number of codewords */
         for (int row = 0; row < (int) height / BLOCKSIZE; row++) {
-                for (int col = 0; col < (int) width / BLOCKSIZE; col++) {
-                        /* Read the next 4 bytes and assemble each codeword */
-                        uint64_t word = readCodeword(input);
+                /* Read a whole row of codewords at once */
+                traceBegin("read codeword row", "io");
+                size_t read = fread(rowBytes, BYTES_PER_WORD, blockedWidth, 
+                                    input);
+                traceEnd();
 
-                        /* Unpack the codeword into a 'quantized' struct */
-                        struct quantized quant = unpackCodeword(word);
+                /* If the row is incomplete, the file is too short */
+                assert(read == (size_t) blockedWidth);
 
-                        /* Store the unpacked struct in the array */
-                        struct quantized *destQuant = methods->at(quantInts,
-                                                                  col, row);
-                        *destQuant = quant;
-                }
+                unpackRow(rowBytes, quantInts, methods, row);
         }
 
+        free(rowBytes);
         return quantInts;
 }
 
-/******** readCodeword ********
+/******** unpackWords ********
  *
- * Reads four bytes from the input stream and assembles them into a single
- * 32-bit codeword, respecting big-endian byte order.
+ * Unpacks codewords held in memory into a new UArray2 of integer
+ * coefficients, like readWords does for a stream.
  *
  * Parameters:
- *      FILE *input:    File pointer to the compressed data
+ *      const unsigned char *bytes:     The codewords, just past the header
+ *      A2Methods_T methods:            The method suite for array operations
+ *      unsigned width:                 Width of the image in pixels
+ *      unsigned height:                Height of the image in pixels
  * Returns:
- *      A 64-bit word containing the assembled 32-bit codeword.
+ *      A UArray2_T where each element is a 'quantized' struct.
  * Expects:
- *      input is not NULL.
- *      input contains at least 4 more bytes of data.
+ *      bytes and methods are not NULL.
+ *      bytes holds all (width / 2) * (height / 2) codewords.
  * Notes:
- *      Throws a CRE if EOF is reached prematurely.
+ *      Throws a CRE if bytes or methods is NULL.
+ *      Throws a CRE if memory allocation fails.
  ************************/
-static uint64_t readCodeword(FILE *input) 
+UArray2_T unpackWords(const unsigned char *bytes, A2Methods_T methods, 
+                      unsigned width, unsigned height)
 {
-        assert(input != NULL);
+        assert(bytes != NULL);
+        assert(methods != NULL);
+
+        UArray2_T quantInts = methods->new(width / BLOCKSIZE, 
+                                           height / BLOCKSIZE, 
+                                           sizeof(struct quantized));
+        assert(quantInts != NULL);
+
+        size_t rowLength = (size_t) (width / BLOCKSIZE) * BYTES_PER_WORD;
+        for (int row = 0; row < (int) height / BLOCKSIZE; row++) {
+                unpackRow(bytes + row * rowLength, quantInts, methods, row);
+        }
 
-        /* Read four sequential bytes from the input stream */
-        int byte1 = getc(input);        
-        int byte2 = getc(input);
-        int byte3 = getc(input);
-        int byte4 = getc(input);
+        return quantInts;
+}
+
+/******** unpackRow ********
+ *
+ * Unpacks one row of codewords into the matching row of quantInts.
+ *
+ * Parameters:
+ *      const unsigned char *rowBytes:  The row's codewords, 4 bytes each
+ *      UArray2_T quantInts:            The destination array
+ *      A2Methods_T methods:            The method suite for quantInts
+ *      int row:                        Index of the block row
+ * Returns:
+ *      Nothing.
+ * Expects:
+ *      All pointers are not NULL.
+ *      rowBytes holds one codeword per column of quantInts.
+ ************************/
+static void unpackRow(const unsigned char *rowBytes, UArray2_T quantInts,
+                      A2Methods_T methods, int row)
+{
+        assert(rowBytes != NULL);
+        assert(quantInts != NULL);
+        assert(methods != NULL);
+
+        int blockedWidth = methods->width(quantInts);
+        for (int col = 0; col < blockedWidth; col++) {
+                /* Assemble each codeword from its 4 bytes */
+                uint64_t word = assembleCodeword(rowBytes + 
+                                                 col * BYTES_PER_WORD);
 
-        /* If any byte is EOF, the file is too short and throws a CRE */
-        assert(byte1 != EOF && byte2 != EOF && byte3 != EOF && byte4 != EOF);
+                /* Unpack the codeword into a 'quantized' struct */
+                struct quantized quant = unpackCodeword(word);
+
+                /* Store the unpacked struct in the array */
+                struct quantized *destQuant = methods->at(quantInts, col, 
+                                                          row);
+                *destQuant = quant;
+        }
+}
+
+/******** assembleCodeword ********
+ *
+ * Assembles four bytes into a single 32-bit codeword, respecting big-endian
+ * byte order.
+ *
+ * Parameters:
+ *      const unsigned char *bytes:     The codeword's four bytes
+ * Returns:
+ *      A 64-bit word containing the assembled 32-bit codeword.
+ * Expects:
+ *      bytes is not NULL and points to at least 4 bytes.
+ ************************/
+static uint64_t assembleCodeword(const unsigned char *bytes) 
+{
+        assert(bytes != NULL);
 
         /* Assemble the bytes into a 64-bit word in big-endian order */
         uint64_t word = 0;
-        word = Bitpack_newu(word, 8, 24, (uint64_t) byte1);
-        word = Bitpack_newu(word, 8, 16, (uint64_t) byte2);
-        word = Bitpack_newu(word, 8, 8,  (uint64_t) byte3);
-        word = Bitpack_newu(word, 8, 0,  (uint64_t) byte4);
+        word = Bitpack_newu(word, 8, 24, (uint64_t) bytes[0]);
+        word = Bitpack_newu(word, 8, 16, (uint64_t) bytes[1]);
+        word = Bitpack_newu(word, 8, 8,  (uint64_t) bytes[2]);
+        word = Bitpack_newu(word, 8, 0,  (uint64_t) bytes[3]);
 
         return word;
 }
@@ -248,3 +890,16 @@ static struct quantized unpackCodeword(uint64_t word)
 
         return quant;
 }
+
+/******** validDimensions ********
+ *
+ * Whether a header's dimensions fit the arrays an image is decoded into,
+ * which index each dimension with an int. They are read as 64-bit values
+ * and checked here so that an oversized one is rejected rather than
+ * silently wrapped.
+ ************************/
+static bool validDimensions(unsigned long long width,
+                            unsigned long long height)
+{
+        return width <= INT_MAX && height <= INT_MAX;
+}
@@ -6,19 +6,50 @@
  * 
  *      Interface for the final stage of the compression process. This module
  *      handles the C4 and (C4)' steps, which involve packing quantized integers
- *      into 32-bit codewords, printing them to standard output, and reading
+ *      into 32-bit codewords, printing them to an output stream, and reading
  *      codewords from a compressed file to unpack them back into integers.  
  */
 
 #include <stdio.h>
 #include <stdint.h>
+#include <stdbool.h>
 
 #include "uarray2.h"
 #include "a2methods.h"
 
+/* Defined in blockOperation.h */
+struct quantized;
+struct quantScales;
+
 /* Compression */
-void printWords(UArray2_T quantInts, A2Methods_T methods);
+void writeCompressedHeader(FILE *output, unsigned width, unsigned height,
+                           const struct quantScales *scales);
+void writeFormatHeader(FILE *output, unsigned format, unsigned width,
+                       unsigned height, const struct quantScales *scales);
+bool printWords(FILE *output, UArray2_T quantInts, A2Methods_T methods,
+                const struct quantScales *scales);
+bool printWordRows(FILE *output, UArray2_T quantInts, A2Methods_T methods,
+                   uint32_t *bandCrcs);
+size_t compressedSize(unsigned width, unsigned height);
+size_t packWords(UArray2_T quantInts, A2Methods_T methods, 
+                 unsigned char *dest);
+
+/* Single codewords, in their four big-endian bytes */
+void codewordToBytes(const struct quantized *quant, unsigned char *bytes);
+void codewordFromBytes(const unsigned char *bytes, struct quantized *quant);
 
 /* Decompression */
+void readCompressedHeader(FILE *input, unsigned *width, unsigned *height,
+                          struct quantScales *scales);
+unsigned readFormatHeader(FILE *input, unsigned *width, unsigned *height,
+                          struct quantScales *scales);
 UArray2_T readWords(FILE *input, A2Methods_T methods, unsigned width, 
                     unsigned height);
+UArray2_T readWordsRegion(FILE *input, A2Methods_T methods, unsigned width,
+                          unsigned height, int blockCol, int blockRow,
+                          int blocksWide, int blocksHigh);
+size_t parseCompressedHeader(const unsigned char *bytes, size_t length, 
+                             unsigned *width, unsigned *height,
+                             struct quantScales *scales);
+UArray2_T unpackWords(const unsigned char *bytes, A2Methods_T methods, 
+                      unsigned width, unsigned height);
@@ -11,6 +11,8 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdbool.h>
+#include <math.h>
 #include <assert.h>
 
 #include "uarray2.h"
@@ -22,10 +24,24 @@
 #include "pixelOperation.h"
 #include "blockOperation.h"
 #include "codewords.h"
+#include "entropyCoding.h"
+#include "tiles.h"
+#include "progressive.h"
+#include "planar.h"
+#include "blockTransform.h"
+#include "transformCoding.h"
+#include "tableDecode.h"
+#include "stageTimer.h"
 
-/* Initialize helper functions, see function contracts below */
-static void readCompressedHeader(FILE *input, unsigned *width, 
-                                 unsigned *height);
+#define BLOCKSIZE 2
+
+static struct quantScales pickScales(UArray2_T DCTSpace,
+                                     A2Methods_T pMethods,
+                                     UArray2b_T RGBCompVid,
+                                     A2Methods_T bMethods, unsigned format,
+                                     const struct quantScales *scales,
+                                     const struct rateTarget *target);
+static double rmsDifference(Pnm_ppm first, Pnm_ppm second);
 
 /******** compress40 ********
  *
@@ -40,12 +56,101 @@ static void readCompressedHeader(FILE *input, unsigned *width,
  *      input is not NULL and points to a valid, open PPM file.
  * Notes:
  *      Throws a CRE if input is NULL
+ *      Thin wrapper around compress40_to.
+ ************************/
+extern void compress40(FILE *input)
+{
+        compress40_to(input, stdout);
+}
+
+/******** compress40_to ********
+ *
+ * Compresses a PPM image from an input stream and writes the binary compressed
+ * format to the given output stream.
+ *
+ * Parameters:
+ *      FILE *input:    A file pointer to the source PPM image
+ *      FILE *output:   The stream the compressed image is written to
+ * Returns:
+ *      Nothing.
+ * Expects:
+ *      input is not NULL and points to a valid, open PPM file.
+ *      output is not NULL and open for writing.
+ * Notes:
+ *      Throws a CRE if input or output is NULL
  *      Manages the entire compression pipeline and frees all intermediate data
  *        structures.
  ************************/
-extern void compress40(FILE *input)
-{       
+extern void compress40_to(FILE *input, FILE *output)
+{
+        compress40_format(input, output, 2);
+}
+
+/******** compress40_format ********
+ *
+ * Compresses a PPM image from an input stream and writes it to the given
+ * output stream in the given compressed format.
+ *
+ * Parameters:
+ *      FILE *input:    A file pointer to the source PPM image
+ *      FILE *output:   The stream the compressed image is written to
+ *      unsigned format: 2 for raw codewords, 3 for entropy-coded fields,
+ *                       4 for entropy-coded tiles, 5 for progressive
+ *                       codewords, 6 for separate field planes, 7 for
+ *                       8x8 transform blocks
+ * Returns:
+ *      Nothing.
+ * Expects:
+ *      input is not NULL and points to a valid, open PPM file.
+ *      output is not NULL and open for writing.
+ *      format is 2 to 7.
+ * Notes:
+ *      Throws a CRE if input or output is NULL or format is unknown.
+ *      Manages the entire compression pipeline and frees all intermediate data
+ *        structures.
+ ************************/
+extern void compress40_format(FILE *input, FILE *output, unsigned format)
+{
+        if (format == 7) {
+                compress40_blocks(input, output, DEFAULT_TRANSFORM_SIZE);
+        } else {
+                compress40_tuned(input, output, format, NULL, NULL);
+        }
+}
+
+/******** compress40_tuned ********
+ *
+ * Compresses a PPM image to the given format with the given quantization
+ * scales, or with scales chosen for this image to meet a target.
+ *
+ * Parameters:
+ *      FILE *input:    A file pointer to the source PPM image
+ *      FILE *output:   The stream the compressed image is written to
+ *      unsigned format: As for compress40_format
+ *      const struct quantScales *scales:       The scales to use, or NULL
+ *      const struct rateTarget *target:        What to choose scales for
+ *                                                if scales is NULL, or
+ *                                                NULL for the defaults
+ * Returns:
+ *      Nothing.
+ * Expects:
+ *      input is not NULL and points to a valid, open PPM file.
+ *      output is not NULL and open for writing.
+ *      format is 2 to 6, and scales, if given, are valid.
+ * Notes:
+ *      Throws a CRE if input or output is NULL, format is unknown or the
+ *        scales are invalid.
+ *      Scales other than the defaults are recorded in the header, so any
+ *        decompressor reads them back.
+ *      Exits with EXIT_FAILURE if the compressed image cannot be written.
+ ************************/
+extern void compress40_tuned(FILE *input, FILE *output, unsigned format,
+                             const struct quantScales *scales,
+                             const struct rateTarget *target)
+{
         assert(input != NULL);
+        assert(output != NULL);
+        assert(format >= 2 && format <= 6);
 
         /* Initialize method suites for blocked and plain arrays */
         A2Methods_T bMethods = uarray2_methods_blocked;
@@ -57,13 +162,19 @@ extern void compress40(FILE *input)
          *      Read and trim the image to even dimensions
          */
         
+        stageBegin("C1 readImage");
         Pnm_ppm img = readImage(input);
+        stageEnd();
+        unsigned width = img->width;
+        unsigned height = img->height;
 
         /* Step C2: Pixel-level Operations
          *      Convert integer RGB pixels to float Component Video
          */
         
+        stageBegin("C2 getRGBCompVid");
         UArray2b_T RGBCompVid = getRGBCompVid(img, bMethods);
+        stageEnd();
         img->methods->free(&(img->pixels));
         free(img);
 
@@ -73,22 +184,250 @@ extern void compress40(FILE *input)
          */
         
         /* Part 1: Convert CV pixels to DCT blocks (float) */
+        stageBegin("C3 pixelsToDCTBlock");
         UArray2_T DCTSpace = pixelsToDCTBlock(RGBCompVid, bMethods, 
                                               pMethods);
+        stageEnd();
+        struct quantScales chosen = pickScales(DCTSpace, pMethods,
+                                               RGBCompVid, bMethods, format,
+                                               scales, target);
         bMethods->free((A2Methods_UArray2 *) &RGBCompVid);
         
         /* Part 2: Quantize float DCT values to integers */
-        UArray2_T quantInts = quantizeValues(DCTSpace, pMethods);
+        stageBegin("C3 quantizeValues");
+        UArray2_T quantInts = quantizeValues(DCTSpace, pMethods, &chosen);
+        stageEnd();
         pMethods->free((A2Methods_UArray2 *) &DCTSpace);
 
         /* Step C4: Bit Codeword Operations
-         *      Pack integers into codewords and print to stdout
+         *      Pack integers into codewords and print to the output stream
          */
 
-        printWords(quantInts, pMethods);
+        bool written = true;
+        if (format == 3) {
+                stageBegin("C4 printWordsEntropy");
+                printWordsEntropy(output, quantInts, pMethods, &chosen);
+        } else if (format == 4) {
+                stageBegin("C4 printWordsTiled");
+                printWordsTiled(output, quantInts, pMethods, 0, &chosen);
+        } else if (format == 5) {
+                stageBegin("C4 printWordsProgressive");
+                printWordsProgressive(output, quantInts, pMethods,
+                                      &chosen);
+        } else if (format == 6) {
+                stageBegin("C4 printWordsPlanar");
+                struct quantizedPlanes *planes = 
+                        quantizedToPlanes(quantInts, pMethods);
+                printWordsPlanar(output, planes, &chosen);
+                freeQuantizedPlanes(&planes);
+        } else {
+                stageBegin("C4 printWords");
+                written = printWords(output, quantInts, pMethods, &chosen);
+        }
+        if (fflush(output) != 0 || ferror(output)) {
+                written = false;
+        }
+        stageEnd();
         pMethods->free((A2Methods_UArray2 *) &quantInts);
+        if (!written) {
+                fprintf(stderr, "could not write the compressed image\n");
+                exit(EXIT_FAILURE);
+        }
+
+        stageReport(stderr, width, height);
 } 
 
+/******** compress40_quality ********
+ *
+ * Runs the compression pipeline up to the quantized codeword fields, then
+ * decodes them and measures the result against the input, all in memory.
+ *
+ * Parameters:
+ *      FILE *input:    A file pointer to the source PPM image
+ *      unsigned format: The format the image would be written in, which
+ *                       matters only when choosing scales for a target
+ *      const struct quantScales *scales:       As for compress40_tuned
+ *      const struct rateTarget *target:        As for compress40_tuned
+ * Returns:
+ *      The root mean square difference between the round-tripped image and
+ *      the input trimmed to even dimensions, over channels scaled to [0, 1].
+ * Expects:
+ *      input is not NULL and points to a valid, open PPM file.
+ * Notes:
+ *      Throws a CRE if input is NULL.
+ *      Step C4 is skipped: packing the fields into codewords and reading
+ *        them back changes nothing, so the decoder takes the quantized
+ *        array directly. The decoded pixels are compared one at a time
+ *        inside the decoder's block loop (tableDecodeError) and never
+ *        stored.
+ ************************/
+extern double compress40_quality(FILE *input, unsigned format,
+                                 const struct quantScales *scales,
+                                 const struct rateTarget *target)
+{
+        assert(input != NULL);
+
+        A2Methods_T bMethods = uarray2_methods_blocked;
+        assert(bMethods != NULL);
+        A2Methods_T pMethods = uarray2_methods_plain;
+        assert(pMethods != NULL);
+
+        stageBegin("C1 readImage");
+        Pnm_ppm img = readImage(input);
+        stageEnd();
+
+        /* The image is kept until the end to measure against */
+        stageBegin("C2 getRGBCompVid");
+        UArray2b_T RGBCompVid = getRGBCompVid(img, bMethods);
+        stageEnd();
+
+        stageBegin("C3 pixelsToDCTBlock");
+        UArray2_T DCTSpace = pixelsToDCTBlock(RGBCompVid, bMethods, 
+                                              pMethods);
+        stageEnd();
+        struct quantScales chosen = pickScales(DCTSpace, pMethods,
+                                               RGBCompVid, bMethods, format,
+                                               scales, target);
+        bMethods->free((A2Methods_UArray2 *) &RGBCompVid);
+
+        stageBegin("C3 quantizeValues");
+        UArray2_T quantInts = quantizeValues(DCTSpace, pMethods, &chosen);
+        stageEnd();
+        pMethods->free((A2Methods_UArray2 *) &DCTSpace);
+
+        stageBegin("(C3)'+(C2)' tableDecodeError");
+        double error = tableDecodeError(quantInts, pMethods, &chosen, img);
+        stageEnd();
+        pMethods->free((A2Methods_UArray2 *) &quantInts);
+
+        stageReport(stderr, img->width, img->height);
+        img->methods->free(&(img->pixels));
+        free(img);
+        return error;
+}
+
+/******** compress40_blocks ********
+ *
+ * Compresses a PPM image to format 7, transforming size x size blocks.
+ *
+ * Parameters:
+ *      FILE *input:    A file pointer to the source PPM image
+ *      FILE *output:   The stream the compressed image is written to
+ *      int size:       The side of a block, 4 or 8
+ * Returns:
+ *      Nothing.
+ * Expects:
+ *      input is not NULL and points to a valid, open PPM file.
+ *      output is not NULL and open for writing, and size is 4 or 8.
+ * Notes:
+ *      Throws a CRE if an expectation is violated.
+ *      The image is trimmed to a multiple of size in each direction.
+ *      Exits with EXIT_FAILURE if the compressed image cannot be written.
+ ************************/
+extern void compress40_blocks(FILE *input, FILE *output, int size)
+{
+        assert(input != NULL);
+        assert(output != NULL);
+        assert(validTransformSize(size));
+
+        A2Methods_T bMethods = uarray2_methods_blocked;
+        assert(bMethods != NULL);
+        A2Methods_T pMethods = uarray2_methods_plain;
+        assert(pMethods != NULL);
+
+        stageBegin("C1 readImageBlocks");
+        Pnm_ppm img = readImageBlocks(input, size);
+        stageEnd();
+        unsigned width = img->width;
+        unsigned height = img->height;
+
+        stageBegin("C2 getRGBCompVidBlocks");
+        UArray2b_T RGBCompVid = getRGBCompVidBlocks(img, bMethods, size);
+        stageEnd();
+        img->methods->free(&(img->pixels));
+        free(img);
+
+        stageBegin("C3 pixelsToTransformBlocks");
+        UArray2_T blocks = pixelsToTransformBlocks(RGBCompVid, bMethods,
+                                                   pMethods, size);
+        stageEnd();
+        bMethods->free((A2Methods_UArray2 *) &RGBCompVid);
+
+        stageBegin("C4 printWordsTransform");
+        printWordsTransform(output, blocks, pMethods, size);
+        bool written = fflush(output) == 0 && !ferror(output);
+        stageEnd();
+        pMethods->free((A2Methods_UArray2 *) &blocks);
+        if (!written) {
+                fprintf(stderr, "could not write the compressed image\n");
+                exit(EXIT_FAILURE);
+        }
+
+        stageReport(stderr, width, height);
+}
+
+/******** compress40_blocks_quality ********
+ *
+ * compress40_quality for format 7: transforms, quantizes and inverts
+ * size x size blocks in memory, and measures the result against the input.
+ *
+ * Parameters:
+ *      FILE *input:    A file pointer to the source PPM image
+ *      int size:       The side of a block, 4 or 8
+ * Returns:
+ *      The RMS difference, as ppmdiff reports it, between the decoded image
+ *      and the input trimmed to a multiple of size.
+ * Expects:
+ *      input is not NULL and points to a valid, open PPM file, and size is
+ *      4 or 8.
+ * Notes:
+ *      Throws a CRE if an expectation is violated.
+ *      Step C4 is skipped, as the codewords hold the quantized coefficients
+ *        exactly.
+ ************************/
+extern double compress40_blocks_quality(FILE *input, int size)
+{
+        assert(input != NULL);
+        assert(validTransformSize(size));
+
+        A2Methods_T bMethods = uarray2_methods_blocked;
+        assert(bMethods != NULL);
+        A2Methods_T pMethods = uarray2_methods_plain;
+        assert(pMethods != NULL);
+
+        stageBegin("C1 readImageBlocks");
+        Pnm_ppm img = readImageBlocks(input, size);
+        stageEnd();
+
+        stageBegin("C2 getRGBCompVidBlocks");
+        UArray2b_T RGBCompVid = getRGBCompVidBlocks(img, bMethods, size);
+        stageEnd();
+
+        stageBegin("C3 pixelsToTransformBlocks");
+        UArray2_T blocks = pixelsToTransformBlocks(RGBCompVid, bMethods,
+                                                   pMethods, size);
+        stageEnd();
+        bMethods->free((A2Methods_UArray2 *) &RGBCompVid);
+
+        stageBegin("(C3)' transformBlocksToPixels");
+        RGBCompVid = transformBlocksToPixels(blocks, pMethods, bMethods,
+                                             size, false);
+        stageEnd();
+        stageBegin("(C2)' getRGBInts");
+        Pnm_ppm decoded = getRGBInts(RGBCompVid, bMethods);
+        stageEnd();
+        bMethods->free((A2Methods_UArray2 *) &RGBCompVid);
+        pMethods->free((A2Methods_UArray2 *) &blocks);
+
+        double error = rmsDifference(img, decoded);
+        stageReport(stderr, img->width, img->height);
+        img->methods->free(&(img->pixels));
+        free(img);
+        decoded->methods->free(&(decoded->pixels));
+        free(decoded);
+        return error;
+}
+
 /******** decompress40 ********
  *
  * Reads a compressed binary image from an input stream, decompresses it, and
@@ -101,90 +440,326 @@ extern void compress40(FILE *input)
  *      input points to a valid, open compressed file.
  * Notes:
  *      Throws a CRE if input is NULL.
+ *      Thin wrapper around decompress40_to.
+ ************************/
+extern void decompress40(FILE *input)
+{
+        decompress40_to(input, stdout);
+}
+
+/******** decompress40_to ********
+ *
+ * Reads a compressed binary image from an input stream, decompresses it, and
+ * writes the resulting PPM image to the given output stream.
+ *
+ * Parameters:
+ *      FILE *input:    A file pointer to the source compressed image
+ *      FILE *output:   The stream the PPM image is written to
+ * Expects:
+ *      input is not NULL.
+ *      input points to a valid, open compressed file.
+ *      output is not NULL and open for writing.
+ * Notes:
+ *      Throws a CRE if input or output is NULL.
+ *      Thin wrapper around decompress40_region.
+ ************************/
+extern void decompress40_to(FILE *input, FILE *output)
+{
+        decompress40_region(input, output, false, false, NULL);
+}
+
+/******** decompress40_half ********
+ *
+ * Reads a compressed binary image from an input stream and writes a
+ * half-resolution PPM, one pixel per 2x2 block, to standard output.
+ *
+ * Parameters:
+ *      FILE *input:    A file pointer to the source compressed image
+ * Expects:
+ *      input is not NULL.
+ *      input points to a valid, open compressed file.
+ * Notes:
+ *      Throws a CRE if input is NULL.
+ *      Only a, indexbpb and indexbpr are used; b, c and d are never
+ *        dequantized and no inverse DCT is done.
+ ************************/
+extern void decompress40_half(FILE *input)
+{
+        decompress40_region(input, stdout, true, false, NULL);
+}
+
+/******** decompress40_region ********
+ *
+ * Runs the decompression pipeline from an input stream to an output stream,
+ * optionally at half resolution and/or for a rectangle of the image only.
+ *
+ * Parameters:
+ *      FILE *input:                    A file pointer to the source
+ *                                        compressed image
+ *      FILE *output:                   The stream the PPM image is written to
+ *      bool half:                      Whether to write one pixel per 2x2
+ *                                        (tableDecodeHalf, or averaged for
+ *                                        format 7) instead of the
+ *                                        full-resolution image
+ *      bool partial:                   Whether a format 5 image may end
+ *                                        before its detail plane does
+ *      const struct cropRect *crop:    The rectangle to write, in the output
+ *                                        image's pixels, or NULL for all
+ * Expects:
+ *      input is not NULL.
+ *      input points to a valid, open compressed file.
+ *      output is not NULL and open for writing.
+ * Notes:
+ *      Throws a CRE if input or output is NULL.
+ *      A rectangle reaching past the image is clipped to it. One lying
+ *        wholly outside the image is reported and the program exits.
+ *      With partial, the blocks whose detail has not arrived are decoded
+ *        flat (b, c and d of 0), so a format 5 image can be previewed as it
+ *        arrives. Any other format is reported and the program exits.
+ *      With a rectangle, only the codewords of the blocks it touches are
+ *        read (readWordsRegion) and decoded.
  *      Manages the entire decompression pipeline and frees all intermediate
  *        data structures.
  ************************/
-extern void decompress40(FILE *input)
+extern void decompress40_region(FILE *input, FILE *output, bool half,
+                                bool partial, const struct cropRect *crop)
 {
         assert(input != NULL);
+        assert(output != NULL);
 
-        /* Initialize method suites */
-        A2Methods_T bMethods = uarray2_methods_blocked;
-        assert(bMethods != NULL);
+        /* Initialize method suite */
         A2Methods_T pMethods = uarray2_methods_plain;
         assert(pMethods != NULL);
 
         unsigned width, height;
+        struct quantScales scales;
+        UArray2_T quantInts = NULL;
+
+        /* Format 7 only: its transform blocks and their size */
+        UArray2_T blocks = NULL;
+        int transformSize = 0;
+
+        /* Pixels written, and where they start in the decoded blocks */
+        unsigned reportWidth, reportHeight;
+        int cropCol = 0, cropRow = 0;
         
         /* Read header to get image dimensions */
-        readCompressedHeader(input, &width, &height);
+        stageBegin("(C4)' readFormatHeader");
+        unsigned format = readFormatHeader(input, &width, &height, &scales);
+        stageEnd();
+        if (format < 2 || format > 7) {
+                fprintf(stderr, "unknown compressed image format %u\n",
+                        format);
+                exit(EXIT_FAILURE);
+        }
+        if (partial && format != 5) {
+                fprintf(stderr, "only format 5 images can be decoded "
+                        "partially, not format %u\n", format);
+                exit(EXIT_FAILURE);
+        }
+        reportWidth = half ? width / BLOCKSIZE : width;
+        reportHeight = half ? height / BLOCKSIZE : height;
 
         /* Step (C4)': Bit Codeword Operations
          *      Read codewords and unpack into an array of quantized int structs
          */
          
-        UArray2_T quantInts = readWords(input, pMethods, width, height);
+        if (format == 3) {
+                /* Entropy-coded fields have no fixed offsets, so a crop
+                 * decodes every block and trims afterwards */
+                stageBegin("(C4)' readWordsEntropy");
+                quantInts = readWordsEntropy(input, pMethods, width, height);
+                stageEnd();
+        } else if (format == 5) {
+                /* A half-resolution decode needs only the DC plane, and
+                 * a partial one as much detail as has arrived. As with
+                 * format 3, a crop decodes every block */
+                stageBegin("(C4)' readWordsProgressive");
+                enum refinement refinement = half ? DC_ONLY :
+                                             partial ? DETAIL_AVAILABLE :
+                                                       DETAIL_REQUIRED;
+                quantInts = readWordsProgressive(input, pMethods, width,
+                                                 height, refinement);
+                stageEnd();
+        } else if (format == 6) {
+                /* Likewise, but skipping the b, c and d planes */
+                stageBegin("(C4)' readWordsPlanar");
+                struct quantizedPlanes *planes = readWordsPlanar(
+                        input, width, height, half ? PLANE_A |
+                        PLANE_INDEXBPB | PLANE_INDEXBPR : ALL_PLANES);
+                quantInts = planesToQuantized(planes, pMethods);
+                freeQuantizedPlanes(&planes);
+                stageEnd();
+        } else if (format == 7) {
+                /* As with format 3, a crop decodes every block */
+                stageBegin("(C4)' readWordsTransform");
+                blocks = readWordsTransform(input, pMethods, width, height,
+                                            &transformSize);
+                stageEnd();
+        } else if (format == 4 && crop == NULL) {
+                stageBegin("(C4)' readWordsTiled");
+                quantInts = readWordsTiled(input, pMethods, width, height, 0);
+                stageEnd();
+        } else if (crop == NULL) {
+                stageBegin("(C4)' readWords");
+                quantInts = readWords(input, pMethods, width, height);
+                stageEnd();
+        }
+        if (crop != NULL) {
+                /* Output pixels per block along each axis */
+                unsigned scale = half ? 1 : BLOCKSIZE;
+                unsigned outWidth = width / BLOCKSIZE * scale;
+                unsigned outHeight = height / BLOCKSIZE * scale;
+                if (crop->x >= outWidth || crop->y >= outHeight ||
+                    crop->width == 0 || crop->height == 0) {
+                        fprintf(stderr, "crop rectangle lies outside the "
+                                "%ux%u image\n", outWidth, outHeight);
+                        exit(EXIT_FAILURE);
+                }
+                reportWidth = crop->width < outWidth - crop->x ? 
+                              crop->width : outWidth - crop->x;
+                reportHeight = crop->height < outHeight - crop->y ?
+                               crop->height : outHeight - crop->y;
 
-        /* Step (C3)': Block-level Operations
-         *      Convert bit-representation integers to CV Pixels 
-         *      Intermediate steps shown for clarity
-         */
-        
-        /* Part 1: Dequantize integers to float DCT values */
-        UArray2_T dequantFloats = dequantizeValues(quantInts, pMethods);
-        pMethods->free((A2Methods_UArray2 *) &quantInts);
+                if (format == 3 || format >= 5) {
+                        cropCol = crop->x;
+                        cropRow = crop->y;
+                } else {
+                        /* The blocks the rectangle touches, rounding
+                         * outward */
+                        int blockCol = crop->x / scale;
+                        int blockRow = crop->y / scale;
+                        int blocksWide = (crop->x + reportWidth + scale - 1)
+                                         / scale - blockCol;
+                        int blocksHigh = (crop->y + reportHeight + scale - 1)
+                                         / scale - blockRow;
 
-        /* Part 2: Convert DCT blocks back to float Component Video pixels */
-        UArray2b_T deRGBCompVid = DCTBlockToPixels(dequantFloats, 
-                                                   pMethods,
-                                                   bMethods);
-        pMethods->free((A2Methods_UArray2 *) &dequantFloats);
+                        /* Tiles may decode more blocks than asked for */
+                        if (format == 4) {
+                                stageBegin("(C4)' readWordsTiledRegion");
+                                quantInts = readWordsTiledRegion(
+                                        input, pMethods, width, height,
+                                        blockCol, blockRow, blocksWide,
+                                        blocksHigh, &blockCol, &blockRow, 0);
+                        } else {
+                                stageBegin("(C4)' readWordsRegion");
+                                quantInts = readWordsRegion(
+                                        input, pMethods, width, height,
+                                        blockCol, blockRow, blocksWide,
+                                        blocksHigh);
+                        }
+                        stageEnd();
+                        cropCol = crop->x - blockCol * scale;
+                        cropRow = crop->y - blockRow * scale;
+                }
+        }
 
-        /* Step (C2)': Pixel-level Operations
-         *      Convert float Component Video pixels to integer RGB
+        /* Steps (C3)' and (C2)': Block- and Pixel-level Operations
+         *      Dequantize, apply the inverse DCT, and convert to integer RGB
+         *      in one pass, using a table for the per-block chroma terms
          */
 
-        Pnm_ppm newImg = getRGBInts(deRGBCompVid, bMethods);
-        bMethods->free((A2Methods_UArray2 *) &deRGBCompVid);
+        Pnm_ppm newImg;
+        if (format == 7) {
+                A2Methods_T bMethods = uarray2_methods_blocked;
+                assert(bMethods != NULL);
+                stageBegin("(C3)' transformBlocksToPixels");
+                UArray2b_T RGBCompVid = transformBlocksToPixels(
+                        blocks, pMethods, bMethods, transformSize, half);
+                stageEnd();
+                pMethods->free((A2Methods_UArray2 *) &blocks);
+                stageBegin("(C2)' getRGBInts");
+                newImg = getRGBInts(RGBCompVid, bMethods);
+                bMethods->free((A2Methods_UArray2 *) &RGBCompVid);
+        } else if (half) {
+                stageBegin("(C3)'+(C2)' tableDecodeHalf");
+                newImg = tableDecodeHalf(quantInts, pMethods, &scales);
+        } else {
+                stageBegin("(C3)'+(C2)' tableDecode");
+                newImg = tableDecode(quantInts, pMethods, &scales);
+        }
+        stageEnd();
+        if (quantInts != NULL) {
+                pMethods->free((A2Methods_UArray2 *) &quantInts);
+        }
+
+        /* Drop the parts of the edge blocks outside the rectangle */
+        if (crop != NULL) {
+                newImg = cropImage(newImg, cropCol, cropRow, reportWidth,
+                                   reportHeight);
+        }
 
         /* Step (C1)': Image Operations
-         *      Write the final PPM image to standard output
+         *      Write the final PPM image to the output stream
          */
 
-        writeImage(newImg);
+        stageBegin("(C1)' writeImage");
+        writeImage(output, newImg);
+        fflush(output);
+        stageEnd();
         newImg->methods->free(&(newImg->pixels));
         free(newImg);
-        
+
+        stageReport(stderr, reportWidth, reportHeight);
 }
 
-/******** readCompressedHeader ********
+/******** pickScales ********
  *
- * Reads the required header from a compressed image file.
+ * Returns the scales to quantize with: the given ones, else ones chosen for
+ * the target from the DCT blocks and their pixels, else the defaults. Only
+ * formats 3 and 4 entropy-code the fields, so only they can trade size for
+ * error.
+ ************************/
+static struct quantScales pickScales(UArray2_T DCTSpace,
+                                     A2Methods_T pMethods,
+                                     UArray2b_T RGBCompVid,
+                                     A2Methods_T bMethods, unsigned format,
+                                     const struct quantScales *scales,
+                                     const struct rateTarget *target)
+{
+        if (scales != NULL) {
+                assert(validScales(scales));
+                return *scales;
+        }
+        if (target == NULL) {
+                return DEFAULT_SCALES;
+        }
+
+        struct rateTarget forFormat = *target;
+        forFormat.entropyCoded = format == 3 || format == 4;
+        stageBegin("C3 chooseScales");
+        struct quantScales chosen = chooseScales(DCTSpace, pMethods,
+                                                 RGBCompVid, bMethods,
+                                                 &forFormat);
+        stageEnd();
+        return chosen;
+}
+
+/******** rmsDifference ********
  *
- * Parameters:
- *      FILE *input:            File pointer to the compressed image
- *      unsigned *width:        Pointer to store the read width
- *      unsigned *height:       Pointer to store the read height
- * Returns:
- *      Nothing.
- * Expects:
- *      All parameters are not NULL.
- *      The input file has a correctly formatted header.
- * Notes:
- *      Throws a CRE if the header format does not match the spec.
+ * Returns the root mean square difference between two images of the same
+ * size, over every channel scaled to [0, 1], as ppmdiff computes it.
  ************************/
-static void readCompressedHeader(FILE *input, unsigned *width, unsigned *height)
+static double rmsDifference(Pnm_ppm first, Pnm_ppm second)
 {
-        assert(input != NULL);
-        assert(width != NULL);
-        assert(height != NULL);
-
-        /* Use fscanf with the provided string to read the header */
-        int read = fscanf(input, "COMP40 Compressed image format 2\n%u %u", 
-                          width, height);
-        assert(read == 2);
-
-        /* Verify final newline character */
-        int c = getc(input);
-        assert(c == '\n');
-}
\ No newline at end of file
+        assert(first->width == second->width);
+        assert(first->height == second->height);
+
+        double sum = 0.0;
+        for (unsigned row = 0; row < first->height; row++) {
+                for (unsigned col = 0; col < first->width; col++) {
+                        const struct Pnm_rgb *p = first->methods->at(
+                                first->pixels, col, row);
+                        const struct Pnm_rgb *q = second->methods->at(
+                                second->pixels, col, row);
+                        double dr = (double) p->red / first->denominator -
+                                    (double) q->red / second->denominator;
+                        double dg = (double) p->green / first->denominator -
+                                    (double) q->green / second->denominator;
+                        double db = (double) p->blue / first->denominator -
+                                    (double) q->blue / second->denominator;
+                        sum += dr * dr + dg * dg + db * db;
+                }
+        }
+        return sqrt(sum / (3.0 * first->width * first->height));
+}
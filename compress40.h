@@ -7,6 +7,7 @@
  *      (Given) Interface for the main compression and decompression functions.
  */
 #include <stdio.h>
+#include <stdbool.h>
 
 /*
  *  The two functions below are functions you should implement. They should take
@@ -14,4 +15,72 @@
  */
 
 extern void compress40(FILE *input);  /* reads PPM, writes compressed image */
-extern void decompress40(FILE *input);  /* reads compressed image, writes PPM */
\ No newline at end of file
+extern void decompress40(FILE *input);  /* reads compressed image, writes PPM */
+/*
+ *  Variants of the above that write to the given stream instead of stdout, so
+ *  that several images can be processed at once (see batch40.h).
+ */
+
+extern void compress40_to(FILE *input, FILE *output);
+extern void decompress40_to(FILE *input, FILE *output);
+
+/*
+ *  Compresses to the given format: 2 (raw codewords, as above), 3 (entropy
+ *  coded, see entropyCoding.h), 4 (entropy-coded tiles, see tiles.h), 5
+ *  (progressive, see progressive.h), 6 (planar, see planar.h) or 7 (8x8
+ *  transform blocks, see transformCoding.h). The decompressors accept any
+ *  of them.
+ */
+extern void compress40_format(FILE *input, FILE *output, unsigned format);
+
+/* Defined in blockOperation.h */
+struct quantScales;
+struct rateTarget;
+
+/*
+ *  Compresses to format 7 (see transformCoding.h), transforming size x size
+ *  blocks, 4 or 8; compress40_format uses 8. The second returns what
+ *  compress40_quality does, for format 7.
+ */
+extern void compress40_blocks(FILE *input, FILE *output, int size);
+extern double compress40_blocks_quality(FILE *input, int size);
+
+/*
+ *  compress40_format with quantization scales other than the defaults: the
+ *  given scales, or if scales is NULL, scales chosen for this image to meet
+ *  target (NULL for the defaults). The scales are recorded in the header.
+ */
+extern void compress40_tuned(FILE *input, FILE *output, unsigned format,
+                             const struct quantScales *scales,
+                             const struct rateTarget *target);
+
+/*
+ *  Compresses and decodes in memory, writing nothing, and returns the RMS
+ *  difference (as ppmdiff reports it) between the decoded image and the
+ *  input trimmed to even dimensions. Every format decodes to the same
+ *  pixels, so one figure covers them all. scales and target are as for
+ *  compress40_tuned; format matters only when choosing scales.
+ */
+extern double compress40_quality(FILE *input, unsigned format,
+                                 const struct quantScales *scales,
+                                 const struct rateTarget *target);
+
+/* Decompresses to half resolution (one pixel per 2x2 block) on stdout */
+extern void decompress40_half(FILE *input);
+
+/* A rectangle of output pixels */
+struct cropRect
+{
+        unsigned x, y;
+        unsigned width, height;
+};
+
+/*
+ *  General form of the decompressors above: optionally half resolution, and
+ *  optionally only a rectangle (NULL for all) of the output image, reading
+ *  just the codewords it covers. With partial, a format 5 image whose
+ *  detail plane has not all arrived is decoded anyway, its unrefined blocks
+ *  left flat; other formats are refused.
+ */
+extern void decompress40_region(FILE *input, FILE *output, bool half,
+                                bool partial, const struct cropRect *crop);
@@ -0,0 +1,265 @@
+/*
+ *      compress40mem.c
+ *      Kevin Lu (klu07), Justin Paik (jpaik03)
+ *      October 18, 2026
+ *      arith
+ * 
+ *      Implementation of the in-memory compression interface. Runs the same
+ *      steps as compress40 and decompress40, but the C1 step reads from the
+ *      caller's pixel buffer, the C4 step packs codewords into memory, and
+ *      the (C1)' step decodes straight into the caller's pixel buffer.
+ */
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <assert.h>
+
+#include "compress40mem.h"
+#include "a2methods.h"
+#include "a2plain.h"
+#include "a2blocked.h"
+#include "pixelOperation.h"
+#include "blockOperation.h"
+#include "codewords.h"
+#include "tableDecode.h"
+#include "stageTimer.h"
+
+#define BLOCKSIZE 2
+#define BYTES_PER_WORD 4
+
+static bool samplesInRange(const unsigned char *pixels, unsigned width,
+                           unsigned height, size_t stride,
+                           unsigned denominator);
+
+/******** compress40_bound ********
+ *
+ * Computes how many bytes compress40_mem may need for an image.
+ *
+ * Parameters:
+ *      unsigned width, height: Dimensions of the untrimmed image
+ * Returns:
+ *      The compressed size of the trimmed image, header included.
+ * Expects:
+ *      Nothing.
+ ************************/
+extern size_t compress40_bound(unsigned width, unsigned height)
+{
+        return compressedSize(width / BLOCKSIZE * BLOCKSIZE, 
+                              height / BLOCKSIZE * BLOCKSIZE);
+}
+
+/******** compress40_mem ********
+ *
+ * Compresses a caller-owned pixel buffer into memory.
+ *
+ * Parameters:
+ *      const unsigned char *pixels:    The first byte of the first row
+ *      unsigned width, height:         Dimensions of the image
+ *      size_t stride:                  Bytes from one row to the next
+ *      unsigned denominator:           The largest sample value
+ *      unsigned char **out:            Destination buffer, or pointer to
+ *                                        NULL to have one allocated
+ *      size_t capacity:                Size of *out if it is not NULL
+ * Returns:
+ *      The number of compressed bytes, or 0 if nothing was written: the
+ *      trimmed image is empty, does not fit in capacity, or has a sample
+ *      above denominator.
+ * Expects:
+ *      pixels and out are not NULL; denominator is in [1, 65535].
+ * Notes:
+ *      Throws a CRE if an expectation is violated.
+ *      Throws a CRE if memory allocation fails.
+ *      Every sample of the trimmed image is checked before any is packed,
+ *        since one above denominator would overflow a codeword field.
+ ************************/
+extern size_t compress40_mem(const unsigned char *pixels, unsigned width,
+                             unsigned height, size_t stride,
+                             unsigned denominator, unsigned char **out,
+                             size_t capacity)
+{
+        assert(pixels != NULL);
+        assert(out != NULL);
+
+        /* Step C1: trimming is a matter of reading fewer pixels */
+        int trimmedWidth = width / BLOCKSIZE * BLOCKSIZE;
+        int trimmedHeight = height / BLOCKSIZE * BLOCKSIZE;
+        if (trimmedWidth == 0 || trimmedHeight == 0) {
+                return 0;
+        }
+
+        size_t size = compressedSize(trimmedWidth, trimmedHeight);
+        if (*out != NULL && capacity < size) {
+                return 0;
+        }
+        assert(denominator >= 1 && denominator <= 65535);
+        if (!samplesInRange(pixels, trimmedWidth, trimmedHeight, stride,
+                            denominator)) {
+                return 0;
+        }
+
+        A2Methods_T bMethods = uarray2_methods_blocked;
+        assert(bMethods != NULL);
+        A2Methods_T pMethods = uarray2_methods_plain;
+        assert(pMethods != NULL);
+
+        /* Step C2: Pixel-level Operations */
+        stageBegin("C2 getRGBCompVidFromBuffer");
+        UArray2b_T RGBCompVid = getRGBCompVidFromBuffer(pixels, trimmedWidth,
+                                                        trimmedHeight, stride,
+                                                        denominator, 
+                                                        bMethods);
+        stageEnd();
+
+        /* Step C3: Block-level Operations */
+        stageBegin("C3 pixelsToDCTBlock");
+        UArray2_T DCTSpace = pixelsToDCTBlock(RGBCompVid, bMethods, 
+                                              pMethods);
+        stageEnd();
+        bMethods->free((A2Methods_UArray2 *) &RGBCompVid);
+
+        stageBegin("C3 quantizeValues");
+        UArray2_T quantInts = quantizeValues(DCTSpace, pMethods,
+                                             &DEFAULT_SCALES);
+        stageEnd();
+        pMethods->free((A2Methods_UArray2 *) &DCTSpace);
+
+        /* Step C4: Bit Codeword Operations, into memory */
+        if (*out == NULL) {
+                *out = malloc(size);
+                assert(*out != NULL);
+        }
+        stageBegin("C4 packWords");
+        packWords(quantInts, pMethods, *out);
+        stageEnd();
+        pMethods->free((A2Methods_UArray2 *) &quantInts);
+
+        return size;
+}
+
+/******** decompress40_info ********
+ *
+ * Reads the dimensions of a compressed image held in memory.
+ *
+ * Parameters:
+ *      const unsigned char *in:        The compressed image
+ *      size_t length:                  Number of bytes in 'in'
+ *      unsigned *width, *height:       Where to store the dimensions
+ * Returns:
+ *      1 on success, 0 if the header is malformed.
+ * Expects:
+ *      All pointers are not NULL.
+ ************************/
+extern int decompress40_info(const unsigned char *in, size_t length,
+                             unsigned *width, unsigned *height)
+{
+        struct quantScales scales;
+        return parseCompressedHeader(in, length, width, height,
+                                     &scales) != 0;
+}
+
+/******** decompress40_mem ********
+ *
+ * Decompresses an image held in memory into a pixel buffer.
+ *
+ * Parameters:
+ *      const unsigned char *in:        The compressed image
+ *      size_t length:                  Number of bytes in 'in'
+ *      unsigned char **pixels:         Destination buffer, or pointer to
+ *                                        NULL to have one allocated
+ *      size_t stride:                  Row stride of *pixels if not NULL
+ * Returns:
+ *      1 on success, 0 if 'in' is malformed or truncated.
+ * Expects:
+ *      in and pixels are not NULL.
+ *      A caller-supplied *pixels has stride >= 3 * width.
+ * Notes:
+ *      Throws a CRE if an expectation is violated.
+ *      Throws a CRE if memory allocation fails.
+ ************************/
+extern int decompress40_mem(const unsigned char *in, size_t length,
+                            unsigned char **pixels, size_t stride)
+{
+        assert(in != NULL);
+        assert(pixels != NULL);
+
+        unsigned width, height;
+        struct quantScales scales;
+        size_t header = parseCompressedHeader(in, length, &width, &height,
+                                              &scales);
+        if (header == 0) {
+                return 0;
+        }
+        size_t words = (size_t) (width / BLOCKSIZE) * (height / BLOCKSIZE);
+        if (length - header < words * BYTES_PER_WORD) {
+                return 0;
+        }
+
+        A2Methods_T pMethods = uarray2_methods_plain;
+        assert(pMethods != NULL);
+
+        /* Step (C4)': Bit Codeword Operations, from memory */
+        stageBegin("(C4)' unpackWords");
+        UArray2_T quantInts = unpackWords(in + header, pMethods, width, 
+                                          height);
+        stageEnd();
+
+        if (*pixels == NULL) {
+                stride = (size_t) width * 3;
+                *pixels = malloc(stride * height + 1);
+                assert(*pixels != NULL);
+        }
+        assert(stride >= (size_t) width * 3);
+
+        /* Steps (C3)' to (C1)': decode straight into the caller's buffer */
+        stageBegin("(C3)'+(C2)' tableDecodeToBuffer");
+        tableDecodeToBuffer(quantInts, pMethods, &scales, *pixels, stride);
+        stageEnd();
+        pMethods->free((A2Methods_UArray2 *) &quantInts);
+
+        return 1;
+}
+
+/******** samplesInRange ********
+ *
+ * Checks that no sample of a pixel buffer exceeds its denominator.
+ *
+ * Parameters:
+ *      const unsigned char *pixels:    The first byte of the first row
+ *      unsigned width, height:         The part of the image to check
+ *      size_t stride:                  Bytes from one row to the next
+ *      unsigned denominator:           The largest sample value allowed
+ * Returns:
+ *      true if every sample is at most denominator.
+ * Notes:
+ *      Samples are one byte when denominator is below 256, else two,
+ *        big-endian, so a denominator of 255 or 65535 admits any sample.
+ ************************/
+static bool samplesInRange(const unsigned char *pixels, unsigned width,
+                           unsigned height, size_t stride,
+                           unsigned denominator)
+{
+        if (denominator == 255 || denominator == 65535) {
+                return true;
+        }
+
+        size_t count = (size_t) 3 * width;
+        for (unsigned row = 0; row < height; row++) {
+                const unsigned char *samples = pixels + row * stride;
+                if (denominator < 256) {
+                        for (size_t k = 0; k < count; k++) {
+                                if (samples[k] > denominator) {
+                                        return false;
+                                }
+                        }
+                } else {
+                        for (size_t k = 0; k < count; k++) {
+                                unsigned sample = samples[2 * k] << 8 |
+                                                  samples[2 * k + 1];
+                                if (sample > denominator) {
+                                        return false;
+                                }
+                        }
+                }
+        }
+        return true;
+}
@@ -0,0 +1,50 @@
+/*
+ *      compress40mem.h
+ *      Kevin Lu (klu07), Justin Paik (jpaik03)
+ *      October 18, 2026
+ *      arith
+ * 
+ *      In-memory interface to the compressor, for programs that link the
+ *      pipeline directly instead of running 40image. Nothing here touches a
+ *      FILE * or stdout.
+ *
+ *      Pixel buffers are laid out like the raster of a raw PPM: each row is
+ *      width RGB triples, one byte per sample when the denominator is below
+ *      256 and two big-endian bytes otherwise, and consecutive rows start
+ *      'stride' bytes apart. Compressed buffers hold exactly the bytes that
+ *      40image -c would write.
+ */
+
+#include <stddef.h>
+
+/* Largest compressed size of a width x height image, header included */
+extern size_t compress40_bound(unsigned width, unsigned height);
+
+/*
+ * Compresses the pixel buffer. The image is trimmed to even dimensions.
+ * If *out is not NULL, the result is written there when it fits in
+ * 'capacity' bytes; if *out is NULL, a buffer is malloc'd, stored in *out,
+ * and must be freed by the caller. Returns the compressed size, or 0 if the
+ * trimmed image is empty, does not fit, or has a sample above denominator.
+ */
+extern size_t compress40_mem(const unsigned char *pixels, unsigned width,
+                             unsigned height, size_t stride,
+                             unsigned denominator, unsigned char **out,
+                             size_t capacity);
+
+/*
+ * Reads the dimensions from a compressed image's header. Returns 1 on
+ * success and 0 if the header is malformed.
+ */
+extern int decompress40_info(const unsigned char *in, size_t length,
+                             unsigned *width, unsigned *height);
+
+/*
+ * Decompresses into 8-bit RGB (denominator 255). If *pixels is not NULL, it
+ * must hold height rows of 'stride' >= 3 * width bytes; if *pixels is NULL,
+ * a tightly packed buffer is malloc'd, stored in *pixels, and must be freed
+ * by the caller. Returns 1 on success and 0 if the input is malformed or
+ * truncated.
+ */
+extern int decompress40_mem(const unsigned char *in, size_t length,
+                            unsigned char **pixels, size_t stride);
@@ -0,0 +1,510 @@
+/*
+ *      compressedOps.c
+ *      Kevin Lu (klu07), Justin Paik (jpaik03)
+ *      October 18, 2026
+ *      arith
+ *
+ *      Implementation of lossless transforms on compressed images.
+ *
+ *      A block's pixels are Y1 = a - b - c + d (top left), Y2 = a - b + c - d
+ *      (top right), Y3 = a + b - c - d (bottom left) and Y4 = a + b + c + d
+ *      (bottom right): b is the vertical gradient, c the horizontal one and d
+ *      the diagonal. Permuting Y1..Y4 therefore maps (b, c, d) as follows,
+ *      while a and the chroma indices are unchanged:
+ *
+ *              flip-h          ( b, -c, -d)
+ *              flip-v          (-b,  c, -d)
+ *              transpose       ( c,  b,  d)
+ *              transverse      (-c, -b,  d)
+ *              rot90           ( c, -b, -d)
+ *              rot180          (-b, -c,  d)
+ *              rot270          (-c,  b, -d)
+ *
+ *      Decoding the result gives exactly the transformed pixels of decoding
+ *      the original, since every pixel is computed, clamped and rounded the
+ *      same way.
+ *
+ *      Crop and mosaic only work one block row at a time: each output row is
+ *      assembled by reading the needed codeword runs straight into place.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "compressedOps.h"
+#include "codewords.h"
+#include "blockOperation.h"
+
+#define BLOCKSIZE 2
+#define BYTES_PER_WORD 4
+
+static const char *const transformNames[] = {
+        "flip-h", "flip-v", "transpose", "transverse", "rot90", "rot180",
+        "rot270"
+};
+
+static void transformFields(struct quantized *quant,
+                            enum transform transform);
+static void moveBlock(int col, int row, int blocksWide, int blocksHigh,
+                      enum transform transform, int *newCol, int *newRow);
+static enum transform inverseTransform(enum transform transform);
+static int negate(int coefficient);
+static void readRun(FILE *input, unsigned char *dest, size_t length);
+
+/******** parseTransform ********
+ *
+ * Looks up a transform by its command-line name: flip-h, flip-v, transpose,
+ * transverse, rot90, rot180 or rot270.
+ *
+ * Parameters:
+ *      const char *name:               The name to look up
+ *      enum transform *transform:      Where to store the transform
+ * Returns:
+ *      true if the name was recognized.
+ * Expects:
+ *      name and transform are not NULL.
+ ************************/
+bool parseTransform(const char *name, enum transform *transform)
+{
+        assert(name != NULL);
+        assert(transform != NULL);
+
+        int count = sizeof(transformNames) / sizeof(transformNames[0]);
+        for (int i = 0; i < count; i++) {
+                if (strcmp(name, transformNames[i]) == 0) {
+                        *transform = i;
+                        return true;
+                }
+        }
+        return false;
+}
+
+/******** transformCompressed ********
+ *
+ * Reads a compressed image, applies a transform to its codewords, and writes
+ * the transformed compressed image.
+ *
+ * Parameters:
+ *      FILE *input:                    The compressed image
+ *      FILE *output:                   Where to write the result
+ *      enum transform transform:       The transform to apply
+ * Returns:
+ *      true on success; false, after printing why to stderr, if the output
+ *      could not be written.
+ * Expects:
+ *      input and output are not NULL.
+ *      input points to a valid compressed image.
+ * Notes:
+ *      Throws a CRE if input or output is NULL, the header is malformed,
+ *        the codewords end early, or allocation fails.
+ *      The codewords are read once into one buffer, and the output is built
+ *        and written one block row at a time: each output block is fetched
+ *        from where the inverse transform puts it. Nothing is dequantized.
+ ************************/
+bool transformCompressed(FILE *input, FILE *output, enum transform transform)
+{
+        assert(input != NULL);
+        assert(output != NULL);
+
+        unsigned width, height;
+        struct quantScales scales;
+        readCompressedHeader(input, &width, &height, &scales);
+
+        int blocksWide = width / BLOCKSIZE;
+        int blocksHigh = height / BLOCKSIZE;
+        size_t size = (size_t) blocksWide * blocksHigh * BYTES_PER_WORD;
+
+        unsigned char *src = malloc(size + 1);
+        assert(src != NULL);
+        size_t read = fread(src, 1, size, input);
+        assert(read == size);
+
+        /* The 90-degree transforms swap the block grid's dimensions */
+        bool swapped = transform == TRANSPOSE || transform == TRANSVERSE ||
+                       transform == ROTATE_90 || transform == ROTATE_270;
+        int newBlocksWide = swapped ? blocksHigh : blocksWide;
+        int newBlocksHigh = swapped ? blocksWide : blocksHigh;
+        enum transform inverse = inverseTransform(transform);
+
+        unsigned char *rowBytes = malloc((size_t) newBlocksWide *
+                                         BYTES_PER_WORD + 1);
+        assert(rowBytes != NULL);
+
+        if (swapped) {
+                writeCompressedHeader(output, height, width, &scales);
+        } else {
+                writeCompressedHeader(output, width, height, &scales);
+        }
+        bool written = true;
+        for (int newRow = 0; newRow < newBlocksHigh && written; newRow++) {
+                for (int newCol = 0; newCol < newBlocksWide; newCol++) {
+                        int col = 0, row = 0;
+                        moveBlock(newCol, newRow, newBlocksWide,
+                                  newBlocksHigh, inverse, &col, &row);
+                        struct quantized quant;
+                        size_t from = (size_t) row * blocksWide + col;
+                        codewordFromBytes(src + from * BYTES_PER_WORD,
+                                          &quant);
+                        transformFields(&quant, transform);
+                        codewordToBytes(&quant, rowBytes +
+                                        (size_t) newCol * BYTES_PER_WORD);
+                }
+                written = fwrite(rowBytes, BYTES_PER_WORD, newBlocksWide,
+                                 output) == (size_t) newBlocksWide;
+        }
+        written = fflush(output) == 0 && written;
+        if (!written) {
+                fprintf(stderr, "could not write the transformed image\n");
+        }
+
+        free(rowBytes);
+        free(src);
+        return written;
+}
+
+/******** transformFields ********
+ *
+ * Rewrites one block's b, c and d for a transform (see the table at the top
+ * of this file). a and the chroma indices are left as they are.
+ *
+ * Parameters:
+ *      struct quantized *quant:        The block's fields, updated in place
+ *      enum transform transform:       The transform being applied
+ * Returns:
+ *      Nothing.
+ ************************/
+static void transformFields(struct quantized *quant,
+                            enum transform transform)
+{
+        int b = quant->b;
+        int c = quant->c;
+        int d = quant->d;
+
+        switch (transform) {
+        case FLIP_HORIZONTAL:
+                quant->c = negate(c);
+                quant->d = negate(d);
+                break;
+        case FLIP_VERTICAL:
+                quant->b = negate(b);
+                quant->d = negate(d);
+                break;
+        case TRANSPOSE:
+                quant->b = c;
+                quant->c = b;
+                break;
+        case TRANSVERSE:
+                quant->b = negate(c);
+                quant->c = negate(b);
+                break;
+        case ROTATE_90:
+                quant->b = c;
+                quant->c = negate(b);
+                quant->d = negate(d);
+                break;
+        case ROTATE_180:
+                quant->b = negate(b);
+                quant->c = negate(c);
+                break;
+        case ROTATE_270:
+                quant->b = negate(c);
+                quant->c = b;
+                quant->d = negate(d);
+                break;
+        }
+}
+
+/******** moveBlock ********
+ *
+ * Computes where a block ends up under a transform.
+ *
+ * Parameters:
+ *      int col, row:                   The block's position
+ *      int blocksWide, blocksHigh:     The original block grid's size
+ *      enum transform transform:       The transform being applied
+ *      int *newCol, *newRow:           Where to store the new position
+ * Returns:
+ *      Nothing.
+ ************************/
+static void moveBlock(int col, int row, int blocksWide, int blocksHigh,
+                      enum transform transform, int *newCol, int *newRow)
+{
+        int lastCol = blocksWide - 1;
+        int lastRow = blocksHigh - 1;
+
+        switch (transform) {
+        case FLIP_HORIZONTAL:
+                *newCol = lastCol - col;
+                *newRow = row;
+                break;
+        case FLIP_VERTICAL:
+                *newCol = col;
+                *newRow = lastRow - row;
+                break;
+        case TRANSPOSE:
+                *newCol = row;
+                *newRow = col;
+                break;
+        case TRANSVERSE:
+                *newCol = lastRow - row;
+                *newRow = lastCol - col;
+                break;
+        case ROTATE_90:
+                *newCol = lastRow - row;
+                *newRow = col;
+                break;
+        case ROTATE_180:
+                *newCol = lastCol - col;
+                *newRow = lastRow - row;
+                break;
+        case ROTATE_270:
+                *newCol = row;
+                *newRow = lastCol - col;
+                break;
+        }
+}
+
+/******** inverseTransform ********
+ *
+ * Returns the transform that undoes the given one: each rotation by 90
+ * degrees undoes the other, and every other transform undoes itself.
+ ************************/
+static enum transform inverseTransform(enum transform transform)
+{
+        if (transform == ROTATE_90) {
+                return ROTATE_270;
+        }
+        if (transform == ROTATE_270) {
+                return ROTATE_90;
+        }
+        return transform;
+}
+
+/******** negate ********
+ *
+ * Negates a 5-bit signed coefficient. -16 has no 5-bit negation, so it is
+ * first clamped to -15 (the quantizer never produces it anyway).
+ ************************/
+static int negate(int coefficient)
+{
+        if (coefficient < -15) {
+                coefficient = -15;
+        }
+        return -coefficient;
+}
+
+/******** cropCompressed ********
+ *
+ * Writes a rectangle of a compressed image as a compressed image of its own.
+ *
+ * Parameters:
+ *      FILE *input:                    The compressed image
+ *      FILE *output:                   Where to write the cropped image
+ *      unsigned x, y:                  Top-left corner of the rectangle
+ *      unsigned width, height:         Size of the rectangle in pixels
+ * Returns:
+ *      true on success; false, after printing why to stderr, if the
+ *      rectangle is not on even boundaries or lies outside the image, or
+ *      the output could not be written.
+ * Expects:
+ *      input and output are not NULL.
+ *      input points to a valid compressed image.
+ * Notes:
+ *      Throws a CRE if input or output is NULL, the header is malformed,
+ *        or the codewords end early.
+ *      A rectangle reaching past the image is clipped to it.
+ *      Block rows below the rectangle are never read.
+ ************************/
+bool cropCompressed(FILE *input, FILE *output, unsigned x, unsigned y,
+                    unsigned width, unsigned height)
+{
+        assert(input != NULL);
+        assert(output != NULL);
+
+        unsigned imageWidth, imageHeight;
+        struct quantScales scales;
+        readCompressedHeader(input, &imageWidth, &imageHeight, &scales);
+
+        if (x % BLOCKSIZE != 0 || y % BLOCKSIZE != 0 ||
+            width % BLOCKSIZE != 0 || height % BLOCKSIZE != 0) {
+                fprintf(stderr, "crop rectangle must lie on even "
+                        "boundaries\n");
+                return false;
+        }
+        if (x >= imageWidth || y >= imageHeight || width == 0 ||
+            height == 0) {
+                fprintf(stderr, "crop rectangle lies outside the %ux%u "
+                        "image\n", imageWidth, imageHeight);
+                return false;
+        }
+        if (width > imageWidth - x) {
+                width = imageWidth - x;
+        }
+        if (height > imageHeight - y) {
+                height = imageHeight - y;
+        }
+
+        size_t rowLength = (size_t) (imageWidth / BLOCKSIZE) * 
+                           BYTES_PER_WORD;
+        unsigned char *rowBytes = malloc(rowLength + 1);
+        assert(rowBytes != NULL);
+        const unsigned char *run = rowBytes + 
+                                   (size_t) (x / BLOCKSIZE) * BYTES_PER_WORD;
+        size_t runLength = (size_t) (width / BLOCKSIZE) * BYTES_PER_WORD;
+
+        writeCompressedHeader(output, width, height, &scales);
+        bool written = true;
+        for (unsigned row = 0; row < (y + height) / BLOCKSIZE && written;
+             row++) {
+                readRun(input, rowBytes, rowLength);
+                if (row >= y / BLOCKSIZE) {
+                        written = fwrite(run, 1, runLength, output) ==
+                                  runLength;
+                }
+        }
+        written = fflush(output) == 0 && written;
+        if (!written) {
+                fprintf(stderr, "could not write the cropped image\n");
+        }
+
+        free(rowBytes);
+        return written;
+}
+
+/******** mosaicCompressed ********
+ *
+ * Stitches compressed images into a grid, filled left to right and then top
+ * to bottom, and writes it as one compressed image.
+ *
+ * Parameters:
+ *      FILE **inputs:          The compressed images, in grid order
+ *      int count:              How many there are
+ *      int columns:            Images per grid row; count (or 0) puts them
+ *                                side by side, 1 stacks them
+ *      FILE *output:           Where to write the mosaic
+ * Returns:
+ *      true on success; false, after printing why to stderr, if the images
+ *      do not fill the grid, their sizes do not fit together, they were
+ *      quantized with different scales, or the output could not be
+ *      written.
+ * Expects:
+ *      inputs and output are not NULL, and count > 0.
+ *      Every input points to a valid compressed image.
+ * Notes:
+ *      Throws a CRE if an expectation is violated, a header is malformed,
+ *        or an input's codewords end early.
+ *      The images in a grid row must share a height, and every grid row
+ *        must have the same total width. Widths may differ within a row.
+ *      Only one block row of output is held in memory: each input's run for
+ *        that row is read straight into its place in the row.
+ ************************/
+bool mosaicCompressed(FILE **inputs, int count, int columns, FILE *output)
+{
+        assert(inputs != NULL);
+        assert(output != NULL);
+        assert(count > 0);
+
+        if (columns <= 0) {
+                columns = count;
+        }
+        if (count % columns != 0) {
+                fprintf(stderr, "%d images do not fill rows of %d\n", count,
+                        columns);
+                return false;
+        }
+        int gridRows = count / columns;
+
+        unsigned *widths = malloc(count * sizeof(unsigned));
+        unsigned *heights = malloc(count * sizeof(unsigned));
+        assert(widths != NULL && heights != NULL);
+        struct quantScales scales, first;
+        bool sameQuantizer = true;
+        for (int i = 0; i < count; i++) {
+                assert(inputs[i] != NULL);
+                readCompressedHeader(inputs[i], &widths[i], &heights[i],
+                                     &scales);
+                if (i == 0) {
+                        first = scales;
+                }
+                sameQuantizer = sameQuantizer && sameScales(&scales, &first);
+        }
+        if (!sameQuantizer) {
+                fprintf(stderr, "images were quantized with different "
+                        "scales\n");
+                free(widths);
+                free(heights);
+                return false;
+        }
+
+        /* Check that the images tile a rectangle */
+        unsigned totalWidth = 0, totalHeight = 0;
+        bool fits = true;
+        for (int gridRow = 0; gridRow < gridRows && fits; gridRow++) {
+                unsigned rowWidth = 0;
+                unsigned rowHeight = heights[gridRow * columns];
+                for (int k = gridRow * columns; k < (gridRow + 1) * columns;
+                     k++) {
+                        fits = fits && heights[k] == rowHeight;
+                        rowWidth += widths[k];
+                }
+                if (gridRow == 0) {
+                        totalWidth = rowWidth;
+                }
+                fits = fits && rowWidth == totalWidth;
+                totalHeight += rowHeight;
+        }
+        if (!fits) {
+                fprintf(stderr, "image sizes do not fit a %dx%d grid\n",
+                        columns, gridRows);
+                free(widths);
+                free(heights);
+                return false;
+        }
+
+        unsigned char *rowBytes = malloc((size_t) (totalWidth / BLOCKSIZE) *
+                                         BYTES_PER_WORD + 1);
+        assert(rowBytes != NULL);
+
+        writeCompressedHeader(output, totalWidth, totalHeight, &first);
+        bool written = true;
+        for (int gridRow = 0; gridRow < gridRows && written; gridRow++) {
+                int firstInput = gridRow * columns;
+                for (unsigned row = 0; row < heights[firstInput] / BLOCKSIZE;
+                     row++) {
+                        size_t offset = 0;
+                        for (int k = firstInput;
+                             k < firstInput + columns; k++) {
+                                size_t length = (size_t) (widths[k] / 
+                                                          BLOCKSIZE) * 
+                                                BYTES_PER_WORD;
+                                readRun(inputs[k], rowBytes + offset, 
+                                        length);
+                                offset += length;
+                        }
+                        if (fwrite(rowBytes, 1, offset, output) != offset) {
+                                written = false;
+                                break;
+                        }
+                }
+        }
+        written = fflush(output) == 0 && written;
+        if (!written) {
+                fprintf(stderr, "could not write the mosaic\n");
+        }
+
+        free(rowBytes);
+        free(widths);
+        free(heights);
+        return written;
+}
+
+/******** readRun ********
+ *
+ * Reads a run of codeword bytes, failing a CRE if the input ends first.
+ ************************/
+static void readRun(FILE *input, unsigned char *dest, size_t length)
+{
+        size_t read = fread(dest, 1, length, input);
+        assert(read == length);
+}
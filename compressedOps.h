@@ -0,0 +1,41 @@
+/*
+ *      compressedOps.h
+ *      Kevin Lu (klu07), Justin Paik (jpaik03)
+ *      October 18, 2026
+ *      arith
+ *
+ *      Interface for lossless operations on compressed images. A rotation,
+ *      flip or transpose of the image moves whole 2x2 blocks and permutes the
+ *      four pixels inside each one, which only swaps and negates the block's
+ *      b, c and d coefficients. So these run on the codewords directly,
+ *      without decoding to pixels and re-encoding.
+ *
+ *      Cropping on even boundaries and stitching images into a grid only
+ *      move whole blocks, so they copy runs of codewords and nothing else.
+ */
+
+#include <stdio.h>
+#include <stdbool.h>
+
+/*
+ *  The transforms, in the order of their command-line names: mirror left to
+ *  right, mirror top to bottom, mirror across the main diagonal, mirror
+ *  across the anti-diagonal, and rotate clockwise by 90, 180 or 270 degrees
+ */
+enum transform
+{
+        FLIP_HORIZONTAL,
+        FLIP_VERTICAL,
+        TRANSPOSE,
+        TRANSVERSE,
+        ROTATE_90,
+        ROTATE_180,
+        ROTATE_270
+};
+
+bool parseTransform(const char *name, enum transform *transform);
+bool transformCompressed(FILE *input, FILE *output, enum transform transform);
+
+bool cropCompressed(FILE *input, FILE *output, unsigned x, unsigned y,
+                    unsigned width, unsigned height);
+bool mosaicCompressed(FILE **inputs, int count, int columns, FILE *output);
@@ -0,0 +1,728 @@
+/*
+ *      entropyCoding.c
+ *      Kevin Lu (klu07), Justin Paik (jpaik03)
+ *      October 18, 2026
+ *      arith
+ *
+ *      Implementation of compressed image format 3. After the usual header
+ *      ("COMP40 Compressed image format 3\n%u %u\n") come:
+ *
+ *        - One byte naming the predictor (see predict.h) for a.
+ *        - NUM_TABLES frequency tables, each a bitmap of the symbols that
+ *          occur followed by their frequencies (minus one) as 7-bit varints.
+ *          Every non-empty table's frequencies add up to 2^SCALE_BITS.
+ *        - A 4-byte big-endian length, then that many bytes of rANS data
+ *          holding every block's fields in row-major block order.
+ *
+ *      Each field is coded with one of these tables:
+ *
+ *        - a (512 symbols): one table, of residuals from the predictor.
+ *        - b, c, d (value + 16, 32 symbols): one table per field for each
+ *          of |left| = 0, |left| = 1 and |left| >= 2, where left is the same
+ *          field of the block to the left (0 in the first column).
+ *        - indexbpb, indexbpr (16 symbols): one table per field for each
+ *          value of the same field in the block to the left.
+ *
+ *      The coder is the byte-wise rANS with a 32-bit state in [2^23, 2^31).
+ *      The decoder's fast path is one lookup per field: a 4096-entry slot
+ *      table gives the symbol with its frequency and offset, so the state
+ *      update needs no search.
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <assert.h>
+
+#include "entropyCoding.h"
+#include "codewords.h"
+#include "blockOperation.h"
+#include "predict.h"
+
+#define BLOCKSIZE 2
+#define FORMAT 3
+#define FIELDS_PER_BLOCK 6
+
+#define SCALE_BITS 12
+#define SCALE (1u << SCALE_BITS)
+#define RANS_LOW (1u << 23)
+
+#define A_BITS 9
+#define A_SYMBOLS (1 << A_BITS)
+#define COEFF_SYMBOLS 32
+#define COEFF_OFFSET 16
+#define COEFF_CONTEXTS 3
+#define CHROMA_SYMBOLS 16
+
+/* Table numbers: a, then b/c/d by context, then pb/pr by context */
+#define A_TABLE 0
+#define COEFF_TABLES 1
+#define CHROMA_TABLES (COEFF_TABLES + 3 * COEFF_CONTEXTS)
+#define NUM_TABLES (CHROMA_TABLES + 2 * CHROMA_SYMBOLS)
+
+/******** slot struct ********
+ *
+ * One entry of a decoding table: the symbol owning a slot of [0, SCALE),
+ * with its frequency and the slot's offset from the symbol's first slot.
+ ************************/
+struct slot
+{
+        uint16_t symbol;
+        uint16_t freq;
+        uint16_t offset;
+};
+
+/******** model struct ********
+ *
+ * The frequency table for one field in one context.
+ *
+ * Fields:
+ *      int numSymbols:         Size of the field's alphabet
+ *      uint32_t total:         Sum of freq (SCALE once normalized, or 0)
+ *      uint32_t freq[]:        Count, then normalized frequency, of each
+ *                                symbol
+ *      uint32_t start[]:       First slot of each symbol
+ *      struct slot *slots:     SCALE decoding entries, or NULL
+ ************************/
+struct model
+{
+        int numSymbols;
+        uint32_t total;
+        uint32_t freq[A_SYMBOLS];
+        uint32_t start[A_SYMBOLS];
+        struct slot *slots;
+};
+
+static struct model *newModels(void);
+static void freeModels(struct model *models);
+static void blockTables(const struct quantized *left, int *tables);
+static void blockSymbols(const struct quantized *quant, unsigned *symbols);
+static void normalizeModel(struct model *model);
+static void writeTables(FILE *output, struct model *models);
+static void readTables(FILE *input, struct model *models);
+static void buildSlots(struct model *model);
+static void writeVarint(FILE *output, unsigned value);
+static unsigned readVarint(FILE *input);
+static unsigned *predictLuma(UArray2_T quantInts, A2Methods_T methods,
+                             int blockCol, int blockRow, int blocksWide,
+                             int blocksHigh, enum predictor *predictor);
+static unsigned decodeSymbol(struct model *model, uint32_t *state,
+                             const unsigned char **next,
+                             const unsigned char *end);
+
+/******** printWordsEntropy ********
+ *
+ * Writes the format 3 header, then the whole image coded by
+ * entropyEncodeRegion.
+ *
+ * Parameters:
+ *      FILE *output:           The stream to write to
+ *      UArray2_T quantInts:    An array of 'quantized' structs
+ *      A2Methods_T methods:    The method suite for quantInts
+ *      const struct quantScales *scales:       The scales quantInts was
+ *                                                quantized with, for the
+ *                                                header
+ * Returns:
+ *      Nothing.
+ * Expects:
+ *      output, quantInts and methods are not NULL.
+ * Notes:
+ *      Throws a CRE if an argument is NULL or allocation fails.
+ ************************/
+void printWordsEntropy(FILE *output, UArray2_T quantInts,
+                       A2Methods_T methods, const struct quantScales *scales)
+{
+        assert(output != NULL);
+        assert(quantInts != NULL);
+        assert(methods != NULL);
+
+        int blocksWide = methods->width(quantInts);
+        int blocksHigh = methods->height(quantInts);
+        writeFormatHeader(output, FORMAT, blocksWide * BLOCKSIZE,
+                          blocksHigh * BLOCKSIZE, scales);
+        entropyEncodeRegion(output, quantInts, methods, 0, 0, blocksWide,
+                            blocksHigh);
+}
+
+/******** entropyEncodeRegion ********
+ *
+ * Writes the predictor for a, the frequency tables, and every block's
+ * fields as rANS-coded data, for one rectangle of blocks. This is
+ * everything in format 3 after the header, so it can also code a part of
+ * an image on its own.
+ *
+ * Parameters:
+ *      FILE *output:           The stream to write to
+ *      UArray2_T quantInts:    An array of 'quantized' structs
+ *      A2Methods_T methods:    The method suite for quantInts
+ *      int blockCol:           First block column of the rectangle
+ *      int blockRow:           First block row of the rectangle
+ *      int blocksWide:         Width of the rectangle in blocks
+ *      int blocksHigh:         Height of the rectangle in blocks
+ * Returns:
+ *      Nothing.
+ * Expects:
+ *      output, quantInts and methods are not NULL.
+ *      The rectangle lies inside quantInts.
+ * Notes:
+ *      Throws a CRE if an argument is NULL or allocation fails.
+ *      Makes two passes: one collecting symbols and counting them, then one
+ *        coding them in reverse, as rANS requires. Before those, picks the
+ *        predictor for a whose residuals code smallest.
+ *      Only reads quantInts, so several threads may code disjoint (or
+ *        overlapping) rectangles at once.
+ ************************/
+void entropyEncodeRegion(FILE *output, UArray2_T quantInts,
+                         A2Methods_T methods, int blockCol, int blockRow,
+                         int blocksWide, int blocksHigh)
+{
+        assert(output != NULL);
+        assert(quantInts != NULL);
+        assert(methods != NULL);
+        assert(blockCol >= 0 && blockRow >= 0);
+        assert(blockCol + blocksWide <= methods->width(quantInts));
+        assert(blockRow + blocksHigh <= methods->height(quantInts));
+
+        size_t count = (size_t) blocksWide * blocksHigh * FIELDS_PER_BLOCK;
+
+        uint16_t *symbols = malloc(count * sizeof(uint16_t) + 1);
+        unsigned char *tables = malloc(count + 1);
+        struct model *models = newModels();
+        assert(symbols != NULL && tables != NULL);
+
+        enum predictor predictor;
+        unsigned *lumaResiduals = predictLuma(quantInts, methods, blockCol,
+                                              blockRow, blocksWide,
+                                              blocksHigh, &predictor);
+
+        /* Pass 1: every field's symbol and table, and the counts */
+        const struct quantized zero = { 0, 0, 0, 0, 0, 0 };
+        size_t i = 0;
+        for (int row = 0; row < blocksHigh; row++) {
+                const struct quantized *left = &zero;
+                for (int col = 0; col < blocksWide; col++) {
+                        const struct quantized *quant =
+                                methods->at(quantInts, blockCol + col,
+                                            blockRow + row);
+                        int blockTable[FIELDS_PER_BLOCK];
+                        unsigned blockSymbol[FIELDS_PER_BLOCK];
+                        blockTables(left, blockTable);
+                        blockSymbols(quant, blockSymbol);
+                        blockSymbol[0] = lumaResiduals[(size_t) row *
+                                                       blocksWide + col];
+                        for (int k = 0; k < FIELDS_PER_BLOCK; k++, i++) {
+                                tables[i] = blockTable[k];
+                                symbols[i] = blockSymbol[k];
+                                models[blockTable[k]]
+                                        .freq[blockSymbol[k]]++;
+                        }
+                        left = quant;
+                }
+        }
+        for (int t = 0; t < NUM_TABLES; t++) {
+                normalizeModel(&models[t]);
+        }
+
+        /* Pass 2: rANS runs backwards, so the data is built from its end.
+         * A symbol emits at most 2 bytes, and the final state 4 more. */
+        size_t capacity = count * 2 + 4;
+        unsigned char *buffer = malloc(capacity + 1);
+        assert(buffer != NULL);
+        unsigned char *next = buffer + capacity;
+        uint32_t state = RANS_LOW;
+        while (i-- > 0) {
+                struct model *model = &models[tables[i]];
+                uint32_t freq = model->freq[symbols[i]];
+                uint32_t limit = ((RANS_LOW >> SCALE_BITS) << 8) * freq;
+                while (state >= limit) {
+                        *--next = state & 0xFF;
+                        state >>= 8;
+                }
+                state = ((state / freq) << SCALE_BITS) + (state % freq) +
+                        model->start[symbols[i]];
+        }
+        next -= 4;
+        next[0] = state >> 24;
+        next[1] = state >> 16;
+        next[2] = state >> 8;
+        next[3] = state;
+        size_t length = buffer + capacity - next;
+
+        putc(predictor, output);
+        writeTables(output, models);
+        unsigned char lengthBytes[4] = { length >> 24, length >> 16,
+                                         length >> 8, length };
+        fwrite(lengthBytes, 1, 4, output);
+        fwrite(next, 1, length, output);
+
+        free(buffer);
+        free(lumaResiduals);
+        free(symbols);
+        free(tables);
+        freeModels(models);
+}
+
+/******** readWordsEntropy ********
+ *
+ * Reads format 3 data and unpacks every block's fields.
+ *
+ * Parameters:
+ *      FILE *input:            File pointer positioned after the header
+ *      A2Methods_T methods:    The method suite for array operations
+ *      unsigned width:         The width of the image in pixels
+ *      unsigned height:        The height of the image in pixels
+ * Returns:
+ *      A UArray2_T where each element is a 'quantized' struct.
+ * Expects:
+ *      input and methods are not NULL.
+ * Notes:
+ *      Throws a CRE if input or methods is NULL or allocation fails.
+ *      Throws a CRE if a table is malformed, the data ends early, or a field
+ *        uses a table that has no symbols.
+ ************************/
+UArray2_T readWordsEntropy(FILE *input, A2Methods_T methods, unsigned width,
+                           unsigned height)
+{
+        assert(input != NULL);
+        assert(methods != NULL);
+
+        int blocksWide = width / BLOCKSIZE;
+        int blocksHigh = height / BLOCKSIZE;
+        UArray2_T quantInts = methods->new(blocksWide, blocksHigh,
+                                           sizeof(struct quantized));
+        assert(quantInts != NULL);
+        entropyDecodeRegion(input, quantInts, methods, 0, 0, blocksWide,
+                            blocksHigh);
+        return quantInts;
+}
+
+/******** entropyDecodeRegion ********
+ *
+ * Reads what entropyEncodeRegion wrote and unpacks every block's fields
+ * into a rectangle of an existing array.
+ *
+ * Parameters:
+ *      FILE *input:            The stream to read from
+ *      UArray2_T quantInts:    The array of 'quantized' structs to fill
+ *      A2Methods_T methods:    The method suite for quantInts
+ *      int blockCol:           First block column of the rectangle
+ *      int blockRow:           First block row of the rectangle
+ *      int blocksWide:         Width of the rectangle in blocks
+ *      int blocksHigh:         Height of the rectangle in blocks
+ * Returns:
+ *      Nothing.
+ * Expects:
+ *      input, quantInts and methods are not NULL.
+ *      The rectangle lies inside quantInts and has the size it was coded
+ *        with.
+ * Notes:
+ *      Throws a CRE if an argument is NULL or allocation fails.
+ *      Throws a CRE if a table is malformed, the data ends early, or a field
+ *        uses a table that has no symbols.
+ *      Only writes the rectangle, so several threads may decode disjoint
+ *        rectangles of one array at once.
+ ************************/
+void entropyDecodeRegion(FILE *input, UArray2_T quantInts,
+                         A2Methods_T methods, int blockCol, int blockRow,
+                         int blocksWide, int blocksHigh)
+{
+        assert(input != NULL);
+        assert(quantInts != NULL);
+        assert(methods != NULL);
+        assert(blockCol >= 0 && blockRow >= 0);
+        assert(blockCol + blocksWide <= methods->width(quantInts));
+        assert(blockRow + blocksHigh <= methods->height(quantInts));
+
+        int predictor = getc(input);
+        assert(predictor >= 0 && predictor < NUM_PREDICTORS);
+        struct model *models = newModels();
+        readTables(input, models);
+
+        unsigned char lengthBytes[4];
+        size_t read = fread(lengthBytes, 1, 4, input);
+        assert(read == 4);
+        size_t length = (size_t) lengthBytes[0] << 24 |
+                        (size_t) lengthBytes[1] << 16 |
+                        (size_t) lengthBytes[2] << 8 | lengthBytes[3];
+        assert(length >= 4);
+        unsigned char *data = malloc(length);
+        assert(data != NULL);
+        read = fread(data, 1, length, input);
+        assert(read == length);
+
+        const unsigned char *next = data + 4;
+        const unsigned char *end = data + length;
+        uint32_t state = (uint32_t) data[0] << 24 | (uint32_t) data[1] << 16 |
+                         (uint32_t) data[2] << 8 | data[3];
+
+        /* This row's a residuals, then values, and the row above's values */
+        unsigned *luma = malloc(2 * blocksWide * sizeof(unsigned) + 1);
+        assert(luma != NULL);
+        unsigned *lumaRow = luma;
+        unsigned *lumaUp = NULL;
+
+        const struct quantized zero = { 0, 0, 0, 0, 0, 0 };
+        for (int row = 0; row < blocksHigh; row++) {
+                const struct quantized *left = &zero;
+                for (int col = 0; col < blocksWide; col++) {
+                        int t[FIELDS_PER_BLOCK];
+                        blockTables(left, t);
+
+                        struct quantized *quant =
+                                methods->at(quantInts, blockCol + col,
+                                            blockRow + row);
+                        lumaRow[col] = decodeSymbol(&models[t[0]], &state,
+                                                    &next, end);
+                        quant->b = (int) decodeSymbol(&models[t[1]], &state,
+                                                      &next, end) -
+                                   COEFF_OFFSET;
+                        quant->c = (int) decodeSymbol(&models[t[2]], &state,
+                                                      &next, end) -
+                                   COEFF_OFFSET;
+                        quant->d = (int) decodeSymbol(&models[t[3]], &state,
+                                                      &next, end) -
+                                   COEFF_OFFSET;
+                        quant->indexbpb = decodeSymbol(&models[t[4]], &state,
+                                                       &next, end);
+                        quant->indexbpr = decodeSymbol(&models[t[5]], &state,
+                                                       &next, end);
+                        left = quant;
+                }
+
+                unpredictRow(lumaUp, lumaRow, blocksWide, A_BITS, predictor);
+                for (int col = 0; col < blocksWide; col++) {
+                        struct quantized *quant =
+                                methods->at(quantInts, blockCol + col,
+                                            blockRow + row);
+                        quant->a = lumaRow[col];
+                }
+                lumaUp = lumaRow;
+                lumaRow = lumaRow == luma ? luma + blocksWide : luma;
+        }
+
+        free(luma);
+        free(data);
+        freeModels(models);
+}
+
+/******** predictLuma ********
+ *
+ * Chooses the predictor for the a values of a rectangle of blocks and
+ * computes their residuals.
+ *
+ * Parameters:
+ *      UArray2_T quantInts:            An array of 'quantized' structs
+ *      A2Methods_T methods:            The method suite for quantInts
+ *      int blockCol, blockRow:         First block of the rectangle
+ *      int blocksWide, blocksHigh:     Size of the rectangle in blocks
+ *      enum predictor *predictor:      Where to store the chosen predictor
+ * Returns:
+ *      The residuals in row-major block order, to be freed by the caller.
+ ************************/
+static unsigned *predictLuma(UArray2_T quantInts, A2Methods_T methods,
+                             int blockCol, int blockRow, int blocksWide,
+                             int blocksHigh, enum predictor *predictor)
+{
+        size_t count = (size_t) blocksWide * blocksHigh;
+
+        unsigned *values = malloc(count * sizeof(unsigned) + 1);
+        unsigned *residuals = malloc(count * sizeof(unsigned) + 1);
+        assert(values != NULL && residuals != NULL);
+        for (int row = 0; row < blocksHigh; row++) {
+                for (int col = 0; col < blocksWide; col++) {
+                        const struct quantized *quant =
+                                methods->at(quantInts, blockCol + col,
+                                            blockRow + row);
+                        values[(size_t) row * blocksWide + col] = quant->a;
+                }
+        }
+
+        *predictor = choosePredictor(values, blocksWide, blocksHigh, A_BITS);
+        for (int row = 0; row < blocksHigh; row++) {
+                size_t offset = (size_t) row * blocksWide;
+                predictRow(row > 0 ? values + offset - blocksWide : NULL,
+                           values + offset, residuals + offset, blocksWide,
+                           A_BITS, *predictor);
+        }
+
+        free(values);
+        return residuals;
+}
+
+/******** newModels ********
+ *
+ * Allocates all NUM_TABLES models, empty, with their alphabet sizes set.
+ ************************/
+static struct model *newModels(void)
+{
+        struct model *models = calloc(NUM_TABLES, sizeof(struct model));
+        assert(models != NULL);
+
+        models[A_TABLE].numSymbols = A_SYMBOLS;
+        for (int t = COEFF_TABLES; t < CHROMA_TABLES; t++) {
+                models[t].numSymbols = COEFF_SYMBOLS;
+        }
+        for (int t = CHROMA_TABLES; t < NUM_TABLES; t++) {
+                models[t].numSymbols = CHROMA_SYMBOLS;
+        }
+        return models;
+}
+
+/******** freeModels ********
+ *
+ * Frees the models and their decoding tables.
+ ************************/
+static void freeModels(struct model *models)
+{
+        for (int t = 0; t < NUM_TABLES; t++) {
+                free(models[t].slots);
+        }
+        free(models);
+}
+
+/******** blockTables ********
+ *
+ * Chooses the table for each of a block's six fields from the block to its
+ * left.
+ *
+ * Parameters:
+ *      const struct quantized *left:   The block to the left (all zero in
+ *                                        the first column)
+ *      int *tables:                    Where to store the six table numbers
+ * Returns:
+ *      Nothing.
+ ************************/
+static void blockTables(const struct quantized *left, int *tables)
+{
+        int leftCoeffs[3] = { left->b, left->c, left->d };
+
+        tables[0] = A_TABLE;
+        for (int field = 0; field < 3; field++) {
+                int magnitude = abs(leftCoeffs[field]);
+                int context = magnitude < COEFF_CONTEXTS - 1 ?
+                              magnitude : COEFF_CONTEXTS - 1;
+                tables[1 + field] = COEFF_TABLES + field * COEFF_CONTEXTS +
+                                    context;
+        }
+        tables[4] = CHROMA_TABLES + left->indexbpb;
+        tables[5] = CHROMA_TABLES + CHROMA_SYMBOLS + left->indexbpr;
+}
+
+/******** blockSymbols ********
+ *
+ * Turns a block's six fields into symbols: a and the chroma indices as they
+ * are, and b, c, d offset to be non-negative.
+ ************************/
+static void blockSymbols(const struct quantized *quant, unsigned *symbols)
+{
+        symbols[0] = quant->a;
+        symbols[1] = quant->b + COEFF_OFFSET;
+        symbols[2] = quant->c + COEFF_OFFSET;
+        symbols[3] = quant->d + COEFF_OFFSET;
+        symbols[4] = quant->indexbpb;
+        symbols[5] = quant->indexbpr;
+}
+
+/******** normalizeModel ********
+ *
+ * Scales a model's counts so they add up to SCALE, keeping every symbol
+ * that occurred at a frequency of at least 1, and fills in start.
+ *
+ * Parameters:
+ *      struct model *model:    The model, holding counts
+ * Returns:
+ *      Nothing.
+ * Notes:
+ *      Leaves a model with no counts empty (total 0).
+ ************************/
+static void normalizeModel(struct model *model)
+{
+        uint64_t count = 0;
+        for (int s = 0; s < model->numSymbols; s++) {
+                count += model->freq[s];
+        }
+        if (count == 0) {
+                return;
+        }
+
+        uint32_t total = 0;
+        for (int s = 0; s < model->numSymbols; s++) {
+                if (model->freq[s] > 0) {
+                        uint32_t scaled = model->freq[s] * (uint64_t) SCALE /
+                                          count;
+                        model->freq[s] = scaled > 0 ? scaled : 1;
+                        total += model->freq[s];
+                }
+        }
+
+        /* Rounding leaves total a little off SCALE; the most frequent
+         * symbols absorb the difference, where it costs the least */
+        while (total != SCALE) {
+                int largest = 0;
+                for (int s = 1; s < model->numSymbols; s++) {
+                        if (model->freq[s] > model->freq[largest]) {
+                                largest = s;
+                        }
+                }
+                if (total < SCALE) {
+                        model->freq[largest] += SCALE - total;
+                        total = SCALE;
+                } else {
+                        uint32_t excess = total - SCALE;
+                        uint32_t spare = model->freq[largest] - 1;
+                        uint32_t taken = excess < spare ? excess : spare;
+                        assert(taken > 0);
+                        model->freq[largest] -= taken;
+                        total -= taken;
+                }
+        }
+
+        uint32_t start = 0;
+        for (int s = 0; s < model->numSymbols; s++) {
+                model->start[s] = start;
+                start += model->freq[s];
+        }
+        model->total = SCALE;
+}
+
+/******** writeTables ********
+ *
+ * Writes every model's normalized frequencies: a bitmap of which symbols
+ * occur, then each occurring symbol's frequency minus one as a varint.
+ ************************/
+static void writeTables(FILE *output, struct model *models)
+{
+        for (int t = 0; t < NUM_TABLES; t++) {
+                struct model *model = &models[t];
+                for (int s = 0; s < model->numSymbols; s += 8) {
+                        unsigned char bits = 0;
+                        for (int k = 0; k < 8; k++) {
+                                if (model->freq[s + k] > 0) {
+                                        bits |= 1 << k;
+                                }
+                        }
+                        putc(bits, output);
+                }
+                for (int s = 0; s < model->numSymbols; s++) {
+                        if (model->freq[s] > 0) {
+                                writeVarint(output, model->freq[s] - 1);
+                        }
+                }
+        }
+}
+
+/******** readTables ********
+ *
+ * Reads what writeTables wrote and builds the decoding table of every model
+ * that has symbols.
+ *
+ * Notes:
+ *      Throws a CRE if the input ends early or a non-empty table's
+ *        frequencies do not add up to SCALE.
+ ************************/
+static void readTables(FILE *input, struct model *models)
+{
+        for (int t = 0; t < NUM_TABLES; t++) {
+                struct model *model = &models[t];
+                unsigned char present[A_SYMBOLS / 8];
+                int bytes = model->numSymbols / 8;
+                size_t read = fread(present, 1, bytes, input);
+                assert(read == (size_t) bytes);
+
+                uint32_t start = 0;
+                for (int s = 0; s < model->numSymbols; s++) {
+                        model->start[s] = start;
+                        if (present[s / 8] & (1 << (s % 8))) {
+                                model->freq[s] = readVarint(input) + 1;
+                                assert(model->freq[s] <= SCALE);
+                                start += model->freq[s];
+                                assert(start <= SCALE);
+                        }
+                }
+                assert(start == 0 || start == SCALE);
+                model->total = start;
+                if (start == SCALE) {
+                        buildSlots(model);
+                }
+        }
+}
+
+/******** buildSlots ********
+ *
+ * Builds a model's decoding table: the entry for every slot in [0, SCALE).
+ ************************/
+static void buildSlots(struct model *model)
+{
+        model->slots = malloc(SCALE * sizeof(struct slot));
+        assert(model->slots != NULL);
+
+        for (int s = 0; s < model->numSymbols; s++) {
+                for (uint32_t k = 0; k < model->freq[s]; k++) {
+                        struct slot *slot = &model->slots[model->start[s] + k];
+                        slot->symbol = s;
+                        slot->freq = model->freq[s];
+                        slot->offset = k;
+                }
+        }
+}
+
+/******** writeVarint ********
+ *
+ * Writes a value 7 bits at a time, low bits first, with the top bit of
+ * each byte set when more bytes follow.
+ ************************/
+static void writeVarint(FILE *output, unsigned value)
+{
+        while (value >= 0x80) {
+                putc((value & 0x7F) | 0x80, output);
+                value >>= 7;
+        }
+        putc(value, output);
+}
+
+/******** readVarint ********
+ *
+ * Reads a value written by writeVarint. Throws a CRE at end of file.
+ ************************/
+static unsigned readVarint(FILE *input)
+{
+        unsigned value = 0;
+        for (int shift = 0; shift < 32; shift += 7) {
+                int c = getc(input);
+                assert(c != EOF);
+                value |= (unsigned) (c & 0x7F) << shift;
+                if ((c & 0x80) == 0) {
+                        break;
+                }
+        }
+        return value;
+}
+
+/******** decodeSymbol ********
+ *
+ * Decodes one symbol with a model and renormalizes the rANS state.
+ *
+ * Parameters:
+ *      struct model *model:            The field's table
+ *      uint32_t *state:                The rANS state
+ *      const unsigned char **next:     The next unread byte of data
+ *      const unsigned char *end:       The end of the data
+ * Returns:
+ *      The decoded symbol.
+ * Notes:
+ *      Throws a CRE if the model is empty or the data runs out.
+ ************************/
+static unsigned decodeSymbol(struct model *model, uint32_t *state,
+                             const unsigned char **next,
+                             const unsigned char *end)
+{
+        assert(model->slots != NULL);
+
+        const struct slot *slot = &model->slots[*state & (SCALE - 1)];
+        *state = slot->freq * (*state >> SCALE_BITS) + slot->offset;
+        while (*state < RANS_LOW) {
+                assert(*next < end);
+                *state = (*state << 8) | *(*next)++;
+        }
+        return slot->symbol;
+}
@@ -0,0 +1,41 @@
+/*
+ *      entropyCoding.h
+ *      Kevin Lu (klu07), Justin Paik (jpaik03)
+ *      October 18, 2026
+ *      arith
+ *
+ *      Interface for compressed image format 3, an entropy-coded alternative
+ *      to the raw 32-bit codewords of format 2. The six quantized fields of
+ *      every block are coded with rANS using frequency tables built for the
+ *      image: a as its residual from a spatial predictor (see predict.h),
+ *      and b, c, d and the chroma indices in the context of the block to
+ *      their left. Format 3 holds exactly the same quantized values as
+ *      format 2, so it decodes to the same pixels.
+ */
+
+#include <stdio.h>
+
+#include "uarray2.h"
+#include "a2methods.h"
+
+/* Defined in blockOperation.h */
+struct quantScales;
+
+/* Compression: writes the header too */
+void printWordsEntropy(FILE *output, UArray2_T quantInts,
+                       A2Methods_T methods, const struct quantScales *scales);
+
+/* Decompression: input is positioned just past the header */
+UArray2_T readWordsEntropy(FILE *input, A2Methods_T methods, unsigned width,
+                           unsigned height);
+
+/*
+ *  The coded data alone (no header) for a rectangle of blocks, which can be
+ *  decoded independently of the rest of the image (see tiles.h).
+ */
+void entropyEncodeRegion(FILE *output, UArray2_T quantInts,
+                         A2Methods_T methods, int blockCol, int blockRow,
+                         int blocksWide, int blocksHigh);
+void entropyDecodeRegion(FILE *input, UArray2_T quantInts,
+                         A2Methods_T methods, int blockCol, int blockRow,
+                         int blocksWide, int blocksHigh);
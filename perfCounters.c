@@ -0,0 +1,322 @@
+/*
+ *      perfCounters.c
+ *      Kevin Lu (klu07), Justin Paik (jpaik03)
+ *      October 18, 2026
+ *      arith
+ * 
+ *      Implementation of per-stage hardware performance counters. Each
+ *      thread opens its own counters (one perf_event_open file descriptor
+ *      per event, counting user-space work of that thread only) the first
+ *      time it starts a stage, and they are closed when the thread exits.
+ *      Counters are reset and enabled when a stage starts and disabled and
+ *      read when it stops. Events the CPU or kernel does not support are
+ *      reported as "n/a" rather than failing the job.
+ */
+
+#include <string.h>
+#include <errno.h>
+#include <assert.h>
+#include <pthread.h>
+
+#include "perfCounters.h"
+
+#ifdef __linux__
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+/* Initialize helper functions, see function contracts below */
+static void openCounters(void);
+static void createCloseKey(void);
+static void closeCounters(void *cl);
+static void printRatio(FILE *out, bool valid, double numerator, 
+                       double denominator);
+
+static bool enabled = false;
+
+/* This thread's counter descriptors; -1 where an event is unavailable */
+static __thread int fds[NUM_PERF_EVENTS];
+static __thread bool opened = false;
+
+/* Each counter's total enabled and running times when its stage started */
+static __thread uint64_t startEnabled[NUM_PERF_EVENTS];
+static __thread uint64_t startRunning[NUM_PERF_EVENTS];
+
+/* Its destructor closes a thread's counters when the thread exits */
+static pthread_key_t closeKey;
+static pthread_once_t closeKeyOnce = PTHREAD_ONCE_INIT;
+
+#ifdef __linux__
+
+/******** eventConfig struct ********
+ *
+ * The perf_event_attr type and config selecting one perfEvent.
+ ************************/
+struct eventConfig
+{
+        uint32_t type;
+        uint64_t config;
+};
+
+/* Indexed by enum perfEvent */
+static const struct eventConfig configs[NUM_PERF_EVENTS] = {
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+        { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D |
+                              (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                              (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+        { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_LL |
+                              (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                              (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+        { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB |
+                              (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                              (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+};
+
+#endif
+
+/******** perfCountersEnable ********
+ *
+ * Turns on counter collection for every subsequent stage in this process.
+ * Prints a warning to stderr if the calling thread cannot open any counter.
+ ************************/
+void perfCountersEnable(void)
+{
+        enabled = true;
+        openCounters();
+
+        for (int i = 0; i < NUM_PERF_EVENTS; i++) {
+                if (fds[i] >= 0) {
+                        return;
+                }
+        }
+        fprintf(stderr, "perf counters unavailable: %s "
+                "(check /proc/sys/kernel/perf_event_paranoid)\n",
+                strerror(errno));
+}
+
+/******** perfCountersEnabled ********
+ *
+ * Returns true if counter collection is turned on.
+ ************************/
+bool perfCountersEnabled(void)
+{
+        return enabled;
+}
+
+/******** perfCountersStart ********
+ *
+ * Resets and enables the calling thread's counters at the start of a stage.
+ *
+ * Parameters:
+ *      None.
+ * Returns:
+ *      Nothing.
+ * Expects:
+ *      Nothing.
+ * Notes:
+ *      Opens the thread's counters on first use.
+ *      Does nothing if collection is off.
+ *      A reset zeroes only the count, so the enabled and running times are
+ *        recorded here for perfCountersStop to take differences of.
+ ************************/
+void perfCountersStart(void)
+{
+        if (!enabled) {
+                return;
+        }
+        openCounters();
+
+#ifdef __linux__
+        for (int i = 0; i < NUM_PERF_EVENTS; i++) {
+                if (fds[i] < 0) {
+                        continue;
+                }
+                ioctl(fds[i], PERF_EVENT_IOC_RESET, 0);
+
+                /* value, time enabled, time running */
+                uint64_t data[3] = { 0, 0, 0 };
+                if (read(fds[i], data, sizeof(data)) != sizeof(data)) {
+                        data[1] = data[2] = 0;
+                }
+                startEnabled[i] = data[1];
+                startRunning[i] = data[2];
+                ioctl(fds[i], PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+}
+
+/******** perfCountersStop ********
+ *
+ * Disables the calling thread's counters and reads them.
+ *
+ * Parameters:
+ *      struct perfReading *reading:    Where the counts are stored
+ * Returns:
+ *      Nothing.
+ * Expects:
+ *      reading is not NULL.
+ *      perfCountersStart was called earlier on this thread.
+ * Notes:
+ *      Counts are scaled by the stage's enabled/running time when the
+ *        kernel had to multiplex counters.
+ ************************/
+void perfCountersStop(struct perfReading *reading)
+{
+        assert(reading != NULL);
+        memset(reading, 0, sizeof(*reading));
+
+        if (!enabled || !opened) {
+                return;
+        }
+
+#ifdef __linux__
+        for (int i = 0; i < NUM_PERF_EVENTS; i++) {
+                if (fds[i] < 0) {
+                        continue;
+                }
+                ioctl(fds[i], PERF_EVENT_IOC_DISABLE, 0);
+
+                /* value, time enabled, time running */
+                uint64_t data[3];
+                if (read(fds[i], data, sizeof(data)) != sizeof(data)) {
+                        continue;
+                }
+                uint64_t timeEnabled = data[1] - startEnabled[i];
+                uint64_t timeRunning = data[2] - startRunning[i];
+                if (timeRunning == 0) {
+                        continue;
+                }
+                reading->values[i] = (uint64_t) ((double) data[0] *
+                                                 timeEnabled / timeRunning);
+                reading->valid[i] = true;
+        }
+#endif
+}
+
+/******** perfCountersPrintHeader ********
+ *
+ * Prints the column headings matching perfCountersPrint.
+ ************************/
+void perfCountersPrintHeader(FILE *out)
+{
+        assert(out != NULL);
+        fprintf(out, "  %-28s %9s %9s %9s %9s %9s %9s\n", "stage", "IPC",
+                "cyc/px", "L1D/px", "LLC/px", "brmis/px", "dTLB/px");
+}
+
+/******** perfCountersPrint ********
+ *
+ * Prints one stage's IPC and per-pixel counts on one line.
+ *
+ * Parameters:
+ *      FILE *out:                              Where to print
+ *      const char *name:                       The stage's label
+ *      const struct perfReading *reading:      The stage's counts
+ *      double pixels:                          Pixels processed by the stage
+ * Returns:
+ *      Nothing.
+ * Expects:
+ *      out, name and reading are not NULL; pixels > 0.
+ ************************/
+void perfCountersPrint(FILE *out, const char *name, 
+                       const struct perfReading *reading, double pixels)
+{
+        assert(out != NULL && name != NULL && reading != NULL);
+
+        const uint64_t *v = reading->values;
+        const bool *ok = reading->valid;
+
+        fprintf(out, "  %-28s", name);
+        printRatio(out, ok[PERF_INSTRUCTIONS] && ok[PERF_CYCLES],
+                   v[PERF_INSTRUCTIONS], v[PERF_CYCLES]);
+        printRatio(out, ok[PERF_CYCLES], v[PERF_CYCLES], pixels);
+        printRatio(out, ok[PERF_L1D_MISSES], v[PERF_L1D_MISSES], pixels);
+        printRatio(out, ok[PERF_LLC_MISSES], v[PERF_LLC_MISSES], pixels);
+        printRatio(out, ok[PERF_BRANCH_MISSES], v[PERF_BRANCH_MISSES], 
+                   pixels);
+        printRatio(out, ok[PERF_DTLB_MISSES], v[PERF_DTLB_MISSES], pixels);
+        fprintf(out, "\n");
+}
+
+/******** printRatio ********
+ *
+ * Prints numerator / denominator in a report column, or "n/a".
+ ************************/
+static void printRatio(FILE *out, bool valid, double numerator, 
+                       double denominator)
+{
+        if (valid && denominator > 0) {
+                fprintf(out, " %9.4f", numerator / denominator);
+        } else {
+                fprintf(out, " %9s", "n/a");
+        }
+}
+
+/******** openCounters ********
+ *
+ * Opens one counter per perfEvent for the calling thread, if not done yet.
+ * Each counter is created disabled and counts user-space work only.
+ ************************/
+static void openCounters(void)
+{
+        if (opened) {
+                return;
+        }
+        opened = true;
+
+        for (int i = 0; i < NUM_PERF_EVENTS; i++) {
+                fds[i] = -1;
+        }
+
+#ifdef __linux__
+        for (int i = 0; i < NUM_PERF_EVENTS; i++) {
+                struct perf_event_attr attr;
+                memset(&attr, 0, sizeof(attr));
+                attr.size = sizeof(attr);
+                attr.type = configs[i].type;
+                attr.config = configs[i].config;
+                attr.disabled = 1;
+                attr.exclude_kernel = 1;
+                attr.exclude_hv = 1;
+                attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED |
+                                   PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+                fds[i] = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+        }
+        pthread_once(&closeKeyOnce, createCloseKey);
+        pthread_setspecific(closeKey, fds);
+#else
+        errno = ENOSYS;
+#endif
+}
+
+/******** createCloseKey ********
+ *
+ * Creates the thread-specific key whose destructor is closeCounters.
+ ************************/
+static void createCloseKey(void)
+{
+        pthread_key_create(&closeKey, closeCounters);
+}
+
+/******** closeCounters ********
+ *
+ * Key destructor, run as a thread that opened counters exits: closes that
+ * thread's counter descriptors. cl is the thread's fds array.
+ ************************/
+static void closeCounters(void *cl)
+{
+        int *threadFds = cl;
+        for (int i = 0; i < NUM_PERF_EVENTS; i++) {
+                if (threadFds[i] >= 0) {
+#ifdef __linux__
+                        close(threadFds[i]);
+#endif
+                        threadFds[i] = -1;
+                }
+        }
+}
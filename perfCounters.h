@@ -0,0 +1,50 @@
+/*
+ *      perfCounters.h
+ *      Kevin Lu (klu07), Justin Paik (jpaik03)
+ *      October 18, 2026
+ *      arith
+ * 
+ *      Interface for hardware performance counters around pipeline stages.
+ *      On Linux the counters come from perf_event_open; elsewhere, or when
+ *      the kernel refuses access, every reading is marked unavailable.
+ */
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/* The counters collected for every stage, in report order */
+enum perfEvent
+{
+        PERF_CYCLES,
+        PERF_INSTRUCTIONS,
+        PERF_L1D_MISSES,
+        PERF_LLC_MISSES,
+        PERF_BRANCH_MISSES,
+        PERF_DTLB_MISSES,
+        NUM_PERF_EVENTS
+};
+
+/******** perfReading struct ********
+ *
+ * Counter values accumulated over one stage.
+ *
+ * Fields:
+ *      uint64_t values[]:      Count for each perfEvent, scaled up if the
+ *                                kernel multiplexed the counter
+ *      bool valid[]:           Whether each counter could be read
+ ************************/
+struct perfReading
+{
+        uint64_t values[NUM_PERF_EVENTS];
+        bool valid[NUM_PERF_EVENTS];
+};
+
+void perfCountersEnable(void);
+bool perfCountersEnabled(void);
+
+void perfCountersStart(void);
+void perfCountersStop(struct perfReading *reading);
+void perfCountersPrint(FILE *out, const char *name, 
+                       const struct perfReading *reading, double pixels);
+void perfCountersPrintHeader(FILE *out);
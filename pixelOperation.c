@@ -27,6 +27,9 @@ const unsigned DENOMINATOR = 255;
 /* Initialize helper functions, see function contracts below */
 static void applyPixelToCompVid(int col, int row, A2Methods_UArray2 pixels, 
                                 void *elem, void *cl);
+static void applyBufferToCompVid(int col, int row, A2Methods_UArray2 RGBInfo,
+                                 void *elem, void *cl);
+static struct pixInfo RGBToCompVid(float r, float g, float b);
 static void applyCompVidToPixel(int col, int row, A2Methods_UArray2 pixels, 
                                 void *elem, void *cl);
 
@@ -47,6 +50,26 @@ struct applyPixelToCompVidClosure
         A2Methods_T methods;
 };
 
+/******** applyBufferToCompVidClosure struct ********
+ *
+ * A closure struct passed into the mapping function that converts a raw
+ * caller-owned RGB buffer to a UArray2b of floating-point CVCS data.
+ *
+ * Fields:
+ *      const unsigned char *pixels:    The first byte of the first row
+ *      size_t stride:                  Bytes from one row to the next
+ *      unsigned bytesPerSample:        1 if denominator < 256, otherwise 2
+ *                                        (big-endian, as in a raw PPM)
+ *      unsigned denominator:           The largest sample value
+ ************************/
+struct applyBufferToCompVidClosure
+{
+        const unsigned char *pixels;
+        size_t stride;
+        unsigned bytesPerSample;
+        unsigned denominator;
+};
+
 /******** applyCompVidToPixelClosure struct ********
  *
  * A closure struct passed into the mapping function that converts a UArray2b of
@@ -84,6 +107,30 @@ struct applyCompVidToPixelClosure
  ************************/
 T getRGBCompVid(Pnm_ppm img, A2Methods_T methods)
 {
+        return getRGBCompVidBlocks(img, methods, BLOCKSIZE);
+}
+
+/******** getRGBCompVidBlocks ********
+ *
+ * getRGBCompVid, storing the CVCS pixels in blocks of the given size, so
+ * that a transform over blocks of that size reads contiguous memory.
+ *
+ * Parameters:
+ *      Pnm_ppm img:            A pointer to the source Pnm_ppm image
+ *      A2Methods_T methods:    The blocked method suite
+ *      int blockSize:          The side of a block
+ * Returns:
+ *      A UArray2b_T where each element is a pixInfo struct.
+ * Expects:
+ *      img and methods are not NULL, and blockSize is positive.
+ * Notes:
+ *      Throws a CRE if an expectation is violated or allocation fails.
+ *      Converts only img's width x height pixels, so a trimmed image (see
+ *        readImage) whose array is larger is read correctly.
+ ************************/
+T getRGBCompVidBlocks(Pnm_ppm img, A2Methods_T methods, int blockSize)
+{
+        assert(blockSize > 0);
         assert(img != NULL);
         assert(methods != NULL);
         assert(img->pixels != NULL);
@@ -98,13 +145,14 @@ T getRGBCompVid(Pnm_ppm img, A2Methods_T methods)
         /* Create the destination array to hold floating-point CVCS data */
         T RGBInfo = methods->new_with_blocksize(img->width, img->height, 
                                                 sizeof(struct pixInfo), 
-                                                BLOCKSIZE);
+                                                blockSize);
         assert(RGBInfo != NULL);
 
         /* Set up the closure with source and destination arrays */
         struct applyPixelToCompVidClosure closure = {RGBInfo, img, methods};
 
-        /* Map over the source image, applying the conversion to each pixel */
+        /* Map over the source image (in storage order, which may run past
+         * a trimmed image's edges), converting each pixel */
         map(img->pixels, applyPixelToCompVid, &closure);
 
         return RGBInfo;
@@ -144,6 +192,12 @@ static void applyPixelToCompVid(int col, int row, A2Methods_UArray2 pixels,
         assert(closure->methods->at != NULL);
         assert(closure->img->pixels != NULL);
 
+        /* A trimmed image's array holds pixels past its edges; skip them */
+        if (col >= (int) closure->img->width ||
+            row >= (int) closure->img->height) {
+                return;
+        }
+
         Pnm_rgb pixel = elem;
 
         unsigned denom = closure->img->denominator;
@@ -153,18 +207,129 @@ static void applyPixelToCompVid(int col, int row, A2Methods_UArray2 pixels,
         float g = (float) pixel->green / denom;
         float b = (float) pixel->blue / denom;
 
-        /* Apply linear transformation from RGB to CVCS */
-        float y = 0.299 * r + 0.587 * g + 0.114 * b;
-        float pb = 0.5 * b - 0.168736 * r - 0.331264 * g;
-        float pr = 0.5 * r - 0.418688 * g - 0.081312 * b;
-
         /* Get a pointer to the destination element in the new array */
         struct pixInfo *destVals = closure->methods->at(closure->RGBInfo, 
                                                         col, row);
         assert(destVals != NULL);
 
         /* Store the calculated CVCS values */
-        *destVals = (struct pixInfo){y, pb, pr};
+        *destVals = RGBToCompVid(r, g, b);
+}
+
+/******** getRGBCompVidFromBuffer ********
+ *
+ * Converts a caller-owned buffer of RGB samples, laid out like the raster of
+ * a raw PPM, into a new UArray2b of structs containing floating-point CVCS
+ * data. Only the top-left width x height pixels are read.
+ *
+ * Parameters:
+ *      const unsigned char *pixels:    The first byte of the first row
+ *      int width, height:              Dimensions to convert
+ *      size_t stride:                  Bytes from one row to the next
+ *      unsigned denominator:           The largest sample value; samples are
+ *                                        1 byte if it is below 256 and 2
+ *                                        big-endian bytes otherwise
+ *      A2Methods_T methods:            The blocked method suite
+ * Returns:
+ *      A UArray2b_T (defined as T) where each element is a pixInfo struct.
+ * Expects:
+ *      pixels and methods are not NULL.
+ *      width and height are positive and denominator is in [1, 65535].
+ * Notes:
+ *      Throws a CRE if an expectation is violated.
+ *      Throws a CRE if memory allocation fails.
+ *      Allocates memory for a new UArray2b, which the caller must free.
+ ************************/
+T getRGBCompVidFromBuffer(const unsigned char *pixels, int width, int height,
+                          size_t stride, unsigned denominator,
+                          A2Methods_T methods)
+{
+        assert(pixels != NULL);
+        assert(methods != NULL);
+        assert(width > 0 && height > 0);
+        assert(denominator > 0 && denominator < 65536);
+
+        A2Methods_mapfun *map = methods->map_default;
+        assert(map != NULL);
+
+        T RGBInfo = methods->new_with_blocksize(width, height, 
+                                                sizeof(struct pixInfo), 
+                                                BLOCKSIZE);
+        assert(RGBInfo != NULL);
+
+        struct applyBufferToCompVidClosure closure;
+        closure.pixels = pixels;
+        closure.stride = stride;
+        closure.bytesPerSample = denominator < 256 ? 1 : 2;
+        closure.denominator = denominator;
+
+        /* Map over the destination, pulling each pixel from the buffer */
+        map(RGBInfo, applyBufferToCompVid, &closure);
+
+        return RGBInfo;
+}
+
+/******** applyBufferToCompVid ********
+ *
+ * Apply function that reads one pixel's samples from the caller's buffer and
+ * stores its CVCS values in the destination element.
+ *
+ * Parameters:
+ *      int col:                        Column index of the current pixel
+ *      int row:                        Row index of the current pixel
+ *      A2Methods_UArray2 RGBInfo:      The array being mapped over (unused)
+ *      void *elem:                     Pointer to destination pixInfo struct
+ *      void *cl:                       Pointer to applyBufferToCompVidClosure
+ * Returns:
+ *      Nothing.
+ * Expects:
+ *      elem and cl are not NULL.
+ ************************/
+static void applyBufferToCompVid(int col, int row, A2Methods_UArray2 RGBInfo,
+                                 void *elem, void *cl)
+{
+        (void) RGBInfo;
+        assert(elem != NULL);
+        assert(cl != NULL);
+
+        struct applyBufferToCompVidClosure *closure = cl;
+        unsigned size = closure->bytesPerSample;
+        const unsigned char *src = closure->pixels + row * closure->stride +
+                                   (size_t) col * 3 * size;
+        unsigned samples[3];
+
+        for (int i = 0; i < 3; i++) {
+                if (size == 1) {
+                        samples[i] = src[i];
+                } else {
+                        samples[i] = (src[2 * i] << 8) | src[2 * i + 1];
+                }
+        }
+
+        float denom = closure->denominator;
+        *(struct pixInfo *) elem = RGBToCompVid(samples[0] / denom,
+                                                samples[1] / denom,
+                                                samples[2] / denom);
+}
+
+/******** RGBToCompVid ********
+ *
+ * Applies the linear transformation from RGB to CVCS.
+ *
+ * Parameters:
+ *      float r, g, b:  Channel values in [0, 1]
+ * Returns:
+ *      The pixel's CVCS values.
+ * Expects:
+ *      Nothing.
+ ************************/
+static struct pixInfo RGBToCompVid(float r, float g, float b)
+{
+        float y = 0.299 * r + 0.587 * g + 0.114 * b;
+        float pb = 0.5 * b - 0.168736 * r - 0.331264 * g;
+        float pr = 0.5 * r - 0.418688 * g - 0.081312 * b;
+
+        return (struct pixInfo){y, pb, pr};
 }
 
 /******** getRGBInts ********
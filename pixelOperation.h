@@ -31,8 +31,16 @@ struct pixInfo
         float y, pb, pr;
 };
 
+/* The denominator of every decompressed image */
+extern const unsigned DENOMINATOR;
+
 /* Compression */
 UArray2b_T getRGBCompVid(Pnm_ppm img, A2Methods_T methods);
+UArray2b_T getRGBCompVidBlocks(Pnm_ppm img, A2Methods_T methods,
+                               int blockSize);
+UArray2b_T getRGBCompVidFromBuffer(const unsigned char *pixels, int width, 
+                                   int height, size_t stride, 
+                                   unsigned denominator, A2Methods_T methods);
 
 /* Decompression */
 Pnm_ppm getRGBInts(UArray2b_T RGBFloats, A2Methods_T methods);
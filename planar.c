@@ -0,0 +1,221 @@
+/*
+ *      planar.c
+ *      Kevin Lu (klu07), Justin Paik (jpaik03)
+ *      October 18, 2026
+ *      arith
+ *
+ *      Implementation of compressed image format 6. After the usual header
+ *      ("COMP40 Compressed image format 6\n%u %u\n") come six planes, each
+ *      holding one field of every block in row-major block order at its
+ *      codeword width, packed most significant bit first and padded to a
+ *      whole byte:
+ *
+ *        a (9 bits), indexbpb (4), indexbpr (4), b (5), c (5), d (5)
+ *
+ *      so the file is the same size as format 2, and every plane starts at
+ *      an offset computable from the header. b, c and d are two's
+ *      complement.
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <assert.h>
+
+#include "planar.h"
+#include "codewords.h"
+#include "blockOperation.h"
+#include "bitStream.h"
+
+#define BLOCKSIZE 2
+#define FORMAT 6
+#define NUM_PLANES 6
+#define COEFF_BITS 5
+
+/* Width of each plane's field, in storage order */
+static const int planeBits[NUM_PLANES] = { 9, 4, 4, 5, 5, 5 };
+
+static void writePlane(FILE *output, const struct quantizedPlanes *planes,
+                       int plane);
+static void readPlane(FILE *input, struct quantizedPlanes *planes,
+                      int plane);
+static void skipBytes(FILE *input, size_t count);
+static int signExtend(uint64_t field);
+
+/******** printWordsPlanar ********
+ *
+ * Writes the format 6 header and all six planes.
+ *
+ * Parameters:
+ *      FILE *output:                           The stream to write to
+ *      const struct quantizedPlanes *planes:   The blocks' fields
+ *      const struct quantScales *scales:       The scales they were
+ *                                                quantized with, for the
+ *                                                header
+ * Returns:
+ *      Nothing.
+ * Expects:
+ *      output and planes are not NULL.
+ * Notes:
+ *      Throws a CRE if output or planes is NULL.
+ ************************/
+void printWordsPlanar(FILE *output, const struct quantizedPlanes *planes,
+                      const struct quantScales *scales)
+{
+        assert(output != NULL);
+        assert(planes != NULL);
+
+        writeFormatHeader(output, FORMAT, planes->blocksWide * BLOCKSIZE,
+                          planes->blocksHigh * BLOCKSIZE, scales);
+        for (int plane = 0; plane < NUM_PLANES; plane++) {
+                writePlane(output, planes, plane);
+        }
+}
+
+/******** readWordsPlanar ********
+ *
+ * Reads the chosen planes of a format 6 image.
+ *
+ * Parameters:
+ *      FILE *input:            File pointer positioned after the header
+ *      unsigned width:         The width of the image in pixels
+ *      unsigned height:        The height of the image in pixels
+ *      unsigned planeMask:     The planes to read, an OR of enum plane
+ * Returns:
+ *      The blocks' fields, to be freed with freeQuantizedPlanes. Fields in
+ *      planes that were not read are 0.
+ * Expects:
+ *      input is not NULL.
+ * Notes:
+ *      Throws a CRE if input is NULL, allocation fails, or a chosen plane
+ *        is incomplete.
+ *      Skips unwanted planes before the last wanted one with fseeko when
+ *        the input allows it, and by reading past them otherwise. Stops
+ *        reading after the last wanted plane.
+ ************************/
+struct quantizedPlanes *readWordsPlanar(FILE *input, unsigned width,
+                                        unsigned height, unsigned planeMask)
+{
+        assert(input != NULL);
+
+        struct quantizedPlanes *planes =
+                newQuantizedPlanes(width / BLOCKSIZE, height / BLOCKSIZE);
+        size_t count = (size_t) planes->blocksWide * planes->blocksHigh;
+
+        size_t skipped = 0;
+        for (int plane = 0; plane < NUM_PLANES; plane++) {
+                if ((planeMask >> plane) == 0) {
+                        break;
+                }
+                if ((planeMask & (1u << plane)) == 0) {
+                        skipped += (count * planeBits[plane] + 7) / 8;
+                        continue;
+                }
+                skipBytes(input, skipped);
+                skipped = 0;
+                readPlane(input, planes, plane);
+        }
+        return planes;
+}
+
+/******** writePlane ********
+ *
+ * Writes one field of every block, bit-packed and padded to a byte. The
+ * choice of array is made once, so each loop runs over a single plane.
+ ************************/
+static void writePlane(FILE *output, const struct quantizedPlanes *planes,
+                       int plane)
+{
+        size_t count = (size_t) planes->blocksWide * planes->blocksHigh;
+        int bits = planeBits[plane];
+        uint64_t mask = ((uint64_t) 1 << bits) - 1;
+        struct bitStream stream = { output, 0, 0 };
+
+        if (1 << plane == PLANE_A) {
+                for (size_t i = 0; i < count; i++) {
+                        putBits(&stream, planes->a[i], bits);
+                }
+        } else if (1 << plane <= PLANE_INDEXBPR) {
+                const uint8_t *field = 1 << plane == PLANE_INDEXBPB ?
+                                       planes->indexbpb : planes->indexbpr;
+                for (size_t i = 0; i < count; i++) {
+                        putBits(&stream, field[i], bits);
+                }
+        } else {
+                const int8_t *field = 1 << plane == PLANE_B ? planes->b :
+                                      1 << plane == PLANE_C ? planes->c :
+                                      planes->d;
+                for (size_t i = 0; i < count; i++) {
+                        putBits(&stream, field[i] & mask, bits);
+                }
+        }
+        flushBits(&stream);
+}
+
+/******** readPlane ********
+ *
+ * Reads one field of every block into its plane.
+ ************************/
+static void readPlane(FILE *input, struct quantizedPlanes *planes,
+                      int plane)
+{
+        size_t count = (size_t) planes->blocksWide * planes->blocksHigh;
+        int bits = planeBits[plane];
+        struct bitStream stream = { input, 0, 0 };
+        uint64_t field = 0;
+        bool read = true;
+
+        if (1 << plane == PLANE_A) {
+                for (size_t i = 0; i < count && read; i++) {
+                        read = getBits(&stream, bits, &field);
+                        planes->a[i] = field;
+                }
+        } else if (1 << plane <= PLANE_INDEXBPR) {
+                uint8_t *dest = 1 << plane == PLANE_INDEXBPB ?
+                                planes->indexbpb : planes->indexbpr;
+                for (size_t i = 0; i < count && read; i++) {
+                        read = getBits(&stream, bits, &field);
+                        dest[i] = field;
+                }
+        } else {
+                int8_t *dest = 1 << plane == PLANE_B ? planes->b :
+                               1 << plane == PLANE_C ? planes->c :
+                               planes->d;
+                for (size_t i = 0; i < count && read; i++) {
+                        read = getBits(&stream, bits, &field);
+                        dest[i] = signExtend(field);
+                }
+        }
+        assert(read);
+}
+
+/******** skipBytes ********
+ *
+ * Moves count bytes forward in the input, seeking when possible.
+ * Throws a CRE if the input ends first.
+ ************************/
+static void skipBytes(FILE *input, size_t count)
+{
+        if (count == 0 || fseeko(input, count, SEEK_CUR) == 0) {
+                return;
+        }
+
+        unsigned char discard[4096];
+        while (count > 0) {
+                size_t chunk = count < sizeof(discard) ? count :
+                               sizeof(discard);
+                size_t read = fread(discard, 1, chunk, input);
+                assert(read == chunk);
+                count -= chunk;
+        }
+}
+
+/******** signExtend ********
+ *
+ * Turns a 5-bit two's complement field into an int.
+ ************************/
+static int signExtend(uint64_t field)
+{
+        int sign = 1 << (COEFF_BITS - 1);
+        return ((int) field ^ sign) - sign;
+}
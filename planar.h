@@ -0,0 +1,38 @@
+/*
+ *      planar.h
+ *      Kevin Lu (klu07), Justin Paik (jpaik03)
+ *      October 18, 2026
+ *      arith
+ *
+ *      Interface for compressed image format 6, which stores the codeword
+ *      fields as separate planes rather than interleaved in 32-bit words.
+ *      It reads into and writes from the structure-of-arrays form of the
+ *      quantized blocks (struct quantizedPlanes), and a reader can ask for
+ *      only the planes it needs, e.g. just a for luma.
+ */
+
+#include <stdio.h>
+
+/* Defined in blockOperation.h */
+struct quantizedPlanes;
+struct quantScales;
+
+/* The planes, in the order they are stored, as bits for a plane mask */
+enum plane
+{
+        PLANE_A = 1,
+        PLANE_INDEXBPB = 2,
+        PLANE_INDEXBPR = 4,
+        PLANE_B = 8,
+        PLANE_C = 16,
+        PLANE_D = 32,
+        ALL_PLANES = 63
+};
+
+/* Compression: writes the header too */
+void printWordsPlanar(FILE *output, const struct quantizedPlanes *planes,
+                      const struct quantScales *scales);
+
+/* Decompression: input is positioned just past the header */
+struct quantizedPlanes *readWordsPlanar(FILE *input, unsigned width,
+                                        unsigned height, unsigned planeMask);
@@ -0,0 +1,188 @@
+/*
+ *      ppmStream.c
+ *      Kevin Lu (klu07), Justin Paik (jpaik03)
+ *      October 18, 2026
+ *      arith
+ *
+ *      Implementation of row-at-a-time PPM reading. Only the header and one
+ *      row of raw bytes are ever held, so memory does not grow with the
+ *      height of the image. The file is left open; the caller closes it.
+ */
+
+#include <stdlib.h>
+#include <ctype.h>
+#include <limits.h>
+#include <assert.h>
+
+#include "ppmStream.h"
+
+#define CHANNELS 3
+#define MAX_DENOMINATOR 65535
+
+static bool readHeaderNumber(FILE *file, unsigned *value);
+static int skipSpaceAndComments(FILE *file);
+
+/******** ppmStreamOpen ********
+ *
+ * Reads a PPM header and prepares to read its rows.
+ *
+ * Parameters:
+ *      FILE *file:     The stream, positioned at the start of the image
+ * Returns:
+ *      A stream to be freed with ppmStreamClose, or NULL if the header is
+ *      malformed.
+ * Expects:
+ *      file is not NULL.
+ * Notes:
+ *      Throws a CRE if file is NULL or allocation fails.
+ *      After a P6 header, exactly one whitespace character is consumed, so
+ *        the first row starts at the next byte.
+ ************************/
+struct ppmStream *ppmStreamOpen(FILE *file)
+{
+        assert(file != NULL);
+
+        if (getc(file) != 'P') {
+                return NULL;
+        }
+        int kind = getc(file);
+        if (kind != '3' && kind != '6') {
+                return NULL;
+        }
+
+        unsigned width, height, denominator;
+        if (!readHeaderNumber(file, &width) ||
+            !readHeaderNumber(file, &height) ||
+            !readHeaderNumber(file, &denominator) ||
+            denominator == 0 || denominator > MAX_DENOMINATOR) {
+                return NULL;
+        }
+        if (!isspace(getc(file))) {
+                return NULL;
+        }
+
+        struct ppmStream *stream = malloc(sizeof(*stream));
+        assert(stream != NULL);
+        stream->file = file;
+        stream->width = width;
+        stream->height = height;
+        stream->denominator = denominator;
+        stream->plain = kind == '3';
+        stream->rowsRead = 0;
+        stream->rawLength = (size_t) CHANNELS * width *
+                            (denominator > 255 ? 2 : 1);
+        stream->raw = NULL;
+        if (!stream->plain) {
+                stream->raw = malloc(stream->rawLength + 1);
+                assert(stream->raw != NULL);
+        }
+        return stream;
+}
+
+/******** ppmStreamClose ********
+ *
+ * Frees a stream (but does not close its file) and sets *stream to NULL.
+ ************************/
+void ppmStreamClose(struct ppmStream **stream)
+{
+        assert(stream != NULL && *stream != NULL);
+        free((*stream)->raw);
+        free(*stream);
+        *stream = NULL;
+}
+
+/******** ppmStreamReadRow ********
+ *
+ * Reads the next row of an image.
+ *
+ * Parameters:
+ *      struct ppmStream *stream:       The stream to read from
+ *      unsigned *samples:              Room for 3 * width samples
+ * Returns:
+ *      true with the row in samples, or false if every row has been read
+ *      or the file ends early.
+ * Expects:
+ *      stream and samples are not NULL.
+ * Notes:
+ *      Throws a CRE if stream or samples is NULL.
+ *      Samples larger than the denominator are passed through unchecked.
+ ************************/
+bool ppmStreamReadRow(struct ppmStream *stream, unsigned *samples)
+{
+        assert(stream != NULL && samples != NULL);
+
+        if (stream->rowsRead == stream->height) {
+                return false;
+        }
+        size_t count = (size_t) CHANNELS * stream->width;
+
+        if (stream->plain) {
+                for (size_t k = 0; k < count; k++) {
+                        if (fscanf(stream->file, "%u", &samples[k]) != 1) {
+                                return false;
+                        }
+                }
+        } else {
+                if (fread(stream->raw, 1, stream->rawLength, stream->file) !=
+                    stream->rawLength) {
+                        return false;
+                }
+                const unsigned char *raw = stream->raw;
+                if (stream->denominator > 255) {
+                        for (size_t k = 0; k < count; k++) {
+                                samples[k] = raw[2 * k] << 8 |
+                                             raw[2 * k + 1];
+                        }
+                } else {
+                        for (size_t k = 0; k < count; k++) {
+                                samples[k] = raw[k];
+                        }
+                }
+        }
+        stream->rowsRead++;
+        return true;
+}
+
+/******** readHeaderNumber ********
+ *
+ * Reads one decimal field of a PPM header, skipping whitespace and
+ * comments before it. Returns false if there is no number or it overflows.
+ ************************/
+static bool readHeaderNumber(FILE *file, unsigned *value)
+{
+        int c = skipSpaceAndComments(file);
+        if (!isdigit(c)) {
+                return false;
+        }
+
+        unsigned long number = 0;
+        while (isdigit(c)) {
+                number = number * 10 + (c - '0');
+                if (number > UINT_MAX) {
+                        return false;
+                }
+                c = getc(file);
+        }
+        ungetc(c, file);
+        *value = number;
+        return true;
+}
+
+/******** skipSpaceAndComments ********
+ *
+ * Returns the first character that is neither whitespace nor part of a
+ * '#' comment.
+ ************************/
+static int skipSpaceAndComments(FILE *file)
+{
+        int c = getc(file);
+        while (c != EOF && (isspace(c) || c == '#')) {
+                if (c == '#') {
+                        while (c != EOF && c != '\n') {
+                                c = getc(file);
+                        }
+                }
+                c = getc(file);
+        }
+        return c;
+}
@@ -0,0 +1,43 @@
+/*
+ *      ppmStream.h
+ *      Kevin Lu (klu07), Justin Paik (jpaik03)
+ *      October 18, 2026
+ *      arith
+ *
+ *      Interface for reading a PPM one row at a time, for tools that must
+ *      not hold a whole image in memory (see ppmdiff.c). Reads P6 (raw, one
+ *      or two bytes per sample) and P3 (plain) images. Rows come out as
+ *      3 * width unsigned samples, red, green, blue per pixel.
+ */
+
+#include <stdio.h>
+#include <stdbool.h>
+
+/******** ppmStream struct ********
+ *
+ * An open PPM, positioned at the next row to read.
+ *
+ * Fields:
+ *      FILE *file:             The underlying stream
+ *      unsigned width, height, denominator:    From the header
+ *      bool plain:             true for P3, false for P6
+ *      unsigned rowsRead:      Rows returned so far
+ *      unsigned char *raw:     One row of P6 bytes
+ *      size_t rawLength:       Bytes in raw
+ ************************/
+struct ppmStream
+{
+        FILE *file;
+        unsigned width, height, denominator;
+        bool plain;
+        unsigned rowsRead;
+        unsigned char *raw;
+        size_t rawLength;
+};
+
+/* Returns NULL if the header is not a valid PPM header */
+struct ppmStream *ppmStreamOpen(FILE *file);
+void ppmStreamClose(struct ppmStream **stream);
+
+/* Returns false if the image has no more rows or ends early */
+bool ppmStreamReadRow(struct ppmStream *stream, unsigned *samples);
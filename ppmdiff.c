@@ -1,103 +1,230 @@
+/*
+ *      ppmdiff.c
+ *      Kevin Lu (klu07), Justin Paik (jpaik03)
+ *      October 18, 2026
+ *      arith
+ *
+ *      Compares two PPM images and prints, one per line, their root mean
+ *      square difference (as before, so scripts reading the first line keep
+ *      working), their PSNR and their mean SSIM. All three come from one
+ *      pass over the images, which is cut into bands of whole SSIM windows
+ *      and shared out to a pool of threads.
+ *
+ *      Neither image is ever held whole. Each worker, in turn, reads the
+ *      next band of rows from both files in lock-step (see ppmStream.h) into
+ *      its own buffers and compares it while the others read, so memory is
+ *      bounded by a band of each image per worker, whatever the height.
+ *
+ *      Usage: ppmdiff [-j workers] file1 file2
+ *
+ *      Samples are normalized by each image's denominator, so the peak
+ *      value for PSNR is 1. SSIM is computed per channel over non-overlapping
+ *      8x8 windows (smaller if the image is) and averaged; rows and columns
+ *      past the last whole window count towards RMS and PSNR only.
+ */
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
 #include <math.h>
+#include <pthread.h>
+#include <unistd.h>
 #include "assert.h"
 
-#include "pnm.h"
-#include "a2methods.h"
-#include "a2plain.h"
+#include "ppmStream.h"
+
+#define WINDOW 8
+#define WINDOWS_PER_BAND 2
+#define CHANNELS 3
+#define SSIM_C1 (0.01 * 0.01)
+#define SSIM_C2 (0.03 * 0.03)
+
+/******** bandResult struct ********
+ *
+ * Partial sums for one band, combined in band order once all are done.
+ *
+ * Fields:
+ *      double squares:         Sum of squared normalized differences
+ *      double ssim:            Sum of SSIM over the band's windows
+ *      long windows:           Number of windows in the band
+ ************************/
+struct bandResult
+{
+        double squares;
+        double ssim;
+        long windows;
+};
+
+/******** diffState struct ********
+ *
+ * State shared by the workers comparing two images.
+ *
+ * Fields:
+ *      struct ppmStream *in1, *in2:    The two images being compared
+ *      unsigned width, height:         The smaller of each, compared
+ *      int window:                     Side of an SSIM window
+ *      int bandRows:                   Pixel rows in each band
+ *      int numBands:                   Number of bands in the image
+ *      int next:                       Index of the next band to read
+ *      bool failed:                    Whether an image ended early
+ *      struct bandResult *results:     One result per band
+ *      pthread_mutex_t lock:           Guards next, failed and the reads
+ ************************/
+struct diffState
+{
+        struct ppmStream *in1, *in2;
+        unsigned width, height;
+        int window;
+        int bandRows;
+        int numBands;
+        int next;
+        bool failed;
+        struct bandResult *results;
+        pthread_mutex_t lock;
+};
+
+/******** scratch struct ********
+ *
+ * Per-worker scratch: a band of each image, and one float per sample of a
+ * row for each float array.
+ *
+ * Fields:
+ *      unsigned *rows1, *rows2:        A band of samples from each image
+ *      float *x, *y:                   A row of each, normalized
+ *      float *sx, *sy, *sxx, *syy, *sxy:       Column sums over a window's
+ *                                                rows for SSIM
+ ************************/
+struct scratch
+{
+        unsigned *rows1, *rows2;
+        float *x, *y;
+        float *sx, *sy, *sxx, *syy, *sxy;
+};
 
-FILE *openFile(const char *filename);
+static FILE *openFile(const char *filename);
+static struct ppmStream *openImage(FILE *fp, const char *filename);
+static void *runWorker(void *closure);
+static bool readBand(struct diffState *state, int band,
+                     struct scratch *scratch);
+static void diffBand(struct diffState *state, int band,
+                     struct scratch *scratch);
+static double rowSquares(const unsigned *row1, const unsigned *row2,
+                         size_t count, unsigned denom1, unsigned denom2);
+static void normalizeRow(const unsigned *row, float *out, size_t count,
+                         unsigned denominator);
+static double windowSsim(const struct scratch *scratch, int window, int col,
+                         int channel);
 
 int main(int argc, char *argv[])
 {
-        /* Validate usage */
-        if (argc != 3) {
-                fprintf(stderr, "Usage: ./ppmdiff <file1> <file2>\n");
+        int numWorkers = 0;
+        int i = 1;
+        if (argc == 5 && strcmp(argv[1], "-j") == 0) {
+                numWorkers = atoi(argv[2]);
+                i = 3;
+        }
+        if (argc - i != 2) {
+                fprintf(stderr,
+                        "Usage: ./ppmdiff [-j workers] <file1> <file2>\n");
                 exit(EXIT_FAILURE);
         }
 
-        /* Read in images into 2D arrays */
-        A2Methods_T methods = uarray2_methods_plain;
-        assert(methods);
-        FILE *fp1 = openFile(argv[1]);
-        FILE *fp2 = openFile(argv[2]);
-        Pnm_ppm img1 = Pnm_ppmread(fp1, methods);
-        Pnm_ppm img2 = Pnm_ppmread(fp2, methods);
+        FILE *fp1 = openFile(argv[i]);
+        FILE *fp2 = openFile(argv[i + 1]);
+        struct ppmStream *img1 = openImage(fp1, argv[i]);
+        struct ppmStream *img2 = openImage(fp2, argv[i + 1]);
 
         /* If image dimensions differ by more than 1, fail */
-        if (abs((int)img1->width - (int)img2->width) > 1 || 
-            abs((int)img1->height - (int)img2->height) > 1) {
-                fprintf(stderr, "Error: Images differ by more than 1 pixel.\n");
+        if (abs((int) img1->width - (int) img2->width) > 1 ||
+            abs((int) img1->height - (int) img2->height) > 1) {
+                fprintf(stderr,
+                        "Error: Images differ by more than 1 pixel.\n");
                 printf("1.0\n");
-
-                Pnm_ppmfree(&img1);
-                Pnm_ppmfree(&img2);
-                fclose(fp1);
-                fclose(fp2);
-
                 exit(EXIT_FAILURE);
         }
 
-        /* Find smaller image */
-        unsigned w;
-        if (img1->width < img2->width) {
-                w = img1->width;
-        } else {
-                w = img2->width;
+        /* Compare over the smaller dimensions; extra rows are never read */
+        struct diffState state;
+        state.in1 = img1;
+        state.in2 = img2;
+        state.width = img1->width < img2->width ? img1->width : img2->width;
+        state.height = img1->height < img2->height ? img1->height :
+                       img2->height;
+        unsigned shorter = state.width < state.height ? state.width :
+                           state.height;
+        state.window = shorter < WINDOW ? (int) shorter : WINDOW;
+        state.bandRows = state.window * WINDOWS_PER_BAND;
+        state.numBands = state.window == 0 ? 0 :
+                         (state.height + state.bandRows - 1) /
+                         state.bandRows;
+        state.next = 0;
+        state.failed = false;
+        state.results = calloc(state.numBands + 1, sizeof(*state.results));
+        assert(state.results != NULL);
+        pthread_mutex_init(&state.lock, NULL);
+
+        if (numWorkers <= 0) {
+                numWorkers = (int) sysconf(_SC_NPROCESSORS_ONLN);
         }
-        unsigned h;
-        if (img1->height < img2->height) {
-                h = img1->height;
-        } else {
-                h = img2->height;
+        if (numWorkers > state.numBands) {
+                numWorkers = state.numBands;
         }
-
-        /* Divide by zero case */
-        if (w == 0 || h == 0) {
-                printf("0.0000\n");
-        } else {
-                double sum_sq_diff = 0.0;
-                double denom1 = (double)img1->denominator;
-                double denom2 = (double)img2->denominator;
-
-                /* Iterate through smallest dimensions */
-                for (unsigned j = 0; j < h; j++) {
-                        for (unsigned i = 0; i < w; i++) {
-                                Pnm_rgb p1 = (Pnm_rgb)methods->at(img1->pixels, i, j);
-                                Pnm_rgb p2 = (Pnm_rgb)methods->at(img2->pixels, i, j);
-
-                                /* Convert scaled integers to floating point values */
-                                double r1 = (double)p1->red   / denom1;
-                                double g1 = (double)p1->green / denom1;
-                                double b1 = (double)p1->blue  / denom1;
-
-                                double r2 = (double)p2->red   / denom2;
-                                double g2 = (double)p2->green / denom2;
-                                double b2 = (double)p2->blue  / denom2;
-                                
-                                /* Add the squared differences of each color channel to the sum */
-                                sum_sq_diff += pow(r1 - r2, 2);
-                                sum_sq_diff += pow(g1 - g2, 2);
-                                sum_sq_diff += pow(b1 - b2, 2);
-                        }
-                }
-
-                /* Apply formula for the root mean square difference */
-                double e = sqrt(sum_sq_diff / (3.0 * w * h));
-                printf("%.4f\n", e);
+        if (numWorkers < 1) {
+                numWorkers = 1;
         }
 
-        Pnm_ppmfree(&img1);
-        Pnm_ppmfree(&img2);
+        pthread_t *threads = malloc(numWorkers * sizeof(*threads));
+        assert(threads != NULL);
+        for (int t = 0; t < numWorkers; t++) {
+                int result = pthread_create(&threads[t], NULL, runWorker,
+                                            &state);
+                assert(result == 0);
+        }
+        for (int t = 0; t < numWorkers; t++) {
+                pthread_join(threads[t], NULL);
+        }
+        free(threads);
+        pthread_mutex_destroy(&state.lock);
+        ppmStreamClose(&img1);
+        ppmStreamClose(&img2);
         fclose(fp1);
         fclose(fp2);
+        if (state.failed) {
+                fprintf(stderr, "Error: An image ends early.\n");
+                printf("1.0\n");
+                exit(EXIT_FAILURE);
+        }
+
+        /* Combine in band order, so the result does not depend on timing */
+        double squares = 0.0;
+        double ssim = 0.0;
+        long windows = 0;
+        for (int band = 0; band < state.numBands; band++) {
+                squares += state.results[band].squares;
+                ssim += state.results[band].ssim;
+                windows += state.results[band].windows;
+        }
+        free(state.results);
 
+        double samples = (double) CHANNELS * state.width * state.height;
+        double mse = samples == 0 ? 0.0 : squares / samples;
+        printf("%.4f\n", sqrt(mse));
+        if (mse == 0.0) {
+                printf("PSNR: inf\n");
+        } else {
+                printf("PSNR: %.2f dB\n", -10.0 * log10(mse));
+        }
+        printf("SSIM: %.4f\n", windows == 0 ? 1.0 :
+                               ssim / (windows * CHANNELS));
         return 0;
 }
 
-FILE *openFile(const char *filename)
+/******** openFile ********
+ *
+ * Opens a file for reading, exiting with a message if it cannot.
+ ************************/
+static FILE *openFile(const char *filename)
 {
         FILE *fp = fopen(filename, "rb");
         if (fp == NULL) {
@@ -105,4 +232,242 @@ FILE *openFile(const char *filename)
                 exit(EXIT_FAILURE);
         }
         return fp;
-}
\ No newline at end of file
+}
+
+/******** openImage ********
+ *
+ * Reads an image's header, exiting with a message if it is not a PPM.
+ ************************/
+static struct ppmStream *openImage(FILE *fp, const char *filename)
+{
+        struct ppmStream *image = ppmStreamOpen(fp);
+        if (image == NULL) {
+                fprintf(stderr, "Not a PPM image: %s\n", filename);
+                exit(EXIT_FAILURE);
+        }
+        return image;
+}
+
+/******** runWorker ********
+ *
+ * Thread body: reads and compares bands in order until none are left.
+ *
+ * Parameters:
+ *      void *closure:  The shared struct diffState
+ * Returns:
+ *      NULL.
+ ************************/
+static void *runWorker(void *closure)
+{
+        struct diffState *state = closure;
+        size_t count = (size_t) CHANNELS * state->width;
+        size_t bandRows = state->bandRows;
+        struct scratch scratch;
+        scratch.rows1 = malloc(bandRows * CHANNELS * state->in1->width *
+                               sizeof(unsigned) + 1);
+        scratch.rows2 = malloc(bandRows * CHANNELS * state->in2->width *
+                               sizeof(unsigned) + 1);
+        assert(scratch.rows1 != NULL && scratch.rows2 != NULL);
+        float **arrays[] = { &scratch.x, &scratch.y, &scratch.sx,
+                             &scratch.sy, &scratch.sxx, &scratch.syy,
+                             &scratch.sxy };
+        int numArrays = sizeof(arrays) / sizeof(arrays[0]);
+        for (int i = 0; i < numArrays; i++) {
+                *arrays[i] = malloc((count + 1) * sizeof(float));
+                assert(*arrays[i] != NULL);
+        }
+
+        for (;;) {
+                /* Reading under the lock keeps both files in step */
+                pthread_mutex_lock(&state->lock);
+                int band = state->next++;
+                bool read = band < state->numBands && !state->failed &&
+                            readBand(state, band, &scratch);
+                if (band < state->numBands && !read) {
+                        state->failed = true;
+                }
+                pthread_mutex_unlock(&state->lock);
+                if (!read) {
+                        break;
+                }
+                diffBand(state, band, &scratch);
+        }
+
+        for (int i = 0; i < numArrays; i++) {
+                free(*arrays[i]);
+        }
+        free(scratch.rows1);
+        free(scratch.rows2);
+        return NULL;
+}
+
+/******** readBand ********
+ *
+ * Reads the rows of a band from both images into a worker's buffers.
+ * Returns false if either image ends first.
+ ************************/
+static bool readBand(struct diffState *state, int band,
+                     struct scratch *scratch)
+{
+        unsigned first = (unsigned) band * state->bandRows;
+        size_t stride1 = (size_t) CHANNELS * state->in1->width;
+        size_t stride2 = (size_t) CHANNELS * state->in2->width;
+        for (unsigned row = first; row < state->height &&
+                                   row < first + state->bandRows; row++) {
+                size_t i = row - first;
+                if (!ppmStreamReadRow(state->in1,
+                                      scratch->rows1 + i * stride1) ||
+                    !ppmStreamReadRow(state->in2,
+                                      scratch->rows2 + i * stride2)) {
+                        return false;
+                }
+        }
+        return true;
+}
+
+/******** diffBand ********
+ *
+ * Compares one band of rows. Squared differences are summed row by row;
+ * for SSIM, every sample column keeps running sums of x, y, x^2, y^2 and
+ * xy over the rows of the current window strip, and each full strip is
+ * reduced to one SSIM value per window and channel. All of the per-row
+ * work is element-wise over the row's samples, so it vectorizes.
+ *
+ * Parameters:
+ *      struct diffState *state:        The images and result slots
+ *      int band:                       Which band to compare
+ *      struct scratch *scratch:        The worker's scratch rows
+ * Returns:
+ *      Nothing; fills in state->results[band].
+ ************************/
+static void diffBand(struct diffState *state, int band,
+                     struct scratch *scratch)
+{
+        unsigned first = (unsigned) band * state->bandRows;
+        unsigned last = first + state->bandRows;
+        if (last > state->height) {
+                last = state->height;
+        }
+        size_t count = (size_t) CHANNELS * state->width;
+        size_t stride1 = (size_t) CHANNELS * state->in1->width;
+        size_t stride2 = (size_t) CHANNELS * state->in2->width;
+        unsigned denom1 = state->in1->denominator;
+        unsigned denom2 = state->in2->denominator;
+        int window = state->window;
+        int windowsWide = window == 0 ? 0 : state->width / window;
+        struct bandResult *result = &state->results[band];
+
+        for (unsigned row = first; row < last; row++) {
+                const unsigned *row1 = scratch->rows1 +
+                                       (row - first) * stride1;
+                const unsigned *row2 = scratch->rows2 +
+                                       (row - first) * stride2;
+                result->squares += rowSquares(row1, row2, count, denom1,
+                                              denom2);
+
+                /* Rows past the last whole window strip skip SSIM */
+                int strip = (row - first) / window;
+                if ((strip + 1) * window + first > state->height) {
+                        continue;
+                }
+                if ((row - first) % window == 0) {
+                        size_t bytes = count * sizeof(float);
+                        memset(scratch->sx, 0, bytes);
+                        memset(scratch->sy, 0, bytes);
+                        memset(scratch->sxx, 0, bytes);
+                        memset(scratch->syy, 0, bytes);
+                        memset(scratch->sxy, 0, bytes);
+                }
+
+                float *x = scratch->x, *y = scratch->y;
+                normalizeRow(row1, x, count, denom1);
+                normalizeRow(row2, y, count, denom2);
+                for (size_t k = 0; k < count; k++) {
+                        scratch->sx[k] += x[k];
+                        scratch->sy[k] += y[k];
+                        scratch->sxx[k] += x[k] * x[k];
+                        scratch->syy[k] += y[k] * y[k];
+                        scratch->sxy[k] += x[k] * y[k];
+                }
+
+                if ((row - first) % window == (unsigned) window - 1) {
+                        for (int col = 0; col < windowsWide; col++) {
+                                for (int c = 0; c < CHANNELS; c++) {
+                                        result->ssim += windowSsim(scratch,
+                                                                   window,
+                                                                   col, c);
+                                }
+                        }
+                        result->windows += windowsWide;
+                }
+        }
+}
+
+/******** rowSquares ********
+ *
+ * Sums the squared normalized differences between two rows of samples.
+ * With equal denominators (the usual case) the differences are summed
+ * exactly as integers and scaled once; otherwise each sample is scaled by
+ * a precomputed reciprocal.
+ ************************/
+static double rowSquares(const unsigned *row1, const unsigned *row2,
+                         size_t count, unsigned denom1, unsigned denom2)
+{
+        if (denom1 == denom2) {
+                uint64_t sum = 0;
+                for (size_t k = 0; k < count; k++) {
+                        int64_t diff = (int64_t) row1[k] - row2[k];
+                        sum += diff * diff;
+                }
+                return (double) sum / ((double) denom1 * denom1);
+        }
+
+        double scale1 = 1.0 / denom1;
+        double scale2 = 1.0 / denom2;
+        double sum = 0.0;
+        for (size_t k = 0; k < count; k++) {
+                double diff = row1[k] * scale1 - row2[k] * scale2;
+                sum += diff * diff;
+        }
+        return sum;
+}
+
+/******** normalizeRow ********
+ *
+ * Scales a row of samples into [0, 1] as floats.
+ ************************/
+static void normalizeRow(const unsigned *row, float *out, size_t count,
+                         unsigned denominator)
+{
+        float scale = 1.0f / denominator;
+        for (size_t k = 0; k < count; k++) {
+                out[k] = row[k] * scale;
+        }
+}
+
+/******** windowSsim ********
+ *
+ * Reduces the column sums of one window and channel to its SSIM.
+ ************************/
+static double windowSsim(const struct scratch *scratch, int window, int col,
+                         int channel)
+{
+        double sx = 0, sy = 0, sxx = 0, syy = 0, sxy = 0;
+        size_t k = ((size_t) col * window) * CHANNELS + channel;
+        for (int i = 0; i < window; i++, k += CHANNELS) {
+                sx += scratch->sx[k];
+                sy += scratch->sy[k];
+                sxx += scratch->sxx[k];
+                syy += scratch->syy[k];
+                sxy += scratch->sxy[k];
+        }
+
+        double n = (double) window * window;
+        double meanX = sx / n, meanY = sy / n;
+        double varX = sxx / n - meanX * meanX;
+        double varY = syy / n - meanY * meanY;
+        double cov = sxy / n - meanX * meanY;
+        return ((2 * meanX * meanY + SSIM_C1) * (2 * cov + SSIM_C2)) /
+               ((meanX * meanX + meanY * meanY + SSIM_C1) *
+                (varX + varY + SSIM_C2));
+}
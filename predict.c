@@ -0,0 +1,222 @@
+/*
+ *      predict.c
+ *      Kevin Lu (klu07), Justin Paik (jpaik03)
+ *      October 18, 2026
+ *      arith
+ *
+ *      Implementation of spatial prediction. Every predictor falls back the
+ *      same way at the edges: the first block of the image is predicted as
+ *      0, the rest of the first row from the left, and the first block of
+ *      each later row from above. Residuals and predictions wrap modulo
+ *      2^bits, so the inverse is exact.
+ *
+ *      Undoing the up predictor adds the previous row element by element,
+ *      which the compiler vectorizes. Left and MED depend on the value just
+ *      reconstructed, so they run serially along the row.
+ */
+
+#include <stdlib.h>
+#include <assert.h>
+#include <math.h>
+
+#include "predict.h"
+
+static unsigned medianEdge(unsigned left, unsigned up, unsigned upLeft);
+static unsigned predictInterior(const unsigned *up, const unsigned *row,
+                                int col, enum predictor predictor);
+
+/******** predictRow ********
+ *
+ * Replaces one row of values with their residuals from a predictor.
+ *
+ * Parameters:
+ *      const unsigned *up:     The previous row's values, or NULL for the
+ *                                first row
+ *      const unsigned *row:    This row's values
+ *      unsigned *residuals:    Where to store the row's residuals
+ *      int width:              Number of values in a row
+ *      int bits:               Width of the values; residuals wrap modulo
+ *                                2^bits
+ *      enum predictor predictor: The predictor to use
+ * Returns:
+ *      Nothing.
+ * Expects:
+ *      row and residuals are not NULL and do not overlap.
+ *      Every value fits in bits.
+ ************************/
+void predictRow(const unsigned *up, const unsigned *row, unsigned *residuals,
+                int width, int bits, enum predictor predictor)
+{
+        assert(row != NULL && residuals != NULL);
+        assert(predictor < NUM_PREDICTORS);
+        unsigned mask = (1u << bits) - 1;
+
+        if (width <= 0) {
+                return;
+        }
+        if (predictor == PREDICT_NONE) {
+                for (int col = 0; col < width; col++) {
+                        residuals[col] = row[col];
+                }
+                return;
+        }
+
+        residuals[0] = (row[0] - (up != NULL ? up[0] : 0)) & mask;
+        for (int col = 1; col < width; col++) {
+                unsigned prediction = up != NULL ?
+                        predictInterior(up, row, col, predictor) :
+                        row[col - 1];
+                residuals[col] = (row[col] - prediction) & mask;
+        }
+}
+
+/******** unpredictRow ********
+ *
+ * Turns one row of residuals back into values, the inverse of predictRow.
+ *
+ * Parameters:
+ *      const unsigned *up:     The previous row's values (already
+ *                                reconstructed), or NULL for the first row
+ *      unsigned *row:          This row's residuals, replaced by its values
+ *      int width:              Number of values in a row
+ *      int bits:               Width of the values
+ *      enum predictor predictor: The predictor the residuals came from
+ * Returns:
+ *      Nothing.
+ * Expects:
+ *      row is not NULL.
+ ************************/
+void unpredictRow(const unsigned *up, unsigned *row, int width, int bits,
+                  enum predictor predictor)
+{
+        assert(row != NULL);
+        assert(predictor < NUM_PREDICTORS);
+        unsigned mask = (1u << bits) - 1;
+
+        if (width <= 0 || predictor == PREDICT_NONE) {
+                return;
+        }
+
+        row[0] = (row[0] + (up != NULL ? up[0] : 0)) & mask;
+        if (up == NULL || predictor == PREDICT_LEFT) {
+                for (int col = 1; col < width; col++) {
+                        row[col] = (row[col] + row[col - 1]) & mask;
+                }
+        } else if (predictor == PREDICT_UP) {
+                for (int col = 1; col < width; col++) {
+                        row[col] = (row[col] + up[col]) & mask;
+                }
+        } else {
+                for (int col = 1; col < width; col++) {
+                        row[col] = (row[col] + medianEdge(row[col - 1],
+                                                          up[col],
+                                                          up[col - 1])) &
+                                   mask;
+                }
+        }
+}
+
+/******** choosePredictor ********
+ *
+ * Finds the predictor that suits a plane of values best, measured by the
+ * zeroth-order entropy of its residuals.
+ *
+ * Parameters:
+ *      const unsigned *values: The plane's values in row-major order
+ *      int width:              Number of values in a row
+ *      int height:             Number of rows
+ *      int bits:               Width of the values
+ * Returns:
+ *      The predictor with the smallest estimated coded size.
+ * Expects:
+ *      values is not NULL.
+ * Notes:
+ *      Throws a CRE if allocation fails.
+ ************************/
+enum predictor choosePredictor(const unsigned *values, int width, int height,
+                               int bits)
+{
+        assert(values != NULL);
+        if (width <= 0 || height <= 0) {
+                return PREDICT_NONE;
+        }
+
+        size_t numSymbols = (size_t) 1 << bits;
+        unsigned *counts = malloc(numSymbols * sizeof(unsigned));
+        unsigned *residuals = malloc(width * sizeof(unsigned));
+        assert(counts != NULL && residuals != NULL);
+
+        enum predictor best = PREDICT_NONE;
+        double bestCost = HUGE_VAL;
+        double total = (double) width * height;
+        for (int p = PREDICT_NONE; p < NUM_PREDICTORS; p++) {
+                for (size_t s = 0; s < numSymbols; s++) {
+                        counts[s] = 0;
+                }
+                const unsigned *up = NULL;
+                for (int row = 0; row < height; row++) {
+                        const unsigned *current = values + (size_t) row *
+                                                  width;
+                        predictRow(up, current, residuals, width, bits, p);
+                        for (int col = 0; col < width; col++) {
+                                counts[residuals[col]]++;
+                        }
+                        up = current;
+                }
+
+                /* Bits to code every residual with an ideal static model */
+                double cost = 0;
+                for (size_t s = 0; s < numSymbols; s++) {
+                        if (counts[s] > 0) {
+                                cost -= counts[s] * log2(counts[s] / total);
+                        }
+                }
+                if (cost < bestCost) {
+                        bestCost = cost;
+                        best = p;
+                }
+        }
+
+        free(counts);
+        free(residuals);
+        return best;
+}
+
+/******** predictInterior ********
+ *
+ * Predicts a value that has neighbors both to its left and above.
+ ************************/
+static unsigned predictInterior(const unsigned *up, const unsigned *row,
+                                int col, enum predictor predictor)
+{
+        switch (predictor) {
+        case PREDICT_LEFT:
+                return row[col - 1];
+        case PREDICT_UP:
+                return up[col];
+        case PREDICT_MED:
+                return medianEdge(row[col - 1], up[col], up[col - 1]);
+        default:
+                return 0;
+        }
+}
+
+/******** medianEdge ********
+ *
+ * The median edge detector from LOCO-I: the smaller of left and up above
+ * an edge at upLeft, the larger below one, and the planar estimate
+ * left + up - upLeft otherwise.
+ ************************/
+static unsigned medianEdge(unsigned left, unsigned up, unsigned upLeft)
+{
+        unsigned low = left < up ? left : up;
+        unsigned high = left < up ? up : left;
+
+        if (upLeft >= high) {
+                return low;
+        }
+        if (upLeft <= low) {
+                return high;
+        }
+        return left + up - upLeft;
+}
@@ -0,0 +1,33 @@
+/*
+ *      predict.h
+ *      Kevin Lu (klu07), Justin Paik (jpaik03)
+ *      October 18, 2026
+ *      arith
+ *
+ *      Interface for spatial prediction of a quantized field, one block row
+ *      at a time. A value is predicted from the blocks to its left and above
+ *      and replaced by its residual modulo 2^bits, which clusters near zero
+ *      for smooth images and so entropy codes to fewer bytes. Format 3 (see
+ *      entropyCoding.h) predicts each block's a this way.
+ */
+
+#include <stdbool.h>
+
+enum predictor
+{
+        PREDICT_NONE,           /* residual is the value itself */
+        PREDICT_LEFT,           /* block to the left */
+        PREDICT_UP,             /* block above */
+        PREDICT_MED,            /* median edge detector of left, up, up-left */
+        NUM_PREDICTORS
+};
+
+/* up is the previous row's values, or NULL for the first row */
+void predictRow(const unsigned *up, const unsigned *row, unsigned *residuals,
+                int width, int bits, enum predictor predictor);
+void unpredictRow(const unsigned *up, unsigned *row, int width, int bits,
+                  enum predictor predictor);
+
+/* The predictor whose residuals of a row-major plane have least entropy */
+enum predictor choosePredictor(const unsigned *values, int width, int height,
+                               int bits);
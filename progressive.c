@@ -0,0 +1,196 @@
+/*
+ *      progressive.c
+ *      Kevin Lu (klu07), Justin Paik (jpaik03)
+ *      October 18, 2026
+ *      arith
+ *
+ *      Implementation of compressed image format 5. After the usual header
+ *      ("COMP40 Compressed image format 5\n%u %u\n") come two planes, each
+ *      in row-major block order, packed most significant bit first and
+ *      padded to a whole byte:
+ *
+ *        - DC: a (9 bits), indexbpb (4), indexbpr (4) per block, i.e.
+ *          codeword bits 31-23 followed by bits 7-0.
+ *        - Detail: b, c and d (5 bits each) per block, i.e. codeword bits
+ *          22-8.
+ *
+ *      Both planes are cut from and glued back into the format 2 codeword
+ *      (codewordToBytes/codewordFromBytes), so the field layout lives in one
+ *      place.
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <assert.h>
+
+#include "progressive.h"
+#include "codewords.h"
+#include "blockOperation.h"
+#include "bitpack.h"
+#include "bitStream.h"
+
+#define BLOCKSIZE 2
+#define FORMAT 5
+#define DC_BITS 17
+#define DETAIL_BITS 15
+
+static void splitCodeword(const struct quantized *quant, uint64_t *dc,
+                          uint64_t *detail);
+static void joinCodeword(uint64_t dc, uint64_t detail,
+                         struct quantized *quant);
+
+/******** printWordsProgressive ********
+ *
+ * Writes the format 5 header, then the DC plane and the detail plane.
+ *
+ * Parameters:
+ *      FILE *output:           The stream to write to
+ *      UArray2_T quantInts:    An array of 'quantized' structs
+ *      A2Methods_T methods:    The method suite for quantInts
+ *      const struct quantScales *scales:       The scales quantInts was
+ *                                                quantized with, for the
+ *                                                header
+ * Returns:
+ *      Nothing.
+ * Expects:
+ *      output, quantInts and methods are not NULL.
+ * Notes:
+ *      Throws a CRE if an argument is NULL.
+ ************************/
+void printWordsProgressive(FILE *output, UArray2_T quantInts,
+                           A2Methods_T methods,
+                           const struct quantScales *scales)
+{
+        assert(output != NULL);
+        assert(quantInts != NULL);
+        assert(methods != NULL);
+
+        int blocksWide = methods->width(quantInts);
+        int blocksHigh = methods->height(quantInts);
+        writeFormatHeader(output, FORMAT, blocksWide * BLOCKSIZE,
+                          blocksHigh * BLOCKSIZE, scales);
+
+        /* One pass per plane, so the DC plane is complete first */
+        for (int plane = 0; plane < 2; plane++) {
+                struct bitStream stream = { output, 0, 0 };
+                for (int row = 0; row < blocksHigh; row++) {
+                        for (int col = 0; col < blocksWide; col++) {
+                                uint64_t dc, detail;
+                                splitCodeword(methods->at(quantInts, col,
+                                                          row),
+                                              &dc, &detail);
+                                if (plane == 0) {
+                                        putBits(&stream, dc, DC_BITS);
+                                } else {
+                                        putBits(&stream, detail,
+                                                DETAIL_BITS);
+                                }
+                        }
+                }
+                flushBits(&stream);
+        }
+}
+
+/******** readWordsProgressive ********
+ *
+ * Reads the DC plane and as much of the detail plane as asked for, and
+ * unpacks every block's fields.
+ *
+ * Parameters:
+ *      FILE *input:            File pointer positioned after the header
+ *      A2Methods_T methods:    The method suite for array operations
+ *      unsigned width:         The width of the image in pixels
+ *      unsigned height:        The height of the image in pixels
+ *      enum refinement refinement: How much of the detail plane to read
+ * Returns:
+ *      A UArray2_T where each element is a 'quantized' struct. Blocks whose
+ *      detail was not read have b, c and d of 0 (flat blocks).
+ * Expects:
+ *      input and methods are not NULL.
+ * Notes:
+ *      Throws a CRE if input or methods is NULL or allocation fails.
+ *      Throws a CRE if the DC plane is incomplete, or if the detail plane is
+ *        incomplete and refinement is DETAIL_REQUIRED.
+ *      With DC_ONLY, stops reading at the end of the DC plane.
+ ************************/
+UArray2_T readWordsProgressive(FILE *input, A2Methods_T methods,
+                               unsigned width, unsigned height,
+                               enum refinement refinement)
+{
+        assert(input != NULL);
+        assert(methods != NULL);
+
+        int blocksWide = width / BLOCKSIZE;
+        int blocksHigh = height / BLOCKSIZE;
+        UArray2_T quantInts = methods->new(blocksWide, blocksHigh,
+                                           sizeof(struct quantized));
+        assert(quantInts != NULL);
+
+        struct bitStream stream = { input, 0, 0 };
+        for (int row = 0; row < blocksHigh; row++) {
+                for (int col = 0; col < blocksWide; col++) {
+                        uint64_t dc;
+                        bool read = getBits(&stream, DC_BITS, &dc);
+                        assert(read);
+                        joinCodeword(dc, 0, methods->at(quantInts, col,
+                                                        row));
+                }
+        }
+        if (refinement == DC_ONLY) {
+                return quantInts;
+        }
+
+        /* The detail plane starts on a byte boundary */
+        alignBits(&stream);
+        for (int row = 0; row < blocksHigh; row++) {
+                for (int col = 0; col < blocksWide; col++) {
+                        uint64_t detail;
+                        if (!getBits(&stream, DETAIL_BITS, &detail)) {
+                                assert(refinement == DETAIL_AVAILABLE);
+                                return quantInts;
+                        }
+                        struct quantized *quant = methods->at(quantInts,
+                                                              col, row);
+                        uint64_t dc, unused;
+                        splitCodeword(quant, &dc, &unused);
+                        joinCodeword(dc, detail, quant);
+                }
+        }
+        return quantInts;
+}
+
+/******** splitCodeword ********
+ *
+ * Packs a block into its format 2 codeword and cuts that into the DC and
+ * detail fields.
+ ************************/
+static void splitCodeword(const struct quantized *quant, uint64_t *dc,
+                          uint64_t *detail)
+{
+        unsigned char bytes[4];
+        codewordToBytes(quant, bytes);
+        uint64_t word = (uint64_t) bytes[0] << 24 | bytes[1] << 16 |
+                        bytes[2] << 8 | bytes[3];
+
+        *dc = Bitpack_newu(Bitpack_getu(word, 8, 0), 9, 8,
+                           Bitpack_getu(word, 9, 23));
+        *detail = Bitpack_getu(word, DETAIL_BITS, 8);
+}
+
+/******** joinCodeword ********
+ *
+ * Glues DC and detail fields back into a format 2 codeword and unpacks it
+ * into a block.
+ ************************/
+static void joinCodeword(uint64_t dc, uint64_t detail,
+                         struct quantized *quant)
+{
+        uint64_t word = 0;
+        word = Bitpack_newu(word, 9, 23, Bitpack_getu(dc, 9, 8));
+        word = Bitpack_newu(word, DETAIL_BITS, 8, detail);
+        word = Bitpack_newu(word, 8, 0, Bitpack_getu(dc, 8, 0));
+
+        unsigned char bytes[4] = { word >> 24, word >> 16, word >> 8, word };
+        codewordFromBytes(bytes, quant);
+}
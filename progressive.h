@@ -0,0 +1,38 @@
+/*
+ *      progressive.h
+ *      Kevin Lu (klu07), Justin Paik (jpaik03)
+ *      October 18, 2026
+ *      arith
+ *
+ *      Interface for compressed image format 5, a progressive layout of the
+ *      format 2 codewords. Every block's a, indexbpb and indexbpr (17 bits)
+ *      come first, then every block's b, c and d (15 bits). The first plane
+ *      is 17/32 of the data and is all a half-resolution decode needs; the
+ *      second refines the image to full resolution as it arrives.
+ */
+
+#include <stdio.h>
+
+#include "uarray2.h"
+#include "a2methods.h"
+
+/* Defined in blockOperation.h */
+struct quantScales;
+
+/* How much of the detail plane to read */
+enum refinement
+{
+        DC_ONLY,                /* none: b, c and d are left 0 */
+        DETAIL_AVAILABLE,       /* as much as the input holds */
+        DETAIL_REQUIRED         /* all of it */
+};
+
+/* Compression: writes the header too */
+void printWordsProgressive(FILE *output, UArray2_T quantInts,
+                           A2Methods_T methods,
+                           const struct quantScales *scales);
+
+/* Decompression: input is positioned just past the header */
+UArray2_T readWordsProgressive(FILE *input, A2Methods_T methods,
+                               unsigned width, unsigned height,
+                               enum refinement refinement);
@@ -5,7 +5,7 @@
  *      arith
  * 
  *      Implementation for reading a PPM image from a file, trimming it to even
- *      dimensions, and writing a PPM image back to standard output.
+ *      dimensions, and writing a PPM image back to an output stream.
  */
 
 #include <stdlib.h>
@@ -15,26 +15,31 @@
 #include "a2plain.h"
 #include "a2blocked.h"
 #include "a2methods.h"
+#include "trace.h"
 
 #define BLOCKSIZE 2
 
 /* Initialize helper functions, see function contracts below */
-static Pnm_ppm trimImage(Pnm_ppm img, A2Methods_mapfun *map);
+static Pnm_ppm trimImage(Pnm_ppm img, int blockSize);
 static void copyPixel(int col, int row, A2Methods_UArray2 newArray, void *elem,
                       void *cl);
 
 /******** copyClosure struct ********
  *
  * A struct to pass necessary data (a closure) into the apply function of a
- * mapping function. Used for trimming the image.
+ * mapping function. Used for cropping the image.
  *
  * Fields:
- *      Pnm_ppm oldImg: A pointer to the original, untrimmed image from which
+ *      Pnm_ppm oldImg: A pointer to the original, uncropped image from which
  *                        pixels will be copied.
+ *      int colOffset:  Column of oldImg that becomes the first column
+ *      int rowOffset:  Row of oldImg that becomes the first row
  ************************/
 struct copyClosure
 {
         Pnm_ppm oldImg;
+        int colOffset;
+        int rowOffset;
 };
 
 /******** readImage ********
@@ -53,87 +58,128 @@ struct copyClosure
  *      Throws a CRE if fp is NULL.
  *      Throws a CRE if methods or map functions fail.
  *      Throws a CRE if Pnm_ppmread fails (e.g., NULL image).
- *      Calls helper function trimImage, which handles trimming and freeing the
- *        original image memory if trimming occurs.
+ *      Calls helper function trimImage, which trims without copying: an
+ *        image with an odd dimension keeps its extra row or column in its
+ *        pixel array, outside its width and height.
  ************************/
 Pnm_ppm readImage(FILE *fp)
+{
+        return readImageBlocks(fp, BLOCKSIZE);
+}
+
+/******** readImageBlocks ********
+ *
+ * Reads a PPM image and trims it to a whole number of blocks of the given
+ * size in each direction.
+ *
+ * Parameters:
+ *      FILE *fp:       A file pointer to the input PPM image stream
+ *      int blockSize:  The side of the transform blocks (2, 4 or 8)
+ * Returns:
+ *      A Pnm_ppm struct pointer containing the trimmed image data.
+ * Expects:
+ *      fp is not NULL and points to a valid, open PPM image file.
+ *      blockSize is positive.
+ * Notes:
+ *      Throws a CRE if fp is NULL, blockSize is not positive, or reading
+ *        fails.
+ *      readImage is this with blockSize 2. The image is a view on the
+ *        top-left of the pixels read (see trimImage).
+ ************************/
+Pnm_ppm readImageBlocks(FILE *fp, int blockSize)
 {
         assert(fp != NULL);
+        assert(blockSize > 0);
         
-        /* Default to blocked methods to prepare for 2x2 pixel blocks */
+        /* Default to blocked methods to prepare for pixel blocks */
         A2Methods_T methods = uarray2_methods_blocked;
         assert(methods != NULL);
         
-        A2Methods_mapfun *map = methods->map_default;
-        assert(map != NULL);
-        
         /* Read the image using the pnm interface */
+        traceBegin("read PPM", "io");
         Pnm_ppm img = Pnm_ppmread(fp, methods);
+        traceEnd();
         assert(img != NULL);
 
-        /* Call helper function to get even dimensions */
-        return trimImage(img, map);
+        /* Call helper function to get whole blocks */
+        return trimImage(img, blockSize);
 }
 
 /******** trimImage ********
  *
- * Trims an image to the largest possible even width and height. If the image
- * already has even dimensions, it is returned unmodified. Otherwise, a new,
- * smaller image is created, the pixels are copied, and the original image is
- * freed.
+ * Trims an image to the largest possible width and height that are
+ * multiples of blockSize, as a view: only the image's width and height
+ * change, so it then covers the top-left corner of its own pixel array.
+ * No pixel is copied and nothing is allocated.
  *
  * Parameters:
- *      Pnm_ppm oldImg:         A pointer to the original image structure
- *      A2Methods_mapfun *map:  The mapping function to use for copying pixels
+ *      Pnm_ppm img:    A pointer to the image structure
+ *      int blockSize:  The side of a block
  * Returns:
- *      A Pnm_ppm struct pointer to the (potentially new) trimmed image.
+ *      img, with its width and height trimmed.
  * Expects:
- *      oldImg is not NULL and contains valid PPM data.
- *      map is not NULL.
+ *      img is not NULL and contains valid PPM data.
  * Notes:
- *      Throws a CRE if memory allocation for newImg fails.
- *      Throws a CRE if the pixel array of newImg fails.
- *      If trimming is necessary, this function allocates memory for a new
- *        Pnm_ppm struct and its pixel array, which the caller is responsible
- *        for freeing.
- *      This function will trim at most 1 row and 1 column from the original
- *        image.
- *      Frees the original oldImg and its pixel array if a new image is created.
+ *      Throws a CRE if img is NULL.
+ *      This function will trim at most blockSize - 1 rows and columns from
+ *        the image. The trimmed pixels stay in the array until the image is
+ *        freed, which frees them with the rest; code reading the image must
+ *        go by its width and height, not the array's.
  ************************/
-static Pnm_ppm trimImage(Pnm_ppm oldImg, A2Methods_mapfun *map)
+static Pnm_ppm trimImage(Pnm_ppm img, int blockSize)
+{
+        assert(img != NULL);
+        assert(img->methods != NULL);
+
+        img->width = (img->width / blockSize) * blockSize;
+        img->height = (img->height / blockSize) * blockSize;
+        return img;
+}
+
+/******** cropImage ********
+ *
+ * Cuts a rectangle out of an image.
+ *
+ * Parameters:
+ *      Pnm_ppm oldImg: The image to crop
+ *      int col, row:   Top-left corner of the rectangle in oldImg
+ *      int width:      Width of the rectangle
+ *      int height:     Height of the rectangle
+ * Returns:
+ *      A Pnm_ppm holding just the rectangle; oldImg itself if the rectangle
+ *      covers all of it.
+ * Expects:
+ *      oldImg is not NULL and the rectangle lies within it.
+ * Notes:
+ *      Throws a CRE if an expectation is violated or allocation fails.
+ *      Frees oldImg and its pixel array if a new image is created.
+ ************************/
+Pnm_ppm cropImage(Pnm_ppm oldImg, int col, int row, int width, int height)
 {
         assert(oldImg != NULL);
         assert(oldImg->methods != NULL);
-        assert(map != NULL);
+        assert(col >= 0 && row >= 0 && width > 0 && height > 0);
+        assert(col + width <= (int) oldImg->width);
+        assert(row + height <= (int) oldImg->height);
 
-        int newWidth = ((int) oldImg->width / BLOCKSIZE) * BLOCKSIZE;
-        int newHeight = ((int) oldImg->height / BLOCKSIZE) * BLOCKSIZE;
-        /* If dimensions are unchanged, no trimming is needed */
-        if (newWidth == (int) oldImg->width &&
-            newHeight == (int) oldImg->height) {
+        if (col == 0 && row == 0 && width == (int) oldImg->width &&
+            height == (int) oldImg->height) {
                 return oldImg;
         }
 
-        /* Create new image to hold the trimmed version */
         Pnm_ppm newImg = malloc(sizeof(*newImg));
         assert(newImg != NULL);
-        
-        /* Populate new image's struct from old image, but use new dimensions */
         newImg->denominator = oldImg->denominator;
         newImg->methods = oldImg->methods;
-        newImg->width = newWidth;
-        newImg->height = newHeight;
-        newImg->pixels = oldImg->methods->new(newWidth, newHeight, 
+        newImg->width = width;
+        newImg->height = height;
+        newImg->pixels = oldImg->methods->new(width, height, 
                                               sizeof(struct Pnm_rgb));
         assert(newImg->pixels != NULL);
 
-        /* Set up closure with pointer to the old image for copying */
-        struct copyClosure closure = { .oldImg = oldImg };
-        
-        /* Copy the old image, ignoring ("trimming") the last odd row/column */
-        map(newImg->pixels, copyPixel, &closure);
+        struct copyClosure closure = { oldImg, col, row };
+        oldImg->methods->map_default(newImg->pixels, copyPixel, &closure);
 
-        /* Free old image's pixel and struct */
         oldImg->methods->free(&(oldImg->pixels));
         free(oldImg);
 
@@ -142,9 +188,9 @@ static Pnm_ppm trimImage(Pnm_ppm oldImg, A2Methods_mapfun *map)
 
 /******** copyPixel ********
  *
- * Apply function used by trimImage. Copies a single pixel from the original
- * (larger) image to the corresponding position in the new (smaller) destination
- * array.
+ * Apply function used by cropImage. Copies a single pixel from
+ * the original (larger) image to the corresponding position in the new
+ * (smaller) destination array.
  *
  * Parameters:
  *      int col:        Column index of current pixel in new array
@@ -157,7 +203,8 @@ static Pnm_ppm trimImage(Pnm_ppm oldImg, A2Methods_mapfun *map)
  * Expects:
  *      cl is not NULL and points to a valid copyClosure struct.
  *      elem is not NULL and points to a valid Pnm_rgb pixel.
- *      The oldImg inside cl is valid and contains a pixel at (col, row).
+ *      The oldImg inside cl is valid and contains a pixel at
+ *        (col + colOffset, row + rowOffset).
  * Notes:
  *      Modifies the destination array (via elem) by copying the pixel value
  *        from the old image.
@@ -180,7 +227,8 @@ static void copyPixel(int col, int row, A2Methods_UArray2 newArray,
         
         /* Performs the pixel map */
         Pnm_rgb oldPixel = closure->oldImg->methods->at(closure->oldImg->pixels,
-                                                        col, row);
+                                                col + closure->colOffset,
+                                                row + closure->rowOffset);
         assert(oldPixel != NULL);
         
         /* Copy the RGB values directly */
@@ -189,22 +237,27 @@ static void copyPixel(int col, int row, A2Methods_UArray2 newArray,
 
 /******** writeImage ********
  *
- * Writes a Pnm_ppm image to standard output in the PPM plain format.
+ * Writes a Pnm_ppm image to an output stream in the PPM plain format.
  *
  * Parameters:
+ *      FILE *output:   The stream to write to, normally stdout
  *      Pnm_ppm pixmap: A pointer to the Pnm_ppm struct to be written
  * Returns:
  *      Nothing.
  * Expects:
+ *      output is not NULL.
  *      pixmap is not NULL and contains valid image data.
  * Notes:
  *      Wraps the Pnm_ppmwrite function.
  ************************/
-void writeImage(Pnm_ppm pixmap)
+void writeImage(FILE *output, Pnm_ppm pixmap)
 {
+        assert(output != NULL);
         assert(pixmap != NULL);
         assert(pixmap->methods != NULL);
         assert(pixmap->pixels != NULL);
 
-        Pnm_ppmwrite(stdout, pixmap);
+        traceBegin("write PPM", "io");
+        Pnm_ppmwrite(output, pixmap);
+        traceEnd();
 }
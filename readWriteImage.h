@@ -6,14 +6,21 @@
  * 
  *      Interface for reading, trimming, and writing PPM images. This module
  *      handles the C1 and (C1)' steps which involve reading a PPM from input,
- *      ensuring it has even dimensions, and writing a PPM to standard output.
+ *      ensuring it has whole blocks, and writing a PPM to an output stream.
  */
 
 #include <stdio.h>
 #include "pnm.h"
 
-/* Compression */
+/*
+ * Compression: readImage trims to even dimensions, readImageBlocks to a
+ * multiple of blockSize. Trimming only shrinks width and height, so the
+ * pixel array may be up to blockSize - 1 larger in each direction; read
+ * the image by its width and height.
+ */
 Pnm_ppm readImage(FILE *fp);
+Pnm_ppm readImageBlocks(FILE *fp, int blockSize);
 
 /* Decompression */
-void writeImage(Pnm_ppm pixmap);
+Pnm_ppm cropImage(Pnm_ppm oldImg, int col, int row, int width, int height);
+void writeImage(FILE *output, Pnm_ppm pixmap);
@@ -0,0 +1,991 @@
+/*
+ *      server40.c
+ *      Kevin Lu (klu07), Justin Paik (jpaik03)
+ *      October 18, 2026
+ *      arith
+ *
+ *      Implementation of server mode and its client.
+ *
+ *      Every request and reply starts with a fixed header in host byte order
+ *      (both ends are on the same machine). A request's op says whether to
+ *      compress or decompress, and whether the input comes inline (length
+ *      bytes after the header) or as a pair of passed descriptors (input,
+ *      output). A reply's status is 0 on success; its payload is then the
+ *      output, or nothing if the output went to a passed descriptor. On
+ *      failure the payload is an error message.
+ *
+ *      Jobs run through the in-memory interface (compress40mem.h), so the
+ *      server checks each input itself and a bad request cannot end the
+ *      process. Each worker keeps its input and output buffers between
+ *      requests and only grows them, and the decoder's table is built before
+ *      the first connection is accepted.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <assert.h>
+#include <errno.h>
+#include <signal.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+
+#include "server40.h"
+#include "compress40mem.h"
+#include "tableDecode.h"
+#include "stageTimer.h"
+#include "trace.h"
+
+#define PROTOCOL_MAGIC 0x30347261u      /* "ar40" on little-endian hosts */
+#define OP_COMPRESS 1u
+#define OP_DECOMPRESS 2u
+#define OP_PASS_FDS 0x100u              /* input/output are passed fds */
+#define STATUS_OK 0u
+#define STATUS_ERROR 1u
+
+#define MAX_PAYLOAD ((uint64_t) 1 << 30)
+#define QUEUE_SIZE 64
+#define COPY_CHUNK (1 << 16)
+
+/******** messageHeader struct ********
+ *
+ * The fixed part of every request and reply, ahead of its payload.
+ *
+ * Fields:
+ *      uint32_t magic:         PROTOCOL_MAGIC
+ *      uint32_t op:            The operation in a request, the status in a
+ *                                reply
+ *      uint64_t length:        Number of payload bytes that follow
+ ************************/
+struct messageHeader
+{
+        uint32_t magic;
+        uint32_t op;
+        uint64_t length;
+};
+
+/******** connectionQueue struct ********
+ *
+ * Accepted connections waiting for a worker. There is one, at file scope,
+ * so that it outlives every worker.
+ *
+ * Fields:
+ *      int fds[QUEUE_SIZE]:    A ring of connected sockets
+ *      int head, count:        Index of the oldest and how many are queued
+ *      bool closing:           Set at shutdown: workers serve what is left,
+ *                                then return
+ *      pthread_mutex_t lock:   Guards every other field
+ *      pthread_cond_t notEmpty, notFull:       Signalled as fds are added
+ *                                                and taken
+ ************************/
+struct connectionQueue
+{
+        int fds[QUEUE_SIZE];
+        int head;
+        int count;
+        bool closing;
+        pthread_mutex_t lock;
+        pthread_cond_t notEmpty;
+        pthread_cond_t notFull;
+};
+
+/******** workerBuffers struct ********
+ *
+ * A worker's buffers, kept for every request it serves.
+ *
+ * Fields:
+ *      unsigned char *in:      The request payload
+ *      size_t inCapacity:      Bytes allocated for in
+ *      unsigned char *out:     The reply payload
+ *      size_t outCapacity:     Bytes allocated for out
+ ************************/
+struct workerBuffers
+{
+        unsigned char *in;
+        size_t inCapacity;
+        unsigned char *out;
+        size_t outCapacity;
+};
+
+static volatile sig_atomic_t stopping = 0;
+static struct connectionQueue queue = {
+        .lock = PTHREAD_MUTEX_INITIALIZER,
+        .notEmpty = PTHREAD_COND_INITIALIZER,
+        .notFull = PTHREAD_COND_INITIALIZER
+};
+
+static void handleStop(int signal);
+static void *runServerWorker(void *cl);
+static int acceptConnection(int listener, const sigset_t *waitMask);
+static void serveConnection(int fd, struct workerBuffers *buffers);
+static uint32_t runRequest(uint32_t op, size_t length,
+                           struct workerBuffers *buffers, size_t *outLength,
+                           const char **message);
+static uint32_t compressRequest(const unsigned char *in, size_t length,
+                                struct workerBuffers *buffers,
+                                size_t *outLength, const char **message);
+static uint32_t decompressRequest(const unsigned char *in, size_t length,
+                                  struct workerBuffers *buffers,
+                                  size_t *outLength, const char **message);
+static size_t parsePPMHeader(const unsigned char *bytes, size_t length,
+                             unsigned *width, unsigned *height,
+                             unsigned *denominator);
+static bool parseNumber(const unsigned char *bytes, size_t length,
+                        size_t *pos, unsigned *value);
+static void ensureCapacity(unsigned char **buffer, size_t *capacity,
+                           size_t needed);
+static bool readAll(int fd, unsigned char **buffer, size_t *capacity,
+                    size_t *length);
+static bool readFully(int fd, void *buffer, size_t length);
+static bool writeFully(int fd, const void *buffer, size_t length);
+static ssize_t receiveHeader(int fd, struct messageHeader *header,
+                             int *fds, int *numFds);
+static bool sendHeader(int fd, struct messageHeader *header, int *fds,
+                       int numFds);
+static int openSocket(const char *socketPath, struct sockaddr_un *address);
+
+/******** serve40 ********
+ *
+ * Listens on a Unix domain socket and serves requests until SIGINT or
+ * SIGTERM.
+ *
+ * Parameters:
+ *      const char *socketPath: Where to create the socket
+ *      int numWorkers:         Threads in the pool, 0 for one per CPU
+ * Returns:
+ *      EXIT_SUCCESS after a clean shutdown, EXIT_FAILURE if the socket
+ *      could not be set up.
+ * Expects:
+ *      socketPath is not NULL.
+ * Notes:
+ *      A stale socket left at socketPath by an earlier server is replaced;
+ *        any other kind of file there is an error.
+ *      The socket file is removed on shutdown.
+ *      On shutdown no new connection is accepted, but the queued ones are
+ *        still served and every worker is joined before returning, so a
+ *        connection in progress delays the return until its client closes
+ *        it.
+ ************************/
+int serve40(const char *socketPath, int numWorkers)
+{
+        assert(socketPath != NULL);
+
+        struct sockaddr_un address;
+        int listener = openSocket(socketPath, &address);
+        if (listener < 0) {
+                return EXIT_FAILURE;
+        }
+
+        struct stat info;
+        if (lstat(socketPath, &info) == 0 && S_ISSOCK(info.st_mode)) {
+                unlink(socketPath);
+        }
+        if (bind(listener, (struct sockaddr *) &address,
+                 sizeof(address)) != 0 || listen(listener, SOMAXCONN) != 0) {
+                fprintf(stderr, "40image: %s: %s\n", socketPath,
+                        strerror(errno));
+                close(listener);
+                return EXIT_FAILURE;
+        }
+
+        /* Non-blocking, so a client that gives up between pselect and
+         * accept cannot leave accept waiting */
+        fcntl(listener, F_SETFL, fcntl(listener, F_GETFL) | O_NONBLOCK);
+
+        /* Warm everything a job needs before the first one arrives */
+        tableDecodeInit();
+        signal(SIGPIPE, SIG_IGN);
+
+        if (numWorkers <= 0) {
+                numWorkers = (int) sysconf(_SC_NPROCESSORS_ONLN);
+        }
+        if (numWorkers < 1) {
+                numWorkers = 1;
+        }
+
+        queue.head = 0;
+        queue.count = 0;
+        queue.closing = false;
+        stopping = 0;
+
+        /* SIGINT and SIGTERM stay blocked everywhere but in pselect, so
+         * one arriving outside it waits there instead of being missed.
+         * The workers inherit the blocked mask and never see them */
+        sigset_t stopSignals, waitMask;
+        sigemptyset(&stopSignals);
+        sigaddset(&stopSignals, SIGINT);
+        sigaddset(&stopSignals, SIGTERM);
+        pthread_sigmask(SIG_BLOCK, &stopSignals, &waitMask);
+        sigdelset(&waitMask, SIGINT);
+        sigdelset(&waitMask, SIGTERM);
+
+        pthread_t *threads = malloc(numWorkers * sizeof(pthread_t));
+        assert(threads != NULL);
+        for (int i = 0; i < numWorkers; i++) {
+                int result = pthread_create(&threads[i], NULL,
+                                            runServerWorker, &queue);
+                assert(result == 0);
+        }
+
+        struct sigaction action;
+        memset(&action, 0, sizeof(action));
+        action.sa_handler = handleStop;
+        sigaction(SIGINT, &action, NULL);
+        sigaction(SIGTERM, &action, NULL);
+
+        fprintf(stderr, "40image: serving on %s with %d workers\n",
+                socketPath, numWorkers);
+
+        while (!stopping) {
+                int fd = acceptConnection(listener, &waitMask);
+                if (fd < 0) {
+                        continue;
+                }
+
+                pthread_mutex_lock(&queue.lock);
+                while (queue.count == QUEUE_SIZE) {
+                        pthread_cond_wait(&queue.notFull, &queue.lock);
+                }
+                queue.fds[(queue.head + queue.count) % QUEUE_SIZE] = fd;
+                queue.count++;
+                pthread_cond_signal(&queue.notEmpty);
+                pthread_mutex_unlock(&queue.lock);
+        }
+
+        /* Stop accepting, let the workers drain the queue, then join them */
+        close(listener);
+        unlink(socketPath);
+        pthread_mutex_lock(&queue.lock);
+        queue.closing = true;
+        pthread_cond_broadcast(&queue.notEmpty);
+        pthread_mutex_unlock(&queue.lock);
+        for (int i = 0; i < numWorkers; i++) {
+                pthread_join(threads[i], NULL);
+        }
+        free(threads);
+        return EXIT_SUCCESS;
+}
+
+/******** acceptConnection ********
+ *
+ * Waits for a connection or a stop signal, whichever comes first.
+ *
+ * Parameters:
+ *      int listener:                   The non-blocking listening socket
+ *      const sigset_t *waitMask:       The signal mask to wait under, with
+ *                                        SIGINT and SIGTERM unblocked
+ * Returns:
+ *      The connected socket, or -1 if a signal arrived or the connection
+ *      went away before it was accepted.
+ * Notes:
+ *      pselect unblocks the stop signals only while it waits, so one sent
+ *        just before the call interrupts it rather than being lost.
+ ************************/
+static int acceptConnection(int listener, const sigset_t *waitMask)
+{
+        fd_set readable;
+        FD_ZERO(&readable);
+        FD_SET(listener, &readable);
+        if (pselect(listener + 1, &readable, NULL, NULL, NULL,
+                    waitMask) <= 0) {
+                return -1;
+        }
+
+        int fd = accept(listener, NULL, NULL);
+        if (fd >= 0) {
+                /* Accepted sockets do not inherit O_NONBLOCK on Linux, but
+                 * other systems differ */
+                fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_NONBLOCK);
+        }
+        return fd;
+}
+
+/******** handleStop ********
+ *
+ * SIGINT/SIGTERM handler: asks the accept loop to stop.
+ ************************/
+static void handleStop(int signal)
+{
+        (void) signal;
+        stopping = 1;
+}
+
+/******** runServerWorker ********
+ *
+ * Thread body: serves connections from the queue, one at a time, until the
+ * queue is closing and empty.
+ *
+ * Parameters:
+ *      void *cl:       The struct connectionQueue filled by serve40
+ * Returns:
+ *      NULL, once serve40 has closed the queue and it is drained.
+ ************************/
+static void *runServerWorker(void *cl)
+{
+        struct connectionQueue *queue = cl;
+        struct workerBuffers buffers = { NULL, 0, NULL, 0 };
+
+        for (;;) {
+                pthread_mutex_lock(&queue->lock);
+                while (queue->count == 0 && !queue->closing) {
+                        pthread_cond_wait(&queue->notEmpty, &queue->lock);
+                }
+                if (queue->count == 0) {
+                        pthread_mutex_unlock(&queue->lock);
+                        break;
+                }
+                int fd = queue->fds[queue->head];
+                queue->head = (queue->head + 1) % QUEUE_SIZE;
+                queue->count--;
+                pthread_cond_signal(&queue->notFull);
+                pthread_mutex_unlock(&queue->lock);
+
+                serveConnection(fd, &buffers);
+                close(fd);
+        }
+
+        free(buffers.in);
+        free(buffers.out);
+        return NULL;
+}
+
+/******** serveConnection ********
+ *
+ * Answers requests on one client connection until the client closes it or
+ * sends something that is not a request.
+ *
+ * Parameters:
+ *      int fd:                         The connected socket
+ *      struct workerBuffers *buffers:  The worker's reusable buffers
+ * Returns:
+ *      Nothing.
+ ************************/
+static void serveConnection(int fd, struct workerBuffers *buffers)
+{
+        for (;;) {
+                struct messageHeader request;
+                int fds[2];
+                int numFds = 0;
+                if (receiveHeader(fd, &request, fds, &numFds) <= 0 ||
+                    request.magic != PROTOCOL_MAGIC) {
+                        for (int i = 0; i < numFds; i++) {
+                                close(fds[i]);
+                        }
+                        return;
+                }
+
+                bool passFds = (request.op & OP_PASS_FDS) != 0;
+                size_t length = 0;
+                bool haveInput;
+                if (passFds) {
+                        haveInput = numFds == 2 &&
+                                    readAll(fds[0], &buffers->in,
+                                            &buffers->inCapacity, &length);
+                } else {
+                        haveInput = numFds == 0 &&
+                                    request.length <= MAX_PAYLOAD;
+                        if (haveInput) {
+                                length = request.length;
+                                ensureCapacity(&buffers->in,
+                                               &buffers->inCapacity, length);
+                                haveInput = readFully(fd, buffers->in,
+                                                      length);
+                        }
+                }
+
+                size_t outLength = 0;
+                const char *message = "bad request";
+                uint32_t status = STATUS_ERROR;
+                if (haveInput) {
+                        traceBegin(request.op & OP_DECOMPRESS ?
+                                   "decompress request" : "compress request",
+                                   "worker");
+                        status = runRequest(request.op & ~OP_PASS_FDS, length,
+                                            buffers, &outLength, &message);
+                        traceEnd();
+                        traceFlush();
+                }
+
+                if (status == STATUS_OK && passFds &&
+                    !writeFully(fds[1], buffers->out, outLength)) {
+                        status = STATUS_ERROR;
+                        message = "could not write output";
+                }
+                for (int i = 0; i < numFds; i++) {
+                        close(fds[i]);
+                }
+
+                const unsigned char *payload = buffers->out;
+                if (status != STATUS_OK) {
+                        payload = (const unsigned char *) message;
+                        outLength = strlen(message);
+                } else if (passFds) {
+                        outLength = 0;
+                }
+                struct messageHeader reply = { PROTOCOL_MAGIC, status,
+                                               outLength };
+                if (!sendHeader(fd, &reply, NULL, 0) ||
+                    !writeFully(fd, payload, outLength) || !haveInput) {
+                        return;
+                }
+        }
+}
+
+/******** runRequest ********
+ *
+ * Runs one job on the input held in buffers->in.
+ *
+ * Parameters:
+ *      uint32_t op:                    OP_COMPRESS or OP_DECOMPRESS
+ *      size_t length:                  Bytes of input
+ *      struct workerBuffers *buffers:  Holds the input; receives the output
+ *      size_t *outLength:              Where to store the output size
+ *      const char **message:           Where to store an error message
+ * Returns:
+ *      STATUS_OK, or STATUS_ERROR with *message set.
+ ************************/
+static uint32_t runRequest(uint32_t op, size_t length,
+                           struct workerBuffers *buffers, size_t *outLength,
+                           const char **message)
+{
+        if (op == OP_COMPRESS) {
+                return compressRequest(buffers->in, length, buffers,
+                                       outLength, message);
+        } else if (op == OP_DECOMPRESS) {
+                return decompressRequest(buffers->in, length, buffers,
+                                         outLength, message);
+        }
+        *message = "unknown operation";
+        return STATUS_ERROR;
+}
+
+/******** compressRequest ********
+ *
+ * Compresses a raw (P6) PPM file held in memory into buffers->out.
+ *
+ * Parameters:
+ *      const unsigned char *in:        The PPM file
+ *      size_t length:                  Its size in bytes
+ *      struct workerBuffers *buffers:  Receives the compressed image
+ *      size_t *outLength:              Where to store its size
+ *      const char **message:           Where to store an error message
+ * Returns:
+ *      STATUS_OK, or STATUS_ERROR with *message set.
+ * Notes:
+ *      The output is byte for byte what 40image -c writes for the file.
+ ************************/
+static uint32_t compressRequest(const unsigned char *in, size_t length,
+                                struct workerBuffers *buffers,
+                                size_t *outLength, const char **message)
+{
+        unsigned width, height, denominator;
+        size_t header = parsePPMHeader(in, length, &width, &height,
+                                       &denominator);
+        if (header == 0) {
+                *message = "not a raw (P6) PPM image";
+                return STATUS_ERROR;
+        }
+
+        size_t stride = (size_t) width * 3 * (denominator < 256 ? 1 : 2);
+        if (width > length || height > length ||
+            (uint64_t) stride * height > length - header) {
+                *message = "PPM image is truncated";
+                return STATUS_ERROR;
+        }
+
+        if (width < 2 || height < 2) {
+                *message = "image is too small to compress";
+                return STATUS_ERROR;
+        }
+
+        /* The buffer always fits, so compress40_mem refuses the image only
+         * for a sample above maxval, which it checks before packing any */
+        size_t bound = compress40_bound(width, height);
+        ensureCapacity(&buffers->out, &buffers->outCapacity, bound);
+        *outLength = compress40_mem(in + header, width, height, stride,
+                                    denominator, &buffers->out,
+                                    buffers->outCapacity);
+        if (*outLength == 0) {
+                *message = "PPM sample above its maxval";
+                return STATUS_ERROR;
+        }
+        stageReport(stderr, width, height);
+        return STATUS_OK;
+}
+
+/******** decompressRequest ********
+ *
+ * Decompresses a compressed image held in memory into a raw PPM file in
+ * buffers->out.
+ *
+ * Parameters:
+ *      const unsigned char *in:        The compressed image
+ *      size_t length:                  Its size in bytes
+ *      struct workerBuffers *buffers:  Receives the PPM file
+ *      size_t *outLength:              Where to store its size
+ *      const char **message:           Where to store an error message
+ * Returns:
+ *      STATUS_OK, or STATUS_ERROR with *message set.
+ * Notes:
+ *      The output is byte for byte what 40image -d writes for the image.
+ ************************/
+static uint32_t decompressRequest(const unsigned char *in, size_t length,
+                                  struct workerBuffers *buffers,
+                                  size_t *outLength, const char **message)
+{
+        unsigned width, height;
+        if (!decompress40_info(in, length, &width, &height) ||
+            width == 0 || height == 0 || width % 2 != 0 ||
+            height % 2 != 0) {
+                *message = "not a compressed image";
+                return STATUS_ERROR;
+        }
+
+        /* A 2x2 block takes 4 bytes, so a valid image has width * height
+         * below length; checked before the output buffer is sized */
+        if ((uint64_t) width * height > length) {
+                *message = "compressed image is truncated";
+                return STATUS_ERROR;
+        }
+
+        char header[64];
+        size_t headerLength = snprintf(header, sizeof(header),
+                                       "P6\n%u %u\n255\n", width, height);
+        size_t stride = (size_t) width * 3;
+        ensureCapacity(&buffers->out, &buffers->outCapacity,
+                       headerLength + stride * height);
+        memcpy(buffers->out, header, headerLength);
+
+        unsigned char *pixels = buffers->out + headerLength;
+        if (!decompress40_mem(in, length, &pixels, stride)) {
+                *message = "compressed image is truncated";
+                return STATUS_ERROR;
+        }
+        stageReport(stderr, width, height);
+
+        *outLength = headerLength + stride * height;
+        return STATUS_OK;
+}
+
+/******** parsePPMHeader ********
+ *
+ * Parses the header of a raw PPM file held in memory.
+ *
+ * Parameters:
+ *      const unsigned char *bytes:     The file
+ *      size_t length:                  Bytes available
+ *      unsigned *width, *height:       Where to store the dimensions
+ *      unsigned *denominator:          Where to store the maximum sample
+ * Returns:
+ *      The length of the header, or 0 if it is not a valid P6 header.
+ * Notes:
+ *      Skips whitespace and '#' comments between fields, as netpbm does.
+ *      Plain (P3) files are not accepted.
+ ************************/
+static size_t parsePPMHeader(const unsigned char *bytes, size_t length,
+                             unsigned *width, unsigned *height,
+                             unsigned *denominator)
+{
+        if (length < 2 || bytes[0] != 'P' || bytes[1] != '6') {
+                return 0;
+        }
+
+        size_t pos = 2;
+        if (!parseNumber(bytes, length, &pos, width) ||
+            !parseNumber(bytes, length, &pos, height) ||
+            !parseNumber(bytes, length, &pos, denominator) ||
+            *denominator == 0 || *denominator > 65535) {
+                return 0;
+        }
+
+        /* Exactly one whitespace character ends the header */
+        if (pos >= length || (bytes[pos] != ' ' && bytes[pos] != '\n' &&
+                              bytes[pos] != '\t' && bytes[pos] != '\r')) {
+                return 0;
+        }
+        return pos + 1;
+}
+
+/******** parseNumber ********
+ *
+ * Skips whitespace and comments, then reads a decimal number.
+ *
+ * Parameters:
+ *      const unsigned char *bytes:     The buffer
+ *      size_t length:                  Bytes available
+ *      size_t *pos:                    Where to start; left after the number
+ *      unsigned *value:                Where to store the number
+ * Returns:
+ *      true if a number below 2^31 was read.
+ ************************/
+static bool parseNumber(const unsigned char *bytes, size_t length,
+                        size_t *pos, unsigned *value)
+{
+        size_t i = *pos;
+        for (;;) {
+                if (i >= length) {
+                        return false;
+                }
+                if (bytes[i] == '#') {
+                        while (i < length && bytes[i] != '\n') {
+                                i++;
+                        }
+                } else if (bytes[i] == ' ' || bytes[i] == '\t' ||
+                           bytes[i] == '\n' || bytes[i] == '\r') {
+                        i++;
+                } else {
+                        break;
+                }
+        }
+
+        if (bytes[i] < '0' || bytes[i] > '9') {
+                return false;
+        }
+        uint64_t number = 0;
+        while (i < length && bytes[i] >= '0' && bytes[i] <= '9') {
+                number = number * 10 + (bytes[i] - '0');
+                if (number >= ((uint64_t) 1 << 31)) {
+                        return false;
+                }
+                i++;
+        }
+
+        *value = number;
+        *pos = i;
+        return true;
+}
+
+/******** ensureCapacity ********
+ *
+ * Grows a buffer to hold at least 'needed' bytes. Never shrinks it.
+ ************************/
+static void ensureCapacity(unsigned char **buffer, size_t *capacity,
+                           size_t needed)
+{
+        if (needed <= *capacity && *buffer != NULL) {
+                return;
+        }
+        size_t size = *capacity * 2 > needed ? *capacity * 2 : needed;
+        *buffer = realloc(*buffer, size + 1);
+        assert(*buffer != NULL);
+        *capacity = size;
+}
+
+/******** readAll ********
+ *
+ * Reads a descriptor to end of file into a growable buffer.
+ *
+ * Parameters:
+ *      int fd:                 The descriptor to read
+ *      unsigned char **buffer: The buffer, grown as needed
+ *      size_t *capacity:       Its capacity
+ *      size_t *length:         Where to store the number of bytes read
+ * Returns:
+ *      true on success, false on a read error or more than MAX_PAYLOAD
+ *      bytes.
+ ************************/
+static bool readAll(int fd, unsigned char **buffer, size_t *capacity,
+                    size_t *length)
+{
+        size_t total = 0;
+        for (;;) {
+                ensureCapacity(buffer, capacity, total + COPY_CHUNK);
+                ssize_t got = read(fd, *buffer + total, COPY_CHUNK);
+                if (got < 0 && errno == EINTR) {
+                        continue;
+                }
+                if (got < 0) {
+                        return false;
+                }
+                if (got == 0) {
+                        break;
+                }
+                total += got;
+                if (total > MAX_PAYLOAD) {
+                        return false;
+                }
+        }
+        *length = total;
+        return true;
+}
+
+/******** readFully ********
+ *
+ * Reads exactly 'length' bytes from a descriptor.
+ *
+ * Returns:
+ *      true on success, false on end of file or an error.
+ ************************/
+static bool readFully(int fd, void *buffer, size_t length)
+{
+        unsigned char *bytes = buffer;
+        while (length > 0) {
+                ssize_t got = read(fd, bytes, length);
+                if (got < 0 && errno == EINTR) {
+                        continue;
+                }
+                if (got <= 0) {
+                        return false;
+                }
+                bytes += got;
+                length -= got;
+        }
+        return true;
+}
+
+/******** writeFully ********
+ *
+ * Writes exactly 'length' bytes to a descriptor.
+ *
+ * Returns:
+ *      true on success, false on an error.
+ ************************/
+static bool writeFully(int fd, const void *buffer, size_t length)
+{
+        const unsigned char *bytes = buffer;
+        while (length > 0) {
+                ssize_t put = write(fd, bytes, length);
+                if (put < 0 && errno == EINTR) {
+                        continue;
+                }
+                if (put <= 0) {
+                        return false;
+                }
+                bytes += put;
+                length -= put;
+        }
+        return true;
+}
+
+/******** receiveHeader ********
+ *
+ * Receives a message header, along with any descriptors sent with it.
+ *
+ * Parameters:
+ *      int fd:                         The connected socket
+ *      struct messageHeader *header:   Where to store the header
+ *      int *fds:                       Room for two received descriptors
+ *      int *numFds:                    Where to store how many arrived
+ * Returns:
+ *      1 on success, 0 if the peer closed the connection first, -1 on an
+ *      error or a partial header.
+ ************************/
+static ssize_t receiveHeader(int fd, struct messageHeader *header,
+                             int *fds, int *numFds)
+{
+        union {
+                struct cmsghdr align;
+                char bytes[CMSG_SPACE(2 * sizeof(int))];
+        } control;
+        struct iovec iov = { header, sizeof(*header) };
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+        msg.msg_control = control.bytes;
+        msg.msg_controllen = sizeof(control.bytes);
+
+        ssize_t got;
+        do {
+                got = recvmsg(fd, &msg, 0);
+        } while (got < 0 && errno == EINTR);
+        if (got <= 0) {
+                return got;
+        }
+
+        *numFds = 0;
+        for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL;
+             cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+                if (cmsg->cmsg_level != SOL_SOCKET ||
+                    cmsg->cmsg_type != SCM_RIGHTS) {
+                        continue;
+                }
+                int count = (cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+                for (int i = 0; i < count; i++) {
+                        int received;
+                        memcpy(&received, CMSG_DATA(cmsg) + i * sizeof(int),
+                               sizeof(int));
+                        if (*numFds < 2) {
+                                fds[(*numFds)++] = received;
+                        } else {
+                                close(received);
+                        }
+                }
+        }
+
+        /* The descriptors come with the first byte; the rest may follow */
+        if ((size_t) got < sizeof(*header) &&
+            !readFully(fd, (unsigned char *) header + got,
+                       sizeof(*header) - got)) {
+                return -1;
+        }
+        return 1;
+}
+
+/******** sendHeader ********
+ *
+ * Sends a message header, optionally with descriptors attached.
+ *
+ * Parameters:
+ *      int fd:                         The connected socket
+ *      struct messageHeader *header:   The header to send
+ *      int *fds:                       Descriptors to pass, or NULL
+ *      int numFds:                     How many (at most 2)
+ * Returns:
+ *      true on success.
+ ************************/
+static bool sendHeader(int fd, struct messageHeader *header, int *fds,
+                       int numFds)
+{
+        union {
+                struct cmsghdr align;
+                char bytes[CMSG_SPACE(2 * sizeof(int))];
+        } control;
+        struct iovec iov = { header, sizeof(*header) };
+        struct msghdr msg;
+        memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = &iov;
+        msg.msg_iovlen = 1;
+
+        if (numFds > 0) {
+                assert(numFds <= 2);
+                memset(&control, 0, sizeof(control));
+                msg.msg_control = control.bytes;
+                msg.msg_controllen = CMSG_SPACE(numFds * sizeof(int));
+                struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+                cmsg->cmsg_level = SOL_SOCKET;
+                cmsg->cmsg_type = SCM_RIGHTS;
+                cmsg->cmsg_len = CMSG_LEN(numFds * sizeof(int));
+                memcpy(CMSG_DATA(cmsg), fds, numFds * sizeof(int));
+        }
+
+        ssize_t sent;
+        do {
+                sent = sendmsg(fd, &msg, 0);
+        } while (sent < 0 && errno == EINTR);
+        if (sent <= 0) {
+                return false;
+        }
+        return (size_t) sent == sizeof(*header) ||
+               writeFully(fd, (unsigned char *) header + sent,
+                          sizeof(*header) - sent);
+}
+
+/******** openSocket ********
+ *
+ * Creates a Unix stream socket and fills in the address for socketPath.
+ *
+ * Returns:
+ *      The socket, or -1 (after printing why) on failure.
+ ************************/
+static int openSocket(const char *socketPath, struct sockaddr_un *address)
+{
+        memset(address, 0, sizeof(*address));
+        address->sun_family = AF_UNIX;
+        if (strlen(socketPath) >= sizeof(address->sun_path)) {
+                fprintf(stderr, "40image: %s: socket path too long\n",
+                        socketPath);
+                return -1;
+        }
+        strcpy(address->sun_path, socketPath);
+
+        int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) {
+                fprintf(stderr, "40image: socket: %s\n", strerror(errno));
+        }
+        return fd;
+}
+
+/******** client40 ********
+ *
+ * Sends one compress or decompress request to a running server and writes
+ * the result to stdout.
+ *
+ * Parameters:
+ *      const char *socketPath: The server's socket
+ *      bool decompress:        -d rather than -c
+ *      FILE *input:            The image to send
+ *      bool passFds:           Pass input and stdout as descriptors instead
+ *                                of sending the bytes
+ * Returns:
+ *      EXIT_SUCCESS, or EXIT_FAILURE after printing why.
+ * Expects:
+ *      socketPath and input are not NULL.
+ ************************/
+int client40(const char *socketPath, bool decompress, FILE *input,
+             bool passFds)
+{
+        assert(socketPath != NULL);
+        assert(input != NULL);
+
+        struct sockaddr_un address;
+        int fd = openSocket(socketPath, &address);
+        if (fd < 0) {
+                return EXIT_FAILURE;
+        }
+        if (connect(fd, (struct sockaddr *) &address, sizeof(address)) != 0) {
+                fprintf(stderr, "40image: %s: %s\n", socketPath,
+                        strerror(errno));
+                close(fd);
+                return EXIT_FAILURE;
+        }
+
+        struct messageHeader request = { PROTOCOL_MAGIC,
+                                         decompress ? OP_DECOMPRESS :
+                                                      OP_COMPRESS, 0 };
+        unsigned char *buffer = NULL;
+        size_t capacity = 0;
+        bool sent;
+        if (passFds) {
+                request.op |= OP_PASS_FDS;
+                fflush(stdout);
+                int fds[2] = { fileno(input), STDOUT_FILENO };
+                sent = sendHeader(fd, &request, fds, 2);
+        } else {
+                size_t length = 0;
+                if (!readAll(fileno(input), &buffer, &capacity, &length)) {
+                        fprintf(stderr, "40image: could not read input\n");
+                        free(buffer);
+                        close(fd);
+                        return EXIT_FAILURE;
+                }
+                request.length = length;
+                sent = sendHeader(fd, &request, NULL, 0) &&
+                       writeFully(fd, buffer, length);
+        }
+
+        struct messageHeader reply;
+        if (!sent || !readFully(fd, &reply, sizeof(reply)) ||
+            reply.magic != PROTOCOL_MAGIC || reply.length > MAX_PAYLOAD) {
+                fprintf(stderr, "40image: %s: no reply from server\n",
+                        socketPath);
+                free(buffer);
+                close(fd);
+                return EXIT_FAILURE;
+        }
+
+        ensureCapacity(&buffer, &capacity, reply.length);
+        bool received = readFully(fd, buffer, reply.length);
+        close(fd);
+
+        int status = EXIT_SUCCESS;
+        if (!received) {
+                fprintf(stderr, "40image: %s: reply cut short\n", socketPath);
+                status = EXIT_FAILURE;
+        } else if (reply.op != STATUS_OK) {
+                fprintf(stderr, "40image: server: %.*s\n", (int) reply.length,
+                        (char *) buffer);
+                status = EXIT_FAILURE;
+        } else {
+                fwrite(buffer, 1, reply.length, stdout);
+                fflush(stdout);
+        }
+        free(buffer);
+        return status;
+}
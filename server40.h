@@ -0,0 +1,23 @@
+/*
+ *      server40.h
+ *      Kevin Lu (klu07), Justin Paik (jpaik03)
+ *      October 18, 2026
+ *      arith
+ *
+ *      Interface for server mode. serve40 keeps the pipeline resident behind
+ *      a Unix domain socket and runs compress and decompress requests on a
+ *      persistent pool of worker threads, so a caller pays neither process
+ *      startup nor dynamic linking per image. client40 sends one request to
+ *      such a server, giving the same output 40image -c or -d would.
+ *
+ *      A request carries its input inline, or passes an input and an output
+ *      file descriptor over the socket (SCM_RIGHTS) so that no image bytes
+ *      go through the socket at all.
+ */
+
+#include <stdio.h>
+#include <stdbool.h>
+
+int serve40(const char *socketPath, int numWorkers);
+int client40(const char *socketPath, bool decompress, FILE *input,
+             bool passFds);
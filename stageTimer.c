@@ -0,0 +1,190 @@
+/*
+ *      stageTimer.c
+ *      Kevin Lu (klu07), Justin Paik (jpaik03)
+ *      October 18, 2026
+ *      arith
+ * 
+ *      Implementation of per-stage timing. Stages are recorded per thread,
+ *      so concurrent jobs keep separate reports. Every stage is also a span
+ *      in the trace file when tracing is on. When both are disabled,
+ *      stageBegin and stageEnd return immediately.
+ */
+
+#include <stdlib.h>
+#include <assert.h>
+#include <time.h>
+
+#include "stageTimer.h"
+#include "trace.h"
+#include "perfCounters.h"
+
+#define MAX_STAGES 16
+
+/******** stageRecord struct ********
+ *
+ * The timing of one completed (or in-progress) pipeline stage.
+ *
+ * Fields:
+ *      const char *name:       Label printed in the report
+ *      double wallStart:       Monotonic time when the stage began
+ *      double cpuStart:        Thread CPU time when the stage began
+ *      double wall, cpu:       Elapsed times once the stage has ended
+ *      struct perfReading perf: Hardware counts, if perf counters are on
+ ************************/
+struct stageRecord
+{
+        const char *name;
+        double wallStart, cpuStart;
+        double wall, cpu;
+        struct perfReading perf;
+};
+
+/* Initialize helper functions, see function contracts below */
+static double readClock(clockid_t clock);
+
+static bool enabled = false;
+
+/* Stages of the job running on this thread */
+static __thread struct stageRecord stages[MAX_STAGES];
+static __thread int numStages = 0;
+
+/******** timingsEnable ********
+ *
+ * Turns on stage timing for every subsequent job in this process.
+ ************************/
+void timingsEnable(void)
+{
+        enabled = true;
+}
+
+/******** timingsEnabled ********
+ *
+ * Returns true if stage timing is turned on.
+ ************************/
+bool timingsEnabled(void)
+{
+        return enabled;
+}
+
+/******** stageBegin ********
+ *
+ * Starts timing a stage of the current job.
+ *
+ * Parameters:
+ *      const char *name:       Label for the stage, e.g. "C1 readImage"
+ * Returns:
+ *      Nothing.
+ * Expects:
+ *      name is not NULL and outlives the report.
+ * Notes:
+ *      Opens a "stage" span if tracing is on.
+ *      Does nothing else if timings are disabled or MAX_STAGES is reached.
+ ************************/
+void stageBegin(const char *name)
+{
+        traceBegin(name, "stage");
+        if (!enabled || numStages == MAX_STAGES) {
+                return;
+        }
+        assert(name != NULL);
+
+        struct stageRecord *stage = &stages[numStages];
+        stage->name = name;
+        stage->wall = stage->cpu = -1;
+        stage->cpuStart = readClock(CLOCK_THREAD_CPUTIME_ID);
+        stage->wallStart = readClock(CLOCK_MONOTONIC);
+        perfCountersStart();
+}
+
+/******** stageEnd ********
+ *
+ * Stops timing the stage most recently begun on this thread.
+ *
+ * Parameters:
+ *      None.
+ * Returns:
+ *      Nothing.
+ * Expects:
+ *      Called once after each stageBegin.
+ ************************/
+void stageEnd(void)
+{
+        traceEnd();
+        if (!enabled || numStages == MAX_STAGES) {
+                return;
+        }
+
+        struct stageRecord *stage = &stages[numStages];
+        perfCountersStop(&stage->perf);
+        stage->wall = readClock(CLOCK_MONOTONIC) - stage->wallStart;
+        stage->cpu = readClock(CLOCK_THREAD_CPUTIME_ID) - stage->cpuStart;
+        numStages++;
+}
+
+/******** stageReport ********
+ *
+ * Prints the current job's stage timings, its image size, and its overall
+ * pixel rate, then clears the recorded stages for the next job. With perf
+ * counters on, also prints each stage's IPC and misses per pixel.
+ *
+ * Parameters:
+ *      FILE *out:              Where to print the report (normally stderr)
+ *      unsigned width:         Width of the job's image in pixels
+ *      unsigned height:        Height of the job's image in pixels
+ * Returns:
+ *      Nothing.
+ * Expects:
+ *      out is not NULL.
+ * Notes:
+ *      Does nothing if timings are disabled.
+ *      Holds the stream's lock for the whole report, so reports from
+ *        concurrent batch jobs do not interleave.
+ ************************/
+void stageReport(FILE *out, unsigned width, unsigned height)
+{
+        if (!enabled) {
+                return;
+        }
+        assert(out != NULL);
+
+        double pixels = (double) width * height;
+        double totalWall = 0, totalCPU = 0;
+
+        flockfile(out);
+        fprintf(out, "timings: %ux%u image (%.0f pixels)\n", width, height,
+                pixels);
+        fprintf(out, "  %-28s %12s %12s\n", "stage", "wall ms", "cpu ms");
+        for (int i = 0; i < numStages; i++) {
+                fprintf(out, "  %-28s %12.3f %12.3f\n", stages[i].name,
+                        stages[i].wall * 1e3, stages[i].cpu * 1e3);
+                totalWall += stages[i].wall;
+                totalCPU += stages[i].cpu;
+        }
+        fprintf(out, "  %-28s %12.3f %12.3f\n", "total", totalWall * 1e3,
+                totalCPU * 1e3);
+        if (totalWall > 0) {
+                fprintf(out, "  %.0f pixels/second\n", pixels / totalWall);
+        }
+
+        if (perfCountersEnabled() && pixels > 0) {
+                perfCountersPrintHeader(out);
+                for (int i = 0; i < numStages; i++) {
+                        perfCountersPrint(out, stages[i].name, 
+                                          &stages[i].perf, pixels);
+                }
+        }
+        funlockfile(out);
+
+        numStages = 0;
+}
+
+/******** readClock ********
+ *
+ * Returns the current reading of the given clock in seconds.
+ ************************/
+static double readClock(clockid_t clock)
+{
+        struct timespec ts;
+        clock_gettime(clock, &ts);
+        return ts.tv_sec + ts.tv_nsec / 1e9;
+}
@@ -0,0 +1,21 @@
+/*
+ *      stageTimer.h
+ *      Kevin Lu (klu07), Justin Paik (jpaik03)
+ *      October 18, 2026
+ *      arith
+ * 
+ *      Interface for optional per-stage timing of the compression and
+ *      decompression pipelines. When enabled, each step marked with
+ *      stageBegin/stageEnd records its monotonic wall time and CPU time, and
+ *      stageReport prints them once the job finishes.
+ */
+
+#include <stdio.h>
+#include <stdbool.h>
+
+void timingsEnable(void);
+bool timingsEnabled(void);
+
+void stageBegin(const char *name);
+void stageEnd(void);
+void stageReport(FILE *out, unsigned width, unsigned height);
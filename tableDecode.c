@@ -0,0 +1,476 @@
+/*
+ *      tableDecode.c
+ *      Kevin Lu (klu07), Justin Paik (jpaik03)
+ *      October 18, 2026
+ *      arith
+ * 
+ *      Implementation of the table-driven decoder. A decoded block's chroma
+ *      depends only on its 8-bit (indexbpb, indexbpr) pair, so the inverse
+ *      color transform's chroma terms are computed once for all 256 pairs.
+ *      Each pixel is then its luma (from the inverse DCT) plus a table row,
+ *      followed by a clamp and a round. This replaces the dequantizeValues,
+ *      DCTBlockToPixels, and getRGBInts chain in the (C3)' and (C2)' steps.
+ */
+
+#include <stdlib.h>
+#include <assert.h>
+#include <math.h>
+#include <pthread.h>
+
+#include "tableDecode.h"
+#include "blockOperation.h"
+#include "pixelOperation.h"
+#include "arith40.h"
+
+#define BLOCKSIZE 2
+#define NUM_CHROMA_PAIRS 256
+
+/******** chromaTerms struct ********
+ *
+ * The contribution of one (indexbpb, indexbpr) pair to each RGB channel,
+ * i.e. everything in the inverse color transform except the luma term.
+ *
+ * Fields:
+ *      double r, g, b: Amount added to Y to get each channel in [0, 1]
+ ************************/
+struct chromaTerms
+{
+        double r, g, b;
+};
+
+/* Chroma contributions indexed by (indexbpb << 4) | indexbpr */
+static struct chromaTerms chromaTable[NUM_CHROMA_PAIRS];
+static pthread_once_t chromaTableOnce = PTHREAD_ONCE_INIT;
+
+struct tableDecodeClosure;
+
+/* Initialize helper functions, see function contracts below */
+static void buildChromaTable(void);
+static void applyTableDecode(int col, int row, A2Methods_UArray2 quantInts,
+                             void *elem, void *cl);
+static void applyTableDecodeHalf(int col, int row, 
+                                 A2Methods_UArray2 quantInts, void *elem,
+                                 void *cl);
+static void storePixel(struct tableDecodeClosure *closure, int col, int row,
+                       float y, const struct chromaTerms *terms);
+
+/******** tableDecodeClosure struct ********
+ *
+ * A closure passed to the apply function that decodes each block of
+ * quantized values into four RGB pixels. Exactly one of pixmap, buffer and
+ * reference is the destination; the others are NULL.
+ *
+ * Fields:
+ *      Pnm_ppm pixmap:         The destination image being populated
+ *      unsigned char *buffer:  The destination 8-bit RGB buffer
+ *      size_t stride:          Bytes from one buffer row to the next
+ *      Pnm_ppm reference:      An image to compare each pixel against
+ *                                instead of storing it
+ *      double squares:         Sum of squared differences from reference,
+ *                                with samples scaled to [0, 1]
+ *      const struct quantScales *scales:       The scales the blocks were
+ *                                                quantized with
+ ************************/
+struct tableDecodeClosure
+{
+        Pnm_ppm pixmap;
+        unsigned char *buffer;
+        size_t stride;
+        Pnm_ppm reference;
+        double squares;
+        const struct quantScales *scales;
+};
+
+/******** tableDecodeInit ********
+ *
+ * Builds the chroma table now rather than on the first decode, so that a
+ * long-running process pays for it before any job arrives.
+ *
+ * Parameters:
+ *      None.
+ * Returns:
+ *      Nothing.
+ * Notes:
+ *      Safe to call any number of times, from any thread.
+ ************************/
+void tableDecodeInit(void)
+{
+        pthread_once(&chromaTableOnce, buildChromaTable);
+}
+
+/******** tableDecode ********
+ *
+ * Converts an array of quantized block values into a new Pnm_ppm image with
+ * scaled integer RGB pixels, without building any intermediate arrays.
+ *
+ * Parameters:
+ *      UArray2_T quantInts:    An array where each element is a quantized
+ *                                struct
+ *      A2Methods_T methods:    The plain method suite for quantInts, also
+ *                                used for the returned image's pixels
+ *      const struct quantScales *scales:       The scales quantInts was
+ *                                                quantized with
+ * Returns:
+ *      A Pnm_ppm struct pointer to the newly created image.
+ * Expects:
+ *      quantInts, methods and scales are not NULL.
+ * Notes:
+ *      Throws a CRE if quantInts, methods or scales is NULL.
+ *      Throws a CRE if memory allocation fails.
+ *      Builds the chroma table on first use.
+ *      Allocates memory for a new Pnm_ppm struct and its pixel array,
+ *        which the caller is responsible for freeing.
+ ************************/
+Pnm_ppm tableDecode(UArray2_T quantInts, A2Methods_T methods,
+                    const struct quantScales *scales)
+{
+        assert(quantInts != NULL);
+        assert(methods != NULL);
+        assert(validScales(scales));
+        assert(methods->new != NULL);
+
+        A2Methods_mapfun *map = methods->map_default;
+        assert(map != NULL);
+
+        pthread_once(&chromaTableOnce, buildChromaTable);
+
+        /* Create the destination Pnm_ppm struct */
+        Pnm_ppm pixmap = malloc(sizeof(*pixmap));
+        assert(pixmap != NULL);
+
+        pixmap->width = methods->width(quantInts) * BLOCKSIZE;
+        pixmap->height = methods->height(quantInts) * BLOCKSIZE;
+        pixmap->denominator = DENOMINATOR;
+        pixmap->methods = methods;
+        pixmap->pixels = methods->new(pixmap->width, pixmap->height,
+                                      sizeof(struct Pnm_rgb));
+        assert(pixmap->pixels != NULL);
+
+        struct tableDecodeClosure closure = { pixmap, NULL, 0, NULL, 0,
+                                               scales };
+
+        /* Map over the blocks, writing four pixels per block */
+        map(quantInts, applyTableDecode, &closure);
+
+        return pixmap;
+}
+
+/******** tableDecodeHalf ********
+ *
+ * Converts an array of quantized block values into a half-resolution image
+ * with one pixel per block, using only each block's a, indexbpb and indexbpr.
+ *
+ * Parameters:
+ *      UArray2_T quantInts:    An array where each element is a quantized
+ *                                struct
+ *      A2Methods_T methods:    The plain method suite for quantInts, also
+ *                                used for the returned image's pixels
+ *      const struct quantScales *scales:       The scales quantInts was
+ *                                                quantized with
+ * Returns:
+ *      A Pnm_ppm struct pointer to the newly created image, with the same
+ *      dimensions as quantInts.
+ * Expects:
+ *      quantInts, methods and scales are not NULL.
+ * Notes:
+ *      Throws a CRE if quantInts, methods or scales is NULL.
+ *      Throws a CRE if memory allocation fails.
+ *      b, c and d average out over a block, so each pixel is the mean of
+ *        the block's four full-resolution pixels before clamping.
+ *      Allocates memory for a new Pnm_ppm struct and its pixel array,
+ *        which the caller is responsible for freeing.
+ ************************/
+Pnm_ppm tableDecodeHalf(UArray2_T quantInts, A2Methods_T methods,
+                        const struct quantScales *scales)
+{
+        assert(quantInts != NULL);
+        assert(methods != NULL);
+        assert(validScales(scales));
+        assert(methods->new != NULL);
+
+        A2Methods_mapfun *map = methods->map_default;
+        assert(map != NULL);
+
+        pthread_once(&chromaTableOnce, buildChromaTable);
+
+        Pnm_ppm pixmap = malloc(sizeof(*pixmap));
+        assert(pixmap != NULL);
+
+        pixmap->width = methods->width(quantInts);
+        pixmap->height = methods->height(quantInts);
+        pixmap->denominator = DENOMINATOR;
+        pixmap->methods = methods;
+        pixmap->pixels = methods->new(pixmap->width, pixmap->height,
+                                      sizeof(struct Pnm_rgb));
+        assert(pixmap->pixels != NULL);
+
+        struct tableDecodeClosure closure = { pixmap, NULL, 0, NULL, 0,
+                                               scales };
+        map(quantInts, applyTableDecodeHalf, &closure);
+
+        return pixmap;
+}
+
+/******** tableDecodeToBuffer ********
+ *
+ * Decodes an array of quantized block values into a caller-owned buffer of
+ * 8-bit RGB samples (denominator 255), laid out like a raw PPM raster.
+ *
+ * Parameters:
+ *      UArray2_T quantInts:    An array where each element is a quantized
+ *                                struct
+ *      A2Methods_T methods:    The method suite for quantInts
+ *      const struct quantScales *scales:       The scales quantInts was
+ *                                                quantized with
+ *      unsigned char *pixels:  The first byte of the first destination row
+ *      size_t stride:          Bytes from one destination row to the next
+ * Returns:
+ *      Nothing.
+ * Expects:
+ *      All pointers are not NULL.
+ *      pixels holds 2 * height rows of at least 6 * width bytes, where width
+ *        and height are the dimensions of quantInts.
+ * Notes:
+ *      Throws a CRE if a pointer is NULL.
+ *      Builds the chroma table on first use.
+ ************************/
+void tableDecodeToBuffer(UArray2_T quantInts, A2Methods_T methods,
+                         const struct quantScales *scales,
+                         unsigned char *pixels, size_t stride)
+{
+        assert(quantInts != NULL);
+        assert(methods != NULL);
+        assert(validScales(scales));
+        assert(pixels != NULL);
+
+        A2Methods_mapfun *map = methods->map_default;
+        assert(map != NULL);
+
+        pthread_once(&chromaTableOnce, buildChromaTable);
+
+        struct tableDecodeClosure closure = { NULL, pixels, stride, NULL,
+                                               0, scales };
+        map(quantInts, applyTableDecode, &closure);
+}
+
+/******** tableDecodeError ********
+ *
+ * Decodes an array of quantized block values and measures it against the
+ * image it was compressed from, without storing the decoded pixels.
+ *
+ * Parameters:
+ *      UArray2_T quantInts:    An array where each element is a quantized
+ *                                struct
+ *      A2Methods_T methods:    The method suite for quantInts
+ *      const struct quantScales *scales:       The scales quantInts was
+ *                                                quantized with
+ *      Pnm_ppm original:       The (trimmed) image quantInts came from
+ * Returns:
+ *      The root mean square difference between the decoded and original
+ *      images, over all three channels scaled to [0, 1] (as ppmdiff
+ *      reports it), or 0 for an empty image.
+ * Expects:
+ *      All arguments are not NULL, and original is twice the size of
+ *      quantInts in each dimension.
+ * Notes:
+ *      Throws a CRE if an argument is NULL or the sizes do not match.
+ *      Each decoded pixel is compared as soon as it is computed, in the
+ *        same block loop as tableDecode, so the result is exactly what
+ *        ppmdiff reports for a full compress and decompress.
+ ************************/
+double tableDecodeError(UArray2_T quantInts, A2Methods_T methods,
+                        const struct quantScales *scales, Pnm_ppm original)
+{
+        assert(quantInts != NULL);
+        assert(methods != NULL);
+        assert(validScales(scales));
+        assert(original != NULL);
+        assert(original->width == 
+               (unsigned) methods->width(quantInts) * BLOCKSIZE);
+        assert(original->height == 
+               (unsigned) methods->height(quantInts) * BLOCKSIZE);
+
+        A2Methods_mapfun *map = methods->map_default;
+        assert(map != NULL);
+
+        pthread_once(&chromaTableOnce, buildChromaTable);
+
+        struct tableDecodeClosure closure = { NULL, NULL, 0, original, 0,
+                                               scales };
+        map(quantInts, applyTableDecode, &closure);
+
+        double samples = 3.0 * original->width * original->height;
+        return samples == 0 ? 0.0 : sqrt(closure.squares / samples);
+}
+
+/******** buildChromaTable ********
+ *
+ * Fills chromaTable with the chroma part of the inverse color transform for
+ * every possible pair of 4-bit chroma indices.
+ *
+ * Parameters:
+ *      None.
+ * Returns:
+ *      Nothing.
+ * Expects:
+ *      Nothing.
+ * Notes:
+ *      Uses the same coefficients as applyCompVidToPixel in pixelOperation.
+ *      Runs exactly once through pthread_once, so concurrent decoders share
+ *        the table.
+ ************************/
+static void buildChromaTable(void)
+{
+        for (unsigned pair = 0; pair < NUM_CHROMA_PAIRS; pair++) {
+                float pb = Arith40_chroma_of_index(pair >> 4);
+                float pr = Arith40_chroma_of_index(pair & 0xF);
+
+                chromaTable[pair].r = 1.402 * pr;
+                chromaTable[pair].g = -0.344136 * pb - 0.714136 * pr;
+                chromaTable[pair].b = 1.772 * pb;
+        }
+}
+
+/******** applyTableDecode ********
+ *
+ * Apply function for tableDecode. Dequantizes one block's luma coefficients,
+ * applies the inverse DCT, and writes the block's four pixels using the
+ * block's row of the chroma table.
+ *
+ * Parameters:
+ *      int col:                        Column index of the current block
+ *      int row:                        Row index of the current block
+ *      A2Methods_UArray2 quantInts:    The array being mapped over (unused)
+ *      void *elem:                     Pointer to the current quantized struct
+ *      void *cl:                       Pointer to the tableDecodeClosure
+ * Returns:
+ *      Nothing.
+ * Expects:
+ *      elem and cl are not NULL.
+ * Notes:
+ *      Modifies the four pixels of block (col, row) in the closure's
+ *        destination.
+ ************************/
+static void applyTableDecode(int col, int row, A2Methods_UArray2 quantInts,
+                             void *elem, void *cl)
+{
+        (void) quantInts;
+        assert(elem != NULL);
+        assert(cl != NULL);
+
+        struct tableDecodeClosure *closure = cl;
+        struct quantized *srcQuant = elem;
+
+        /* Dequantize the luma coefficients as dequantizeValues does */
+        const struct quantScales *scales = closure->scales;
+        float a = keepInRange(srcQuant->a / (double) scales->a, 0, 1);
+        float b = srcQuant->b / (double) scales->bcd;
+        float c = srcQuant->c / (double) scales->bcd;
+        float d = srcQuant->d / (double) scales->bcd;
+
+        /* One table lookup covers the chroma of all four pixels */
+        const struct chromaTerms *terms = 
+                &chromaTable[(srcQuant->indexbpb << 4) | srcQuant->indexbpr];
+
+        int pixCol = col * BLOCKSIZE;
+        int pixRow = row * BLOCKSIZE;
+
+        /* Inverse DCT for each pixel position within the 2x2 block */
+        storePixel(closure, pixCol, pixRow, a - b - c + d, terms);
+        storePixel(closure, pixCol + 1, pixRow, a - b + c - d, terms);
+        storePixel(closure, pixCol, pixRow + 1, a + b - c - d, terms);
+        storePixel(closure, pixCol + 1, pixRow + 1, a + b + c + d, terms);
+}
+
+/******** applyTableDecodeHalf ********
+ *
+ * Apply function for tableDecodeHalf. Writes block (col, row)'s average
+ * color, its dequantized a plus its row of the chroma table, to pixel
+ * (col, row).
+ *
+ * Parameters:
+ *      int col:                        Column index of the current block
+ *      int row:                        Row index of the current block
+ *      A2Methods_UArray2 quantInts:    The array being mapped over (unused)
+ *      void *elem:                     Pointer to the current quantized struct
+ *      void *cl:                       Pointer to the tableDecodeClosure
+ * Returns:
+ *      Nothing.
+ * Expects:
+ *      elem and cl are not NULL.
+ ************************/
+static void applyTableDecodeHalf(int col, int row, 
+                                 A2Methods_UArray2 quantInts, void *elem,
+                                 void *cl)
+{
+        (void) quantInts;
+        assert(elem != NULL);
+        assert(cl != NULL);
+
+        struct tableDecodeClosure *closure = cl;
+        struct quantized *srcQuant = elem;
+        float a = keepInRange(srcQuant->a / (double) closure->scales->a, 0,
+                              1);
+        const struct chromaTerms *terms = 
+                &chromaTable[(srcQuant->indexbpb << 4) | srcQuant->indexbpr];
+
+        storePixel(closure, col, row, a, terms);
+}
+
+/******** storePixel ********
+ *
+ * Combines a pixel's luma with its block's chroma terms, clamps each channel
+ * to [0.0, 1.0], and stores the scaled integer result in the closure's
+ * destination, or compares it with the closure's reference image.
+ *
+ * Parameters:
+ *      struct tableDecodeClosure *closure:     Holds the destination
+ *      int col, row:                           The pixel's position
+ *      float y:                                The pixel's luma
+ *      const struct chromaTerms *terms:        The block's chroma terms
+ * Returns:
+ *      Nothing.
+ * Expects:
+ *      closure and terms are not NULL.
+ * Notes:
+ *      Modifies the pixel at (col, row) of the destination.
+ ************************/
+static void storePixel(struct tableDecodeClosure *closure, int col, int row,
+                       float y, const struct chromaTerms *terms)
+{
+        assert(closure != NULL);
+        assert(terms != NULL);
+
+        float r = keepInRange(y + terms->r, 0.0, 1.0);
+        float g = keepInRange(y + terms->g, 0.0, 1.0);
+        float b = keepInRange(y + terms->b, 0.0, 1.0);
+
+        unsigned red   = (int) round(r * DENOMINATOR);
+        unsigned green = (int) round(g * DENOMINATOR);
+        unsigned blue  = (int) round(b * DENOMINATOR);
+
+        if (closure->reference != NULL) {
+                Pnm_ppm reference = closure->reference;
+                Pnm_rgb refPixel = reference->methods->at(reference->pixels,
+                                                          col, row);
+                double scale = 1.0 / reference->denominator;
+                double dr = red / (double) DENOMINATOR - 
+                            refPixel->red * scale;
+                double dg = green / (double) DENOMINATOR - 
+                            refPixel->green * scale;
+                double db = blue / (double) DENOMINATOR - 
+                            refPixel->blue * scale;
+                closure->squares += dr * dr + dg * dg + db * db;
+        } else if (closure->pixmap != NULL) {
+                Pnm_ppm pixmap = closure->pixmap;
+                Pnm_rgb destPixel = pixmap->methods->at(pixmap->pixels, 
+                                                        col, row);
+                *destPixel = (struct Pnm_rgb){ red, green, blue };
+        } else {
+                unsigned char *dest = closure->buffer + row * closure->stride
+                                      + (size_t) col * 3;
+                dest[0] = red;
+                dest[1] = green;
+                dest[2] = blue;
+        }
+}
@@ -0,0 +1,31 @@
+/*
+ *      tableDecode.h
+ *      Kevin Lu (klu07), Justin Paik (jpaik03)
+ *      October 18, 2026
+ *      arith
+ * 
+ *      Interface for the table-driven decoder. This module fuses the (C3)'
+ *      and (C2)' steps, turning quantized codeword fields directly into
+ *      integer RGB pixels using a precomputed table of chroma contributions.
+ */
+
+#include "pnm.h"
+#include "a2methods.h"
+#include "uarray2.h"
+
+/* Defined in blockOperation.h */
+struct quantScales;
+
+/* Decompression */
+void tableDecodeInit(void);
+Pnm_ppm tableDecode(UArray2_T quantInts, A2Methods_T methods,
+                    const struct quantScales *scales);
+Pnm_ppm tableDecodeHalf(UArray2_T quantInts, A2Methods_T methods,
+                        const struct quantScales *scales);
+void tableDecodeToBuffer(UArray2_T quantInts, A2Methods_T methods,
+                         const struct quantScales *scales,
+                         unsigned char *pixels, size_t stride);
+
+/* Quality measurement: RMS difference of the decoded image from original */
+double tableDecodeError(UArray2_T quantInts, A2Methods_T methods,
+                        const struct quantScales *scales, Pnm_ppm original);
@@ -0,0 +1,776 @@
+/*
+ *      test40.c
+ *      Kevin Lu (klu07), Justin Paik (jpaik03)
+ *      October 18, 2026
+ *      arith
+ *
+ *      Tests for the compression pipeline. Compresses a synthetic image to
+ *      each format and decodes it again, and checks that truncated input is
+ *      refused by the in-memory decompressor and by the format 7 reader,
+ *      that format 4 writes and reads an image with no blocks, that a
+ *      format 5 image cut short can be decoded partially, and that
+ *      the in-memory compressor refuses samples above the denominator,
+ *      a server keeps serving after such a request, and a trace is
+ *      finished at exit with its names escaped.
+ *      Each test prints PASS or FAIL with its name on stdout.
+ *
+ *      Usage: test40 (run by "make test"); exits nonzero if any test fails.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include <assert.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/wait.h>
+
+#include "a2methods.h"
+#include "a2plain.h"
+#include "compress40.h"
+#include "compress40mem.h"
+#include "blockOperation.h"
+#include "blockTransform.h"
+#include "codewords.h"
+#include "tiles.h"
+#include "server40.h"
+#include "transformCoding.h"
+#include "trace.h"
+
+/* A multiple of 8 both ways, so that no format trims the image */
+#define WIDTH 64
+#define HEIGHT 48
+
+/* Largest RMS error (as ppmdiff reports it) a round trip may have */
+#define MAX_RMS 0.05
+
+/******** raster struct ********
+ *
+ * A decoded PPM's dimensions and raw 8-bit samples.
+ *
+ * Fields:
+ *      unsigned width, height: Dimensions of the image
+ *      unsigned char *samples: 3 * width * height samples, row-major
+ ************************/
+struct raster
+{
+        unsigned width, height;
+        unsigned char *samples;
+};
+
+static FILE *makeImage(void);
+static unsigned char *readAll(FILE *input, size_t *length);
+static bool readRaster(FILE *input, struct raster *raster);
+static double rmsError(const struct raster *decoded);
+static bool report(const char *name, bool passed, const char *why);
+static bool testRoundTrip(unsigned format, struct raster *reference);
+static bool testEmptyTiles(void);
+static bool testPartialProgressive(void);
+static bool testMemTruncated(void);
+static bool testMemOutOfRange(void);
+static bool testTransformTruncated(void);
+static bool readsTransform(const unsigned char *bytes, size_t length);
+static bool testServerBadSample(void);
+static bool waitForServer(const char *path);
+static int runClient(const char *path, FILE *input);
+static bool testTraceAtExit(void);
+
+int main(void)
+{
+        int failures = 0;
+
+        /* Format 2's pixels, which formats 3 to 6 must decode to exactly */
+        struct raster reference = { 0, 0, NULL };
+        for (unsigned format = 2; format <= 7; format++) {
+                failures += !testRoundTrip(format, &reference);
+        }
+        free(reference.samples);
+
+        failures += !testEmptyTiles();
+        failures += !testPartialProgressive();
+        failures += !testMemTruncated();
+        failures += !testMemOutOfRange();
+        failures += !testTransformTruncated();
+        failures += !testServerBadSample();
+        failures += !testTraceAtExit();
+
+        printf("%d test%s failed\n", failures, failures == 1 ? "" : "s");
+        return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+/******** makeImage ********
+ *
+ * Writes a deterministic synthetic PPM of WIDTH x HEIGHT pixels (smooth
+ * gradients plus a little noise) to a temporary file.
+ *
+ * Parameters:
+ *      None.
+ * Returns:
+ *      The temporary file, rewound, which the caller must fclose.
+ * Notes:
+ *      Throws a CRE if the file cannot be created.
+ ************************/
+static FILE *makeImage(void)
+{
+        FILE *ppm = tmpfile();
+        assert(ppm != NULL);
+
+        fprintf(ppm, "P6\n%u %u\n255\n", WIDTH, HEIGHT);
+
+        unsigned seed = 40;
+        for (unsigned row = 0; row < HEIGHT; row++) {
+                for (unsigned col = 0; col < WIDTH; col++) {
+                        seed = seed * 1103515245 + 12345;
+                        unsigned noise = (seed >> 16) & 0x7;
+                        putc(col * 200 / WIDTH + noise, ppm);
+                        putc(row * 200 / HEIGHT + noise, ppm);
+                        putc((col + row) * 2 + noise, ppm);
+                }
+        }
+
+        rewind(ppm);
+        return ppm;
+}
+
+/******** readAll ********
+ *
+ * Reads the rest of a stream into memory.
+ *
+ * Parameters:
+ *      FILE *input:    The stream to read
+ *      size_t *length: Where to store the number of bytes read
+ * Returns:
+ *      A malloc'd buffer of *length bytes, which the caller must free.
+ * Notes:
+ *      Throws a CRE if allocation fails.
+ ************************/
+static unsigned char *readAll(FILE *input, size_t *length)
+{
+        size_t capacity = 4096;
+        unsigned char *bytes = malloc(capacity);
+        assert(bytes != NULL);
+
+        *length = 0;
+        size_t got;
+        while ((got = fread(bytes + *length, 1, capacity - *length,
+                            input)) > 0) {
+                *length += got;
+                if (*length == capacity) {
+                        capacity *= 2;
+                        bytes = realloc(bytes, capacity);
+                        assert(bytes != NULL);
+                }
+        }
+        return bytes;
+}
+
+/******** readRaster ********
+ *
+ * Reads a decoded 8-bit P6 PPM.
+ *
+ * Parameters:
+ *      FILE *input:            The PPM, positioned at its start
+ *      struct raster *raster:  Where the image is stored
+ * Returns:
+ *      true with the image in *raster, whose samples the caller must free,
+ *      or false if input is not a whole 8-bit P6 image.
+ ************************/
+static bool readRaster(FILE *input, struct raster *raster)
+{
+        unsigned maxval;
+        if (fscanf(input, "P6 %u %u %u", &raster->width, &raster->height,
+                   &maxval) != 3 || maxval != 255 || getc(input) == EOF) {
+                return false;
+        }
+
+        size_t count = (size_t) 3 * raster->width * raster->height;
+        raster->samples = malloc(count + 1);
+        assert(raster->samples != NULL);
+        if (fread(raster->samples, 1, count, input) != count) {
+                free(raster->samples);
+                raster->samples = NULL;
+                return false;
+        }
+        return true;
+}
+
+/******** rmsError ********
+ *
+ * Returns the RMS difference, on a 0 to 1 scale, between a decoded image
+ * and the one makeImage writes.
+ ************************/
+static double rmsError(const struct raster *decoded)
+{
+        FILE *ppm = makeImage();
+        struct raster original;
+        bool read = readRaster(ppm, &original);
+        fclose(ppm);
+        assert(read);
+
+        size_t count = (size_t) 3 * WIDTH * HEIGHT;
+        double sum = 0;
+        for (size_t k = 0; k < count; k++) {
+                double diff = (original.samples[k] - decoded->samples[k]) /
+                              255.0;
+                sum += diff * diff;
+        }
+        free(original.samples);
+        return sqrt(sum / count);
+}
+
+/******** report ********
+ *
+ * Prints a test's result and returns whether it passed.
+ ************************/
+static bool report(const char *name, bool passed, const char *why)
+{
+        if (passed) {
+                printf("PASS %s\n", name);
+        } else {
+                printf("FAIL %s: %s\n", name, why);
+        }
+        return passed;
+}
+
+/******** testRoundTrip ********
+ *
+ * Compresses the synthetic image to a format, decompresses it, and checks
+ * the dimensions and error of the result.
+ *
+ * Parameters:
+ *      unsigned format:                The format to compress to, 2 to 7
+ *      struct raster *reference:       Format 2's decoded image; filled in
+ *                                        by the format 2 test and compared
+ *                                        against by formats 3 to 6
+ * Returns:
+ *      Whether the test passed.
+ ************************/
+static bool testRoundTrip(unsigned format, struct raster *reference)
+{
+        char name[32];
+        snprintf(name, sizeof(name), "round trip, format %u", format);
+
+        FILE *ppm = makeImage();
+        FILE *compressed = tmpfile();
+        FILE *decoded = tmpfile();
+        assert(compressed != NULL && decoded != NULL);
+
+        compress40_format(ppm, compressed, format);
+        rewind(compressed);
+        decompress40_to(compressed, decoded);
+        rewind(decoded);
+        fclose(compressed);
+        fclose(ppm);
+
+        struct raster result;
+        bool read = readRaster(decoded, &result);
+        fclose(decoded);
+        if (!read) {
+                return report(name, false, "output is not an 8-bit PPM");
+        }
+
+        const char *why = NULL;
+        if (result.width != WIDTH || result.height != HEIGHT) {
+                why = "dimensions changed";
+        } else if (rmsError(&result) > MAX_RMS) {
+                why = "error too large";
+        } else if (format >= 3 && format <= 6 && reference->samples != NULL &&
+                   memcmp(result.samples, reference->samples,
+                          (size_t) 3 * WIDTH * HEIGHT) != 0) {
+                why = "pixels differ from format 2's";
+        }
+
+        if (format == 2 && why == NULL) {
+                *reference = result;
+        } else {
+                free(result.samples);
+        }
+        return report(name, why == NULL, why);
+}
+
+/******** testEmptyTiles ********
+ *
+ * Checks that format 4 writes an image with no blocks (one under 2 pixels
+ * wide or high) as an empty tile index and reads it back.
+ *
+ * Parameters:
+ *      None.
+ * Returns:
+ *      Whether the test passed.
+ ************************/
+static bool testEmptyTiles(void)
+{
+        const char *name = "format 4, empty tile index";
+
+        A2Methods_T methods = uarray2_methods_plain;
+        UArray2_T quantInts = methods->new(0, 0, sizeof(struct quantized));
+        FILE *compressed = tmpfile();
+        assert(compressed != NULL);
+        printWordsTiled(compressed, quantInts, methods, 1, &DEFAULT_SCALES);
+        methods->free((A2Methods_UArray2 *) &quantInts);
+        rewind(compressed);
+
+        unsigned width, height;
+        struct quantScales scales;
+        const char *why = NULL;
+        if (readFormatHeader(compressed, &width, &height, &scales) != 4 ||
+            width != 0 || height != 0) {
+                why = "wrong header";
+        } else {
+                quantInts = readWordsTiled(compressed, methods, width, height,
+                                           1);
+                if (methods->width(quantInts) != 0 ||
+                    methods->height(quantInts) != 0) {
+                        why = "blocks read from an empty index";
+                } else if (getc(compressed) != EOF) {
+                        why = "bytes left after the index";
+                }
+                methods->free((A2Methods_UArray2 *) &quantInts);
+        }
+        fclose(compressed);
+        return report(name, why == NULL, why);
+}
+
+/******** testPartialProgressive ********
+ *
+ * Cuts a format 5 image off halfway through its detail plane and checks
+ * that a partial decode keeps the full size and matches the whole image's
+ * decode on every block row whose detail arrived.
+ *
+ * Parameters:
+ *      None.
+ * Returns:
+ *      Whether the test passed.
+ ************************/
+static bool testPartialProgressive(void)
+{
+        const char *name = "format 5, partial decode";
+
+        FILE *ppm = makeImage();
+        FILE *compressed = tmpfile();
+        assert(compressed != NULL);
+        compress40_format(ppm, compressed, 5);
+        fclose(ppm);
+        rewind(compressed);
+        size_t length;
+        unsigned char *bytes = readAll(compressed, &length);
+
+        /* The whole image's decode, to compare the refined rows against */
+        rewind(compressed);
+        FILE *decoded = tmpfile();
+        assert(decoded != NULL);
+        decompress40_region(compressed, decoded, false, false, NULL);
+        fclose(compressed);
+        rewind(decoded);
+        struct raster whole;
+        bool read = readRaster(decoded, &whole);
+        fclose(decoded);
+        assert(read);
+
+        /* Keep the header, the 17-bit DC plane and half the 15-bit detail
+         * plane, each plane padded to a byte */
+        size_t header = 0;
+        for (int lines = 0; header < length && lines < 2; header++) {
+                lines += bytes[header] == '\n';
+        }
+        size_t blocks = (size_t) (WIDTH / 2) * (HEIGHT / 2);
+        size_t detailBytes = (blocks * 15 + 7) / 8 / 2;
+        size_t kept = header + (blocks * 17 + 7) / 8 + detailBytes;
+        unsigned refinedRows = detailBytes * 8 / 15 / (WIDTH / 2) * 2;
+
+        FILE *cut = tmpfile();
+        decoded = tmpfile();
+        assert(cut != NULL && decoded != NULL);
+        fwrite(bytes, 1, kept, cut);
+        rewind(cut);
+        decompress40_region(cut, decoded, false, true, NULL);
+        fclose(cut);
+        rewind(decoded);
+        struct raster partial;
+        read = readRaster(decoded, &partial);
+        fclose(decoded);
+
+        const char *why = NULL;
+        if (!read) {
+                why = "output is not an 8-bit PPM";
+        } else if (partial.width != WIDTH || partial.height != HEIGHT) {
+                why = "dimensions changed";
+        } else if (refinedRows == 0 ||
+                   memcmp(partial.samples, whole.samples,
+                          (size_t) 3 * WIDTH * refinedRows) != 0) {
+                why = "refined rows differ from the whole image's";
+        } else if (memcmp(partial.samples, whole.samples,
+                          (size_t) 3 * WIDTH * HEIGHT) == 0) {
+                why = "detail that never arrived was decoded";
+        }
+
+        if (read) {
+                free(partial.samples);
+        }
+        free(whole.samples);
+        free(bytes);
+        return report(name, why == NULL, why);
+}
+
+/******** testMemTruncated ********
+ *
+ * Checks that decompress40_mem decodes a whole compressed image and refuses
+ * every shorter prefix of it.
+ *
+ * Parameters:
+ *      None.
+ * Returns:
+ *      Whether the test passed.
+ ************************/
+static bool testMemTruncated(void)
+{
+        const char *name = "decompress40_mem, truncated input";
+
+        FILE *ppm = makeImage();
+        struct raster original;
+        bool read = readRaster(ppm, &original);
+        fclose(ppm);
+        assert(read);
+
+        unsigned char *compressed = NULL;
+        size_t length = compress40_mem(original.samples, WIDTH, HEIGHT,
+                                       (size_t) 3 * WIDTH, 255, &compressed,
+                                       0);
+        free(original.samples);
+        if (length == 0) {
+                return report(name, false, "compress40_mem failed");
+        }
+
+        unsigned char *pixels = NULL;
+        const char *why = NULL;
+        if (!decompress40_mem(compressed, length, &pixels, 3 * WIDTH)) {
+                why = "whole image refused";
+        }
+        free(pixels);
+
+        for (size_t prefix = 0; prefix < length && why == NULL; prefix++) {
+                pixels = NULL;
+                if (decompress40_mem(compressed, prefix, &pixels,
+                                     3 * WIDTH)) {
+                        why = "a truncated image was accepted";
+                }
+                free(pixels);
+        }
+
+        free(compressed);
+        return report(name, why == NULL, why);
+}
+
+/******** testMemOutOfRange ********
+ *
+ * Checks that compress40_mem refuses a sample above the denominator
+ * rather than overflowing a codeword field, and accepts the same image
+ * once it is in range.
+ *
+ * Parameters:
+ *      None.
+ * Returns:
+ *      Whether the test passed.
+ ************************/
+static bool testMemOutOfRange(void)
+{
+        const char *name = "compress40_mem, sample above denominator";
+
+        unsigned char pixels[3 * 4 * 4];
+        memset(pixels, 10, sizeof(pixels));
+        unsigned char *compressed = NULL;
+        const char *why = NULL;
+        if (compress40_mem(pixels, 4, 4, 3 * 4, 10, &compressed, 0) == 0) {
+                why = "an image in range was refused";
+        }
+        free(compressed);
+
+        pixels[sizeof(pixels) - 1] = 0xff;
+        compressed = NULL;
+        if (why == NULL && compress40_mem(pixels, 4, 4, 3 * 4, 10,
+                                          &compressed, 0) != 0) {
+                why = "an image out of range was accepted";
+        }
+        free(compressed);
+        return report(name, why == NULL, why);
+}
+
+/******** testTransformTruncated ********
+ *
+ * Checks that readWordsTransform reads a whole format 7 image and throws a
+ * CRE on every truncation of its codewords.
+ *
+ * Parameters:
+ *      None.
+ * Returns:
+ *      Whether the test passed.
+ ************************/
+static bool testTransformTruncated(void)
+{
+        const char *name = "readWordsTransform, truncated input";
+
+        FILE *ppm = makeImage();
+        FILE *compressed = tmpfile();
+        assert(compressed != NULL);
+        compress40_blocks(ppm, compressed, DEFAULT_TRANSFORM_SIZE);
+        fclose(ppm);
+        rewind(compressed);
+        size_t length;
+        unsigned char *bytes = readAll(compressed, &length);
+        fclose(compressed);
+
+        /* The header is two lines; the block size and codewords follow */
+        size_t header = 0;
+        for (int lines = 0; header < length && lines < 2; header++) {
+                lines += bytes[header] == '\n';
+        }
+
+        const char *why = NULL;
+        if (!readsTransform(bytes, length)) {
+                why = "whole image refused";
+        }
+        for (size_t prefix = header; prefix < length && why == NULL;
+             prefix++) {
+                if (readsTransform(bytes, prefix)) {
+                        why = "a truncated image was accepted";
+                }
+        }
+
+        free(bytes);
+        return report(name, why == NULL, why);
+}
+
+/******** readsTransform ********
+ *
+ * Reads the header and codewords of a format 7 image in a child process,
+ * since a CRE ends the process that throws it.
+ *
+ * Parameters:
+ *      const unsigned char *bytes:     The compressed image
+ *      size_t length:                  Its length in bytes
+ * Returns:
+ *      true if readWordsTransform returned, false if it threw a CRE.
+ * Notes:
+ *      Throws a CRE if the child cannot be started.
+ ************************/
+static bool readsTransform(const unsigned char *bytes, size_t length)
+{
+        fflush(stdout);
+        pid_t child = fork();
+        assert(child >= 0);
+        if (child == 0) {
+                /* The CRE's message is expected; keep it off the report */
+                FILE *quiet = freopen("/dev/null", "w", stderr);
+                assert(quiet != NULL);
+
+                FILE *input = tmpfile();
+                assert(input != NULL);
+                fwrite(bytes, 1, length, input);
+                rewind(input);
+
+                unsigned width, height;
+                struct quantScales scales;
+                unsigned format = readFormatHeader(input, &width, &height,
+                                                   &scales);
+                assert(format == 7);
+
+                A2Methods_T methods = uarray2_methods_plain;
+                int size;
+                UArray2_T blocks = readWordsTransform(input, methods, width,
+                                                      height, &size);
+                methods->free((A2Methods_UArray2 *) &blocks);
+                fclose(input);
+                _exit(0);
+        }
+
+        int status;
+        pid_t waited = waitpid(child, &status, 0);
+        assert(waited == child);
+        return WIFEXITED(status) && WEXITSTATUS(status) == 0;
+}
+
+/******** testServerBadSample ********
+ *
+ * Starts a server, sends it a PPM with a sample above its maxval and then
+ * a valid one, and checks that the first is refused, the second served,
+ * and the server still shuts down cleanly.
+ *
+ * Parameters:
+ *      None.
+ * Returns:
+ *      Whether the test passed.
+ ************************/
+static bool testServerBadSample(void)
+{
+        const char *name = "server, sample above maxval then a valid image";
+
+        char path[64];
+        snprintf(path, sizeof(path), "/tmp/test40-%d.sock", (int) getpid());
+
+        fflush(stdout);
+        pid_t server = fork();
+        assert(server >= 0);
+        if (server == 0) {
+                FILE *quiet = freopen("/dev/null", "w", stderr);
+                assert(quiet != NULL);
+                _exit(serve40(path, 1));
+        }
+
+        const char *why = NULL;
+        if (!waitForServer(path)) {
+                why = "the server did not start";
+        } else {
+                FILE *bad = tmpfile();
+                assert(bad != NULL);
+                fprintf(bad, "P6\n4 4\n10\n");
+                for (int k = 0; k < 3 * 4 * 4; k++) {
+                        putc(0xff, bad);
+                }
+                rewind(bad);
+                FILE *good = makeImage();
+
+                if (runClient(path, bad) == EXIT_SUCCESS) {
+                        why = "a sample above maxval was accepted";
+                } else if (runClient(path, good) != EXIT_SUCCESS) {
+                        why = "the valid image after it was not served";
+                }
+                fclose(bad);
+                fclose(good);
+        }
+
+        kill(server, SIGTERM);
+        int status;
+        pid_t waited = waitpid(server, &status, 0);
+        assert(waited == server);
+        if (why == NULL && (!WIFEXITED(status) ||
+                            WEXITSTATUS(status) != EXIT_SUCCESS)) {
+                why = "the server did not shut down cleanly";
+        }
+        unlink(path);
+        return report(name, why == NULL, why);
+}
+
+/******** waitForServer ********
+ *
+ * Waits up to five seconds for a server to accept connections on a socket.
+ *
+ * Parameters:
+ *      const char *path:       The server's socket
+ * Returns:
+ *      true once a connection succeeds, false if none does in time.
+ ************************/
+static bool waitForServer(const char *path)
+{
+        struct sockaddr_un address;
+        memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        strncpy(address.sun_path, path, sizeof(address.sun_path) - 1);
+
+        for (int attempt = 0; attempt < 500; attempt++) {
+                int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+                assert(fd >= 0);
+                bool connected = connect(fd, (struct sockaddr *) &address,
+                                         sizeof(address)) == 0;
+                close(fd);
+                if (connected) {
+                        return true;
+                }
+                usleep(10000);
+        }
+        return false;
+}
+
+/******** runClient ********
+ *
+ * Sends a compress request to a server from a child process, so that its
+ * output can be discarded.
+ *
+ * Parameters:
+ *      const char *path:       The server's socket
+ *      FILE *input:            The PPM to send, positioned at its start
+ * Returns:
+ *      client40's exit status, or EXIT_FAILURE if the child did not exit.
+ ************************/
+static int runClient(const char *path, FILE *input)
+{
+        fflush(stdout);
+        pid_t child = fork();
+        assert(child >= 0);
+        if (child == 0) {
+                FILE *out = freopen("/dev/null", "w", stdout);
+                FILE *err = freopen("/dev/null", "w", stderr);
+                assert(out != NULL && err != NULL);
+                _exit(client40(path, false, input, false));
+        }
+
+        int status;
+        pid_t waited = waitpid(child, &status, 0);
+        assert(waited == child);
+        return WIFEXITED(status) ? WEXITSTATUS(status) : EXIT_FAILURE;
+}
+
+/******** testTraceAtExit ********
+ *
+ * Records a span whose name needs escaping in a child that exits without
+ * calling traceClose, and checks the trace file holds exactly one event
+ * with the name escaped and a finished JSON document.
+ *
+ * Parameters:
+ *      None.
+ * Returns:
+ *      Whether the test passed.
+ ************************/
+static bool testTraceAtExit(void)
+{
+        const char *name = "trace, escaped names finished at exit";
+
+        char path[64];
+        snprintf(path, sizeof(path), "/tmp/test40-%d.json", (int) getpid());
+
+        fflush(stdout);
+        pid_t child = fork();
+        assert(child >= 0);
+        if (child == 0) {
+                traceOpen(path);
+                traceBegin("a \"quoted\" \\ name", "test");
+                traceEnd();
+                traceFlush();
+                exit(EXIT_SUCCESS);
+        }
+        int status;
+        pid_t waited = waitpid(child, &status, 0);
+        assert(waited == child);
+
+        FILE *trace = fopen(path, "r");
+        size_t length = 0;
+        unsigned char *bytes = NULL;
+        if (trace != NULL) {
+                /* readAll always leaves room for a terminator */
+                bytes = readAll(trace, &length);
+                bytes[length] = '\0';
+                fclose(trace);
+        }
+        unlink(path);
+
+        const char *text = (const char *) bytes;
+        const char *end = "\n]}\n";
+        const char *why = NULL;
+        if (!WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS) {
+                why = "the child did not exit cleanly";
+        } else if (bytes == NULL) {
+                why = "no trace file was written";
+        } else if (length < strlen(end) ||
+                   strcmp(text + length - strlen(end), end) != 0) {
+                why = "the JSON document was not finished";
+        } else if (strstr(text, "\"a \\\"quoted\\\" \\\\ name\"") == NULL) {
+                why = "the span's name was not escaped";
+        } else if (strstr(text, "},") != NULL) {
+                why = "the span was written more than once";
+        }
+        free(bytes);
+        return report(name, why == NULL, why);
+}
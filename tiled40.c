@@ -0,0 +1,269 @@
+/*
+ *      tiled40.c
+ *      Kevin Lu (klu07), Justin Paik (jpaik03)
+ *      October 18, 2026
+ *      arith
+ *
+ *      Implementation of tiled mode. Every step of the format 2 pipeline
+ *      works on 2x2 blocks alone, so an image can be cut into bands of
+ *      whole block rows and each band run through the usual steps on its
+ *      own. Bands are a multiple of CHECKSUM_BAND_ROWS block rows tall so
+ *      that each checksum covers the rows of exactly one band or less.
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <limits.h>
+#include <assert.h>
+
+#include "uarray2.h"
+#include "uarray2b.h"
+#include "a2methods.h"
+#include "a2plain.h"
+#include "a2blocked.h"
+#include "tiled40.h"
+#include "ppmStream.h"
+#include "pixelOperation.h"
+#include "blockOperation.h"
+#include "codewords.h"
+#include "checksum.h"
+#include "tableDecode.h"
+#include "stageTimer.h"
+
+#define BLOCKSIZE 2
+#define BAND_PIXELS (1 << 20)
+#define BAND_ALIGN (BLOCKSIZE * CHECKSUM_BAND_ROWS)
+
+static unsigned bandRows(unsigned width);
+static void packRow(const unsigned *samples, unsigned width,
+                    unsigned denominator, unsigned char *dest);
+
+/******** compress40_tiled ********
+ *
+ * Compresses a PPM to format 2 one band of rows at a time.
+ *
+ * Parameters:
+ *      FILE *input:    The PPM to compress
+ *      FILE *output:   The stream the compressed image is written to
+ *      const struct quantScales *scales:       The scales to quantize with,
+ *                                                or NULL for the defaults
+ * Returns:
+ *      true once the whole image is written, or false if input is not a
+ *      PPM, trims to nothing or ends early, or output cannot be written.
+ * Expects:
+ *      input and output are not NULL, and scales, if given, are valid.
+ * Notes:
+ *      Throws a CRE if input or output is NULL, the scales are invalid or
+ *        allocation fails.
+ *      Odd dimensions are trimmed as readImage trims them; the last row of
+ *        an odd-height image is never read.
+ *      If input ends early or a write fails, the header and earlier bands
+ *        have already been written.
+ *      Appends the checksum trailer (see checksum.h) if checksums are on.
+ ************************/
+bool compress40_tiled(FILE *input, FILE *output,
+                      const struct quantScales *scales)
+{
+        assert(input != NULL);
+        assert(output != NULL);
+        if (scales == NULL) {
+                scales = &DEFAULT_SCALES;
+        }
+        assert(validScales(scales));
+
+        struct ppmStream *stream = ppmStreamOpen(input);
+        if (stream == NULL) {
+                fprintf(stderr, "input is not a PPM image\n");
+                return false;
+        }
+        unsigned width = stream->width / BLOCKSIZE * BLOCKSIZE;
+        unsigned height = stream->height / BLOCKSIZE * BLOCKSIZE;
+        if (width == 0 || height == 0 || width > INT_MAX ||
+            height > INT_MAX) {
+                fprintf(stderr, "cannot compress a %ux%u image\n",
+                        stream->width, stream->height);
+                ppmStreamClose(&stream);
+                return false;
+        }
+
+        A2Methods_T bMethods = uarray2_methods_blocked;
+        A2Methods_T pMethods = uarray2_methods_plain;
+        assert(bMethods != NULL && pMethods != NULL);
+
+        stageBegin("C1-C4 tiled");
+        writeCompressedHeader(output, width, height, scales);
+
+        unsigned rowsPerBand = bandRows(width);
+        unsigned denominator = stream->denominator;
+        size_t stride = (size_t) 3 * width * (denominator < 256 ? 1 : 2);
+        unsigned *samples = malloc((size_t) 3 * stream->width *
+                                   sizeof(unsigned) + 1);
+        unsigned char *pixels = malloc(stride * rowsPerBand + 1);
+        assert(samples != NULL && pixels != NULL);
+
+        int numBands = (height / BLOCKSIZE + CHECKSUM_BAND_ROWS - 1) /
+                       CHECKSUM_BAND_ROWS;
+        uint32_t *bandCrcs = NULL;
+        if (checksumsEnabled()) {
+                bandCrcs = calloc(numBands + 1, sizeof(uint32_t));
+                assert(bandCrcs != NULL);
+        }
+
+        bool complete = true;
+        bool written = true;
+        for (unsigned top = 0; top < height && complete && written;
+             top += rowsPerBand) {
+                unsigned rows = height - top < rowsPerBand ? height - top :
+                                                             rowsPerBand;
+                for (unsigned row = 0; row < rows; row++) {
+                        if (!ppmStreamReadRow(stream, samples)) {
+                                complete = false;
+                                break;
+                        }
+                        packRow(samples, width, denominator,
+                                pixels + row * stride);
+                }
+                if (!complete) {
+                        break;
+                }
+
+                /* Steps C2 to C4 on this band alone */
+                UArray2b_T RGBCompVid = getRGBCompVidFromBuffer(pixels,
+                                                                width, rows,
+                                                                stride,
+                                                                denominator,
+                                                                bMethods);
+                UArray2_T DCTSpace = pixelsToDCTBlock(RGBCompVid, bMethods,
+                                                      pMethods);
+                bMethods->free((A2Methods_UArray2 *) &RGBCompVid);
+                UArray2_T quantInts = quantizeValues(DCTSpace, pMethods,
+                                                     scales);
+                pMethods->free((A2Methods_UArray2 *) &DCTSpace);
+
+                uint32_t *crcs = NULL;
+                if (bandCrcs != NULL) {
+                        crcs = bandCrcs + top / BAND_ALIGN;
+                }
+                written = printWordRows(output, quantInts, pMethods, crcs);
+                pMethods->free((A2Methods_UArray2 *) &quantInts);
+        }
+
+        if (complete && written && bandCrcs != NULL) {
+                writeChecksumTrailer(output, bandCrcs, numBands);
+        }
+        if (fflush(output) != 0 || ferror(output)) {
+                written = false;
+        }
+        stageEnd();
+        if (!complete) {
+                fprintf(stderr, "input ends before its last row\n");
+        } else if (!written) {
+                fprintf(stderr, "could not write the compressed image\n");
+        } else {
+                stageReport(stderr, width, height);
+        }
+
+        free(bandCrcs);
+        free(pixels);
+        free(samples);
+        ppmStreamClose(&stream);
+        return complete && written;
+}
+
+/******** decompress40_tiled ********
+ *
+ * Decompresses a format 2 image to a PPM one band of rows at a time.
+ *
+ * Parameters:
+ *      FILE *input:    The compressed image
+ *      FILE *output:   The stream the PPM is written to
+ * Returns:
+ *      true once the whole image is written, or false, after printing why
+ *      on stderr, if output cannot be written.
+ * Expects:
+ *      input and output are not NULL.
+ * Notes:
+ *      Throws a CRE if input or output is NULL, allocation fails, the
+ *        header is malformed or not format 2, or the codewords end early.
+ *      Only format 2 is read: the other formats cannot be decoded one band
+ *        at a time (their codes run across the whole image) or can already
+ *        be read a region at a time (see decompress40_region).
+ ************************/
+bool decompress40_tiled(FILE *input, FILE *output)
+{
+        assert(input != NULL);
+        assert(output != NULL);
+
+        unsigned width, height;
+        struct quantScales scales;
+        readCompressedHeader(input, &width, &height, &scales);
+
+        A2Methods_T pMethods = uarray2_methods_plain;
+        assert(pMethods != NULL);
+
+        stageBegin("(C4)'-(C1)' tiled");
+        fprintf(output, "P6\n%u %u\n%u\n", width, height, DENOMINATOR);
+
+        unsigned rowsPerBand = bandRows(width);
+        size_t stride = (size_t) 3 * width;
+        unsigned char *pixels = malloc(stride * rowsPerBand + 1);
+        assert(pixels != NULL);
+
+        bool written = true;
+        for (unsigned top = 0; top < height && written; top += rowsPerBand) {
+                unsigned rows = height - top < rowsPerBand ? height - top :
+                                                             rowsPerBand;
+                UArray2_T quantInts = readWords(input, pMethods, width, rows);
+                tableDecodeToBuffer(quantInts, pMethods, &scales, pixels,
+                                    stride);
+                pMethods->free((A2Methods_UArray2 *) &quantInts);
+                written = fwrite(pixels, stride, rows, output) == rows;
+        }
+        if (fflush(output) != 0 || ferror(output)) {
+                written = false;
+        }
+        stageEnd();
+        if (written) {
+                stageReport(stderr, width, height);
+        } else {
+                fprintf(stderr, "could not write the decompressed image\n");
+        }
+
+        free(pixels);
+        return written;
+}
+
+/******** bandRows ********
+ *
+ * Returns how many pixel rows to put in each band of an image this wide:
+ * about BAND_PIXELS pixels, rounded down to a multiple of BAND_ALIGN rows,
+ * but never fewer than BAND_ALIGN.
+ ************************/
+static unsigned bandRows(unsigned width)
+{
+        unsigned rows = BAND_PIXELS / (width > 0 ? width : 1);
+        rows -= rows % BAND_ALIGN;
+        return rows > BAND_ALIGN ? rows : BAND_ALIGN;
+}
+
+/******** packRow ********
+ *
+ * Stores the first width pixels of a row from ppmStreamReadRow as the bytes
+ * getRGBCompVidFromBuffer reads: one per sample if denominator is below
+ * 256, else two, big-endian.
+ ************************/
+static void packRow(const unsigned *samples, unsigned width,
+                    unsigned denominator, unsigned char *dest)
+{
+        size_t count = (size_t) 3 * width;
+        if (denominator < 256) {
+                for (size_t k = 0; k < count; k++) {
+                        dest[k] = samples[k];
+                }
+        } else {
+                for (size_t k = 0; k < count; k++) {
+                        dest[2 * k] = samples[k] >> 8;
+                        dest[2 * k + 1] = samples[k] & 0xff;
+                }
+        }
+}
@@ -0,0 +1,33 @@
+/*
+ *      tiled40.h
+ *      Kevin Lu (klu07), Justin Paik (jpaik03)
+ *      October 18, 2026
+ *      arith
+ *
+ *      Interface for tiled mode, which compresses and decompresses format 2
+ *      images a band of rows at a time rather than holding the whole image.
+ *      Memory use then depends on the width of an image but not its height,
+ *      so images far larger than memory (or than 2^31 pixels) go through.
+ *      The output is byte-for-byte what compress40_tuned and decompress40_to
+ *      write for the same image.
+ */
+
+#include <stdio.h>
+#include <stdbool.h>
+
+/* Defined in blockOperation.h */
+struct quantScales;
+
+/*
+ *  Reads a PPM from input and writes it to output in format 2, with the
+ *  given scales (NULL for the defaults). Returns false, after printing why
+ *  on stderr, if input is not a PPM, is too small or ends early.
+ */
+bool compress40_tiled(FILE *input, FILE *output,
+                      const struct quantScales *scales);
+
+/*
+ *  Reads a format 2 image from input and writes it to output as a PPM.
+ *  Returns false, after printing why on stderr, if output cannot be written.
+ */
+bool decompress40_tiled(FILE *input, FILE *output);
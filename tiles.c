@@ -0,0 +1,517 @@
+/*
+ *      tiles.c
+ *      Kevin Lu (klu07), Justin Paik (jpaik03)
+ *      October 18, 2026
+ *      arith
+ *
+ *      Implementation of compressed image format 4. After the usual header
+ *      ("COMP40 Compressed image format 4\n%u %u\n") come:
+ *
+ *        - The tile size in blocks, 4 bytes big-endian. Tiles are that many
+ *          blocks on a side, except at the right and bottom edges.
+ *        - The index: for each tile in row-major order, its offset (8 bytes)
+ *          from the end of the index and its length (4 bytes), big-endian.
+ *        - Each tile's data, exactly what entropyEncodeRegion writes.
+ *
+ *      A worker pool hands out tiles from a shared counter, as batch40 does
+ *      with images. Each worker codes into or decodes from its tile's own
+ *      memory stream, so tiles never share state.
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <assert.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "tiles.h"
+#include "codewords.h"
+#include "entropyCoding.h"
+#include "blockOperation.h"
+#include "trace.h"
+
+#define BLOCKSIZE 2
+#define FORMAT 4
+#define TILE_BLOCKS 64
+#define INDEX_ENTRY_BYTES 12
+
+/******** tile struct ********
+ *
+ * One tile's place in the image and its coded bytes.
+ *
+ * Fields:
+ *      int blockCol, blockRow:         First block of the tile
+ *      int blocksWide, blocksHigh:     Size of the tile in blocks
+ *      uint64_t offset:                Where its data starts, from the end
+ *                                        of the index
+ *      char *bytes:                    Its coded data
+ *      size_t length:                  Number of bytes of data
+ ************************/
+struct tile
+{
+        int blockCol, blockRow;
+        int blocksWide, blocksHigh;
+        uint64_t offset;
+        char *bytes;
+        size_t length;
+};
+
+/******** tileJobs struct ********
+ *
+ * The work shared by the pool.
+ *
+ * Fields:
+ *      struct tile **tiles:    The tiles to code or decode
+ *      int count:              Number of tiles
+ *      UArray2_T quantInts:    The blocks coded from or decoded into
+ *      A2Methods_T methods:    The method suite for quantInts
+ *      int originCol:          Image position of quantInts' first block
+ *      int originRow
+ *      bool decode:            Decode the tiles rather than code them
+ *      int next:               Index of the next tile to hand out
+ *      pthread_mutex_t lock:   Guards next
+ ************************/
+struct tileJobs
+{
+        struct tile **tiles;
+        int count;
+        UArray2_T quantInts;
+        A2Methods_T methods;
+        int originCol, originRow;
+        bool decode;
+        int next;
+        pthread_mutex_t lock;
+};
+
+static struct tile *newTiles(int blocksWide, int blocksHigh, int tileBlocks,
+                             int *count);
+static void runJobs(struct tileJobs *jobs, int numWorkers);
+static void *runWorker(void *cl);
+static void encodeTile(struct tileJobs *jobs, struct tile *tile);
+static void decodeTile(struct tileJobs *jobs, struct tile *tile);
+static void skipTo(FILE *input, uint64_t *position, uint64_t offset);
+static void putBigEndian(FILE *output, uint64_t value, int count);
+static uint64_t getBigEndian(const unsigned char *bytes, int count);
+
+/******** printWordsTiled ********
+ *
+ * Writes the format 4 header, tile size and index, then every tile's coded
+ * data.
+ *
+ * Parameters:
+ *      FILE *output:           The stream to write to
+ *      UArray2_T quantInts:    An array of 'quantized' structs
+ *      A2Methods_T methods:    The method suite for quantInts
+ *      int numWorkers:         Threads coding tiles, or <= 0 for one per
+ *                                CPU
+ *      const struct quantScales *scales:       The scales quantInts was
+ *                                                quantized with, for the
+ *                                                header
+ * Returns:
+ *      Nothing.
+ * Expects:
+ *      output, quantInts and methods are not NULL.
+ * Notes:
+ *      Throws a CRE if an argument is NULL or allocation fails.
+ *      Every tile is coded in memory first, since the index comes before
+ *        the data.
+ *      An array with no blocks has no tiles, so only the header, tile size
+ *        and an empty index are written.
+ ************************/
+void printWordsTiled(FILE *output, UArray2_T quantInts, A2Methods_T methods,
+                     int numWorkers, const struct quantScales *scales)
+{
+        assert(output != NULL);
+        assert(quantInts != NULL);
+        assert(methods != NULL);
+
+        int blocksWide = methods->width(quantInts);
+        int blocksHigh = methods->height(quantInts);
+        int count;
+        struct tile *tiles = newTiles(blocksWide, blocksHigh, TILE_BLOCKS,
+                                      &count);
+
+        struct tile **order = malloc(count * sizeof(*order) + 1);
+        assert(order != NULL);
+        for (int i = 0; i < count; i++) {
+                order[i] = &tiles[i];
+        }
+        struct tileJobs jobs = { order, count, quantInts, methods, 0, 0,
+                                 false, 0, PTHREAD_MUTEX_INITIALIZER };
+        runJobs(&jobs, numWorkers);
+
+        writeFormatHeader(output, FORMAT, blocksWide * BLOCKSIZE,
+                          blocksHigh * BLOCKSIZE, scales);
+        putBigEndian(output, TILE_BLOCKS, 4);
+        uint64_t offset = 0;
+        for (int i = 0; i < count; i++) {
+                putBigEndian(output, offset, 8);
+                putBigEndian(output, tiles[i].length, 4);
+                offset += tiles[i].length;
+        }
+        for (int i = 0; i < count; i++) {
+                fwrite(tiles[i].bytes, 1, tiles[i].length, output);
+                free(tiles[i].bytes);
+        }
+
+        free(order);
+        free(tiles);
+}
+
+/******** readWordsTiled ********
+ *
+ * Reads format 4 data and unpacks every block's fields.
+ *
+ * Parameters:
+ *      FILE *input:            File pointer positioned after the header
+ *      A2Methods_T methods:    The method suite for array operations
+ *      unsigned width:         The width of the image in pixels
+ *      unsigned height:        The height of the image in pixels
+ *      int numWorkers:         Threads decoding tiles, or <= 0 for one per
+ *                                CPU
+ * Returns:
+ *      A UArray2_T where each element is a 'quantized' struct.
+ * Notes:
+ *      Throws a CRE under the same conditions as readWordsTiledRegion.
+ ************************/
+UArray2_T readWordsTiled(FILE *input, A2Methods_T methods, unsigned width,
+                         unsigned height, int numWorkers)
+{
+        int originCol, originRow;
+        return readWordsTiledRegion(input, methods, width, height, 0, 0,
+                                    width / BLOCKSIZE, height / BLOCKSIZE,
+                                    &originCol, &originRow, numWorkers);
+}
+
+/******** readWordsTiledRegion ********
+ *
+ * Reads only the tiles that a rectangle of blocks touches, and decodes
+ * them in parallel.
+ *
+ * Parameters:
+ *      FILE *input:            File pointer positioned after the header
+ *      A2Methods_T methods:    The method suite for array operations
+ *      unsigned width:         The width of the whole image in pixels
+ *      unsigned height:        The height of the whole image in pixels
+ *      int blockCol:           First block column of the rectangle
+ *      int blockRow:           First block row of the rectangle
+ *      int blocksWide:         Width of the rectangle in blocks
+ *      int blocksHigh:         Height of the rectangle in blocks
+ *      int *originCol:         Where to store the image block column of the
+ *                                result's first block
+ *      int *originRow:         Likewise for its block row
+ *      int numWorkers:         Threads decoding tiles, or <= 0 for one per
+ *                                CPU
+ * Returns:
+ *      A UArray2_T of 'quantized' structs covering whole tiles.
+ * Expects:
+ *      input, methods, originCol and originRow are not NULL.
+ *      The rectangle lies inside the image, and is non-empty unless the
+ *        image is.
+ * Notes:
+ *      Throws a CRE if an argument is invalid, allocation fails, the index
+ *        or a tile is malformed, or the input ends early.
+ *      Skips unneeded tiles with fseeko when the input allows it, and by
+ *        reading past them otherwise (e.g. a pipe).
+ *      An image under 2 pixels wide or high has no blocks, so its index is
+ *        empty and so is the result.
+ ************************/
+UArray2_T readWordsTiledRegion(FILE *input, A2Methods_T methods,
+                               unsigned width, unsigned height, int blockCol,
+                               int blockRow, int blocksWide, int blocksHigh,
+                               int *originCol, int *originRow,
+                               int numWorkers)
+{
+        assert(input != NULL);
+        assert(methods != NULL);
+        assert(originCol != NULL && originRow != NULL);
+
+        int imageWide = width / BLOCKSIZE;
+        int imageHigh = height / BLOCKSIZE;
+        assert(blockCol >= 0 && blockRow >= 0);
+        assert(blocksWide >= 0 && blocksHigh >= 0);
+        assert((blocksWide > 0 && blocksHigh > 0) ||
+               imageWide == 0 || imageHigh == 0);
+        assert(blockCol + blocksWide <= imageWide);
+        assert(blockRow + blocksHigh <= imageHigh);
+
+        unsigned char sizeBytes[4];
+        size_t read = fread(sizeBytes, 1, 4, input);
+        assert(read == 4);
+        int tileBlocks = getBigEndian(sizeBytes, 4);
+        assert(tileBlocks > 0);
+
+        int count;
+        struct tile *tiles = newTiles(imageWide, imageHigh, tileBlocks,
+                                      &count);
+        size_t indexLength = (size_t) count * INDEX_ENTRY_BYTES;
+        unsigned char *index = malloc(indexLength + 1);
+        assert(index != NULL);
+        read = fread(index, 1, indexLength, input);
+        assert(read == indexLength);
+        for (int i = 0; i < count; i++) {
+                tiles[i].offset = getBigEndian(index + i * INDEX_ENTRY_BYTES,
+                                               8);
+                tiles[i].length = getBigEndian(index + i * INDEX_ENTRY_BYTES
+                                               + 8, 4);
+        }
+        free(index);
+
+        if (count == 0) {
+                free(tiles);
+                *originCol = 0;
+                *originRow = 0;
+                UArray2_T empty = methods->new(imageWide, imageHigh,
+                                               sizeof(struct quantized));
+                assert(empty != NULL);
+                return empty;
+        }
+
+        /* The tiles the rectangle touches */
+        int tilesWide = (imageWide + tileBlocks - 1) / tileBlocks;
+        int firstCol = blockCol / tileBlocks;
+        int lastCol = (blockCol + blocksWide - 1) / tileBlocks;
+        int firstRow = blockRow / tileBlocks;
+        int lastRow = (blockRow + blocksHigh - 1) / tileBlocks;
+        *originCol = firstCol * tileBlocks;
+        *originRow = firstRow * tileBlocks;
+
+        struct tile *last = &tiles[lastRow * tilesWide + lastCol];
+        UArray2_T quantInts = methods->new(last->blockCol + last->blocksWide -
+                                           *originCol,
+                                           last->blockRow + last->blocksHigh -
+                                           *originRow,
+                                           sizeof(struct quantized));
+        assert(quantInts != NULL);
+
+        /* Read the chosen tiles in file order, then decode them together */
+        int chosen = (lastRow - firstRow + 1) * (lastCol - firstCol + 1);
+        struct tile **order = malloc(chosen * sizeof(*order));
+        assert(order != NULL);
+        uint64_t position = 0;
+        int numChosen = 0;
+        for (int row = firstRow; row <= lastRow; row++) {
+                for (int col = firstCol; col <= lastCol; col++) {
+                        struct tile *tile = &tiles[row * tilesWide + col];
+                        assert(tile->length > 0);
+                        tile->bytes = malloc(tile->length);
+                        assert(tile->bytes != NULL);
+                        skipTo(input, &position, tile->offset);
+                        read = fread(tile->bytes, 1, tile->length, input);
+                        assert(read == tile->length);
+                        position += tile->length;
+                        order[numChosen++] = tile;
+                }
+        }
+
+        struct tileJobs jobs = { order, numChosen, quantInts, methods,
+                                 *originCol, *originRow, true, 0,
+                                 PTHREAD_MUTEX_INITIALIZER };
+        runJobs(&jobs, numWorkers);
+
+        for (int i = 0; i < numChosen; i++) {
+                free(order[i]->bytes);
+        }
+        free(order);
+        free(tiles);
+        return quantInts;
+}
+
+/******** newTiles ********
+ *
+ * Splits an image's blocks into tiles, in row-major order.
+ *
+ * Parameters:
+ *      int blocksWide, blocksHigh:     Size of the image in blocks
+ *      int tileBlocks:                 Tile size in blocks
+ *      int *count:                     Where to store the number of tiles
+ * Returns:
+ *      The tiles with their positions and sizes set, and no data.
+ ************************/
+static struct tile *newTiles(int blocksWide, int blocksHigh, int tileBlocks,
+                             int *count)
+{
+        int tilesWide = (blocksWide + tileBlocks - 1) / tileBlocks;
+        int tilesHigh = (blocksHigh + tileBlocks - 1) / tileBlocks;
+        *count = tilesWide * tilesHigh;
+
+        struct tile *tiles = calloc(*count + 1, sizeof(struct tile));
+        assert(tiles != NULL);
+        for (int row = 0; row < tilesHigh; row++) {
+                for (int col = 0; col < tilesWide; col++) {
+                        struct tile *tile = &tiles[row * tilesWide + col];
+                        tile->blockCol = col * tileBlocks;
+                        tile->blockRow = row * tileBlocks;
+                        tile->blocksWide = blocksWide - tile->blockCol <
+                                           tileBlocks ?
+                                           blocksWide - tile->blockCol :
+                                           tileBlocks;
+                        tile->blocksHigh = blocksHigh - tile->blockRow <
+                                           tileBlocks ?
+                                           blocksHigh - tile->blockRow :
+                                           tileBlocks;
+                }
+        }
+        return tiles;
+}
+
+/******** runJobs ********
+ *
+ * Codes or decodes every tile in jobs on a pool of threads.
+ *
+ * Parameters:
+ *      struct tileJobs *jobs:  The work to do
+ *      int numWorkers:         Threads to use, or <= 0 for one per CPU
+ * Returns:
+ *      Nothing.
+ * Notes:
+ *      Runs on the calling thread when one worker is enough.
+ ************************/
+static void runJobs(struct tileJobs *jobs, int numWorkers)
+{
+        if (numWorkers <= 0) {
+                numWorkers = (int) sysconf(_SC_NPROCESSORS_ONLN);
+        }
+        if (numWorkers > jobs->count) {
+                numWorkers = jobs->count;
+        }
+        if (numWorkers <= 1) {
+                runWorker(jobs);
+                return;
+        }
+
+        pthread_t *threads = malloc(numWorkers * sizeof(*threads));
+        assert(threads != NULL);
+        for (int i = 0; i < numWorkers; i++) {
+                int result = pthread_create(&threads[i], NULL, runWorker,
+                                            jobs);
+                assert(result == 0);
+        }
+        for (int i = 0; i < numWorkers; i++) {
+                pthread_join(threads[i], NULL);
+        }
+        free(threads);
+}
+
+/******** runWorker ********
+ *
+ * Thread body: takes tiles from the shared list until none remain.
+ *
+ * Parameters:
+ *      void *cl:       The struct tileJobs shared by all workers
+ * Returns:
+ *      NULL.
+ ************************/
+static void *runWorker(void *cl)
+{
+        struct tileJobs *jobs = cl;
+
+        for (;;) {
+                pthread_mutex_lock(&jobs->lock);
+                int index = jobs->next++;
+                pthread_mutex_unlock(&jobs->lock);
+                if (index >= jobs->count) {
+                        break;
+                }
+
+                if (jobs->decode) {
+                        decodeTile(jobs, jobs->tiles[index]);
+                } else {
+                        encodeTile(jobs, jobs->tiles[index]);
+                }
+        }
+        return NULL;
+}
+
+/******** encodeTile ********
+ *
+ * Codes one tile's blocks into a new memory buffer, stored in the tile.
+ ************************/
+static void encodeTile(struct tileJobs *jobs, struct tile *tile)
+{
+        traceBegin("encode tile", "worker");
+        FILE *stream = open_memstream(&tile->bytes, &tile->length);
+        assert(stream != NULL);
+        entropyEncodeRegion(stream, jobs->quantInts, jobs->methods,
+                            tile->blockCol, tile->blockRow,
+                            tile->blocksWide, tile->blocksHigh);
+        fclose(stream);
+        traceEnd();
+}
+
+/******** decodeTile ********
+ *
+ * Decodes one tile's bytes into its place in the shared array.
+ ************************/
+static void decodeTile(struct tileJobs *jobs, struct tile *tile)
+{
+        traceBegin("decode tile", "worker");
+        FILE *stream = fmemopen(tile->bytes, tile->length, "r");
+        assert(stream != NULL);
+        entropyDecodeRegion(stream, jobs->quantInts, jobs->methods,
+                            tile->blockCol - jobs->originCol,
+                            tile->blockRow - jobs->originRow,
+                            tile->blocksWide, tile->blocksHigh);
+        fclose(stream);
+        traceEnd();
+}
+
+/******** skipTo ********
+ *
+ * Moves forward through the tile data to a tile's offset.
+ *
+ * Parameters:
+ *      FILE *input:            The compressed image
+ *      uint64_t *position:     The current offset, updated
+ *      uint64_t offset:        The offset to move to
+ * Returns:
+ *      Nothing.
+ * Notes:
+ *      Throws a CRE if offset is behind the current position or the input
+ *        ends first.
+ ************************/
+static void skipTo(FILE *input, uint64_t *position, uint64_t offset)
+{
+        assert(offset >= *position);
+        uint64_t distance = offset - *position;
+        if (distance == 0) {
+                return;
+        }
+
+        if (fseeko(input, distance, SEEK_CUR) != 0) {
+                char discard[4096];
+                while (distance > 0) {
+                        size_t chunk = distance < sizeof(discard) ?
+                                       distance : sizeof(discard);
+                        size_t read = fread(discard, 1, chunk, input);
+                        assert(read == chunk);
+                        distance -= chunk;
+                }
+        }
+        *position = offset;
+}
+
+/******** putBigEndian ********
+ *
+ * Writes the low count bytes of value, most significant first.
+ ************************/
+static void putBigEndian(FILE *output, uint64_t value, int count)
+{
+        for (int shift = (count - 1) * 8; shift >= 0; shift -= 8) {
+                putc((value >> shift) & 0xFF, output);
+        }
+}
+
+/******** getBigEndian ********
+ *
+ * Assembles count big-endian bytes into a value.
+ ************************/
+static uint64_t getBigEndian(const unsigned char *bytes, int count)
+{
+        uint64_t value = 0;
+        for (int i = 0; i < count; i++) {
+                value = (value << 8) | bytes[i];
+        }
+        return value;
+}
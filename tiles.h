@@ -0,0 +1,41 @@
+/*
+ *      tiles.h
+ *      Kevin Lu (klu07), Justin Paik (jpaik03)
+ *      October 18, 2026
+ *      arith
+ *
+ *      Interface for compressed image format 4, a tiled container. The image
+ *      is split into square tiles of blocks, each entropy coded on its own
+ *      (see entropyCoding.h), and an index after the header gives every
+ *      tile's byte offset and length. Tiles are coded and decoded in
+ *      parallel, and a region decode reads only the tiles it touches.
+ */
+
+#include <stdio.h>
+
+#include "uarray2.h"
+#include "a2methods.h"
+
+/* Defined in blockOperation.h */
+struct quantScales;
+
+/* numWorkers <= 0 means one thread per CPU */
+
+/* Compression: writes the header too */
+void printWordsTiled(FILE *output, UArray2_T quantInts, A2Methods_T methods,
+                     int numWorkers, const struct quantScales *scales);
+
+/* Decompression: input is positioned just past the header */
+UArray2_T readWordsTiled(FILE *input, A2Methods_T methods, unsigned width,
+                         unsigned height, int numWorkers);
+
+/*
+ *  Decodes the tiles covering a rectangle of blocks. The result spans whole
+ *  tiles, so it may be larger than the rectangle; its first block's
+ *  position in the image is stored in originCol and originRow.
+ */
+UArray2_T readWordsTiledRegion(FILE *input, A2Methods_T methods,
+                               unsigned width, unsigned height, int blockCol,
+                               int blockRow, int blocksWide, int blocksHigh,
+                               int *originCol, int *originRow,
+                               int numWorkers);
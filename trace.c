@@ -0,0 +1,301 @@
+/*
+ *      trace.c
+ *      Kevin Lu (klu07), Justin Paik (jpaik03)
+ *      October 18, 2026
+ *      arith
+ * 
+ *      Implementation of Chrome trace-event export. Completed spans are kept
+ *      in memory as "complete" (ph "X") events until traceFlush appends them
+ *      to the JSON document, which traceClose finishes. Recording is
+ *      thread-safe: each thread keeps its own stack of open spans, and
+ *      completed spans are appended to the shared event list under a mutex.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <assert.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+
+#include "trace.h"
+
+#define MAX_DEPTH 16
+#define INITIAL_EVENTS 256
+
+/******** traceEvent struct ********
+ *
+ * One span of activity on one thread.
+ *
+ * Fields:
+ *      const char *name:       Span label, e.g. a stage name
+ *      const char *category:   Span category, e.g. "stage" or "io"
+ *      double start:           Microseconds since traceOpen
+ *      double duration:        Length of the span in microseconds
+ *      long tid:               Kernel id of the recording thread
+ ************************/
+struct traceEvent
+{
+        const char *name;
+        const char *category;
+        double start, duration;
+        long tid;
+};
+
+/* Initialize helper functions, see function contracts below */
+static double elapsedMicros(void);
+static void appendEvent(struct traceEvent *event);
+static void writeString(const char *string);
+
+static FILE *traceFile = NULL;
+static struct timespec origin;
+static bool wroteEvent = false;     /* whether the next event needs a comma */
+
+/* Completed spans from every thread */
+static pthread_mutex_t eventsLock = PTHREAD_MUTEX_INITIALIZER;
+static struct traceEvent *events = NULL;
+static size_t numEvents = 0, capacity = 0;
+
+/* Spans opened but not yet closed on this thread */
+static __thread struct traceEvent openSpans[MAX_DEPTH];
+static __thread int depth = 0;
+
+/******** traceOpen ********
+ *
+ * Starts recording spans, to be written to the file at path.
+ *
+ * Parameters:
+ *      const char *path:       Name of the JSON file to create
+ * Returns:
+ *      Nothing.
+ * Expects:
+ *      path is not NULL and can be opened for writing.
+ * Notes:
+ *      Throws a CRE if the file cannot be created.
+ *      The file is created immediately so a bad path fails before any work.
+ *      traceClose is registered with atexit, so the document is finished
+ *        however the program exits short of a CRE.
+ ************************/
+void traceOpen(const char *path)
+{
+        assert(path != NULL);
+
+        static bool registered = false;
+        traceFile = fopen(path, "w");
+        assert(traceFile != NULL);
+        fprintf(traceFile, "{\"displayTimeUnit\": \"ms\", "
+                "\"traceEvents\": [");
+        wroteEvent = false;
+        clock_gettime(CLOCK_MONOTONIC, &origin);
+        if (!registered) {
+                atexit(traceClose);
+                registered = true;
+        }
+}
+
+/******** traceEnabled ********
+ *
+ * Returns true if a trace file is open.
+ ************************/
+bool traceEnabled(void)
+{
+        return traceFile != NULL;
+}
+
+/******** traceBegin ********
+ *
+ * Opens a span on the calling thread.
+ *
+ * Parameters:
+ *      const char *name:       Span label
+ *      const char *category:   Span category
+ * Returns:
+ *      Nothing.
+ * Expects:
+ *      name and category are not NULL and outlive traceClose.
+ * Notes:
+ *      Does nothing if tracing is off. Spans nested deeper than MAX_DEPTH
+ *        are dropped.
+ ************************/
+void traceBegin(const char *name, const char *category)
+{
+        if (traceFile == NULL) {
+                return;
+        }
+        assert(name != NULL && category != NULL);
+
+        if (depth < MAX_DEPTH) {
+                struct traceEvent *event = &openSpans[depth];
+                event->name = name;
+                event->category = category;
+                event->tid = syscall(SYS_gettid);
+                event->start = elapsedMicros();
+        }
+        depth++;
+}
+
+/******** traceEnd ********
+ *
+ * Closes the span most recently opened on the calling thread.
+ *
+ * Parameters:
+ *      None.
+ * Returns:
+ *      Nothing.
+ * Expects:
+ *      Called once after each traceBegin on the same thread.
+ ************************/
+void traceEnd(void)
+{
+        if (traceFile == NULL) {
+                return;
+        }
+        assert(depth > 0);
+
+        depth--;
+        if (depth < MAX_DEPTH) {
+                struct traceEvent *event = &openSpans[depth];
+                event->duration = elapsedMicros() - event->start;
+                appendEvent(event);
+        }
+}
+
+/******** traceFlush ********
+ *
+ * Appends the spans completed so far to the trace file and forgets them.
+ *
+ * Parameters:
+ *      None.
+ * Returns:
+ *      Nothing.
+ * Notes:
+ *      Does nothing if tracing is off. Long-running callers (the server,
+ *        once per request) call this so the event list stays small; the
+ *        list's storage is kept for reuse.
+ ************************/
+void traceFlush(void)
+{
+        if (traceFile == NULL) {
+                return;
+        }
+
+        long pid = getpid();
+        pthread_mutex_lock(&eventsLock);
+        for (size_t i = 0; i < numEvents; i++) {
+                fprintf(traceFile, "%s\n{\"name\": ", wroteEvent ? "," : "");
+                writeString(events[i].name);
+                fprintf(traceFile, ", \"cat\": ");
+                writeString(events[i].category);
+                fprintf(traceFile, ", \"ph\": \"X\", \"ts\": %.3f, "
+                        "\"dur\": %.3f, \"pid\": %ld, \"tid\": %ld}",
+                        events[i].start, events[i].duration, pid,
+                        events[i].tid);
+                wroteEvent = true;
+        }
+        numEvents = 0;
+        fflush(traceFile);
+        pthread_mutex_unlock(&eventsLock);
+}
+
+/******** traceClose ********
+ *
+ * Writes every remaining span, finishes the JSON document and stops
+ * recording.
+ *
+ * Parameters:
+ *      None.
+ * Returns:
+ *      Nothing.
+ * Expects:
+ *      No other thread is recording spans.
+ * Notes:
+ *      Does nothing if tracing is off, so calling it again (as atexit does
+ *        after an explicit call) is harmless.
+ ************************/
+void traceClose(void)
+{
+        if (traceFile == NULL) {
+                return;
+        }
+
+        traceFlush();
+        fprintf(traceFile, "\n]}\n");
+        fclose(traceFile);
+        traceFile = NULL;
+
+        free(events);
+        events = NULL;
+        numEvents = capacity = 0;
+}
+
+/******** elapsedMicros ********
+ *
+ * Returns the monotonic time since traceOpen in microseconds.
+ ************************/
+static double elapsedMicros(void)
+{
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (ts.tv_sec - origin.tv_sec) * 1e6 +
+               (ts.tv_nsec - origin.tv_nsec) / 1e3;
+}
+
+/******** writeString ********
+ *
+ * Writes string to the trace file as a quoted JSON string.
+ *
+ * Parameters:
+ *      const char *string:     The text to write
+ * Returns:
+ *      Nothing.
+ * Expects:
+ *      string is not NULL and the trace file is open.
+ * Notes:
+ *      Escapes '"' and '\' and writes control characters as \u00XX, so any
+ *        name stays valid JSON.
+ ************************/
+static void writeString(const char *string)
+{
+        assert(string != NULL);
+
+        putc('"', traceFile);
+        for (const unsigned char *c = (const unsigned char *) string;
+             *c != '\0'; c++) {
+                if (*c == '"' || *c == '\\') {
+                        fprintf(traceFile, "\\%c", *c);
+                } else if (*c < 0x20) {
+                        fprintf(traceFile, "\\u%04x", *c);
+                } else {
+                        putc(*c, traceFile);
+                }
+        }
+        putc('"', traceFile);
+}
+
+/******** appendEvent ********
+ *
+ * Adds a completed span to the shared event list, growing it as needed.
+ *
+ * Parameters:
+ *      struct traceEvent *event:       The span to copy in
+ * Returns:
+ *      Nothing.
+ * Expects:
+ *      event is not NULL.
+ * Notes:
+ *      Throws a CRE if memory allocation fails.
+ ************************/
+static void appendEvent(struct traceEvent *event)
+{
+        assert(event != NULL);
+
+        pthread_mutex_lock(&eventsLock);
+        if (numEvents == capacity) {
+                capacity = capacity ? capacity * 2 : INITIAL_EVENTS;
+                events = realloc(events, capacity * sizeof(*events));
+                assert(events != NULL);
+        }
+        events[numEvents++] = *event;
+        pthread_mutex_unlock(&eventsLock);
+}
@@ -0,0 +1,23 @@
+/*
+ *      trace.h
+ *      Kevin Lu (klu07), Justin Paik (jpaik03)
+ *      October 18, 2026
+ *      arith
+ * 
+ *      Interface for optional Chrome trace-event export. When a trace file is
+ *      open, traceBegin/traceEnd pairs become spans in a JSON file that can
+ *      be loaded into chrome://tracing or the Perfetto UI. Spans nest per
+ *      thread and carry the id of the thread that recorded them. traceFlush
+ *      writes out the spans finished so far; traceClose, also run at exit,
+ *      finishes the file.
+ */
+
+#include <stdbool.h>
+
+void traceOpen(const char *path);
+bool traceEnabled(void);
+void traceFlush(void);
+void traceClose(void);
+
+void traceBegin(const char *name, const char *category);
+void traceEnd(void);
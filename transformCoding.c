@@ -0,0 +1,236 @@
+/*
+ *      transformCoding.c
+ *      Kevin Lu (klu07), Justin Paik (jpaik03)
+ *      October 18, 2026
+ *      arith
+ *
+ *      Implementation of compressed image format 7. After the usual header
+ *      ("COMP40 Compressed image format 7\n%u %u\n", both multiples of the
+ *      block size) come one byte holding the block size (4 or 8), then
+ *      every block in row-major block order as a bit stream, padded to a
+ *      whole byte at the end. For each of Y, Pb and Pr a block holds:
+ *
+ *        - se(DC - previous DC), the previous DC being the same channel's
+ *          in the block before (0 for the first block);
+ *        - ue(n), the number of non-zero AC coefficients;
+ *        - n pairs ue(zeros skipped), se(coefficient), walking the AC
+ *          coefficients in zigzag order.
+ *
+ *      ue is the order-0 Exp-Golomb code (value + 1 in binary, preceded by
+ *      one 0 bit per bit after the first); se maps v > 0 to 2v - 1 and
+ *      v <= 0 to -2v, then codes that with ue.
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <assert.h>
+
+#include "transformCoding.h"
+#include "blockTransform.h"
+#include "codewords.h"
+#include "bitStream.h"
+
+#define FORMAT 7
+#define CHANNELS 3
+#define MAX_CODE_BITS 32
+
+static void writeUnsigned(struct bitStream *stream, uint32_t value);
+static void writeSigned(struct bitStream *stream, int32_t value);
+static uint32_t readUnsigned(struct bitStream *stream);
+static int32_t readSigned(struct bitStream *stream);
+
+/******** printWordsTransform ********
+ *
+ * Writes the format 7 header, then every block's codewords.
+ *
+ * Parameters:
+ *      FILE *output:           The stream to write to
+ *      UArray2_T blocks:       An array of transformBlock structs
+ *      A2Methods_T methods:    The method suite for blocks
+ *      int size:               The side of a block, 4 or 8
+ * Returns:
+ *      Nothing.
+ * Expects:
+ *      output, blocks and methods are not NULL, and size is valid.
+ * Notes:
+ *      Throws a CRE if an expectation is violated.
+ ************************/
+void printWordsTransform(FILE *output, UArray2_T blocks, A2Methods_T methods,
+                         int size)
+{
+        assert(output != NULL);
+        assert(blocks != NULL);
+        assert(methods != NULL);
+        assert(validTransformSize(size));
+
+        int blocksWide = methods->width(blocks);
+        int blocksHigh = methods->height(blocks);
+        writeFormatHeader(output, FORMAT, blocksWide * size,
+                          blocksHigh * size, NULL);
+        putc(size, output);
+
+        const uint8_t *zigzag = zigzagOrder(size);
+        int numCoeffs = size * size;
+        struct bitStream stream = { output, 0, 0 };
+        int32_t previousDC[CHANNELS] = { 0, 0, 0 };
+
+        for (int row = 0; row < blocksHigh; row++) {
+                for (int col = 0; col < blocksWide; col++) {
+                        const struct transformBlock *block =
+                                methods->at(blocks, col, row);
+                        for (int ch = 0; ch < CHANNELS; ch++) {
+                                const int16_t *coeffs = block->coeffs[ch];
+                                writeSigned(&stream,
+                                            coeffs[0] - previousDC[ch]);
+                                previousDC[ch] = coeffs[0];
+
+                                uint32_t nonZero = 0;
+                                for (int i = 1; i < numCoeffs; i++) {
+                                        nonZero += coeffs[zigzag[i]] != 0;
+                                }
+                                writeUnsigned(&stream, nonZero);
+
+                                uint32_t zeros = 0;
+                                for (int i = 1; nonZero > 0; i++) {
+                                        int16_t coeff = coeffs[zigzag[i]];
+                                        if (coeff == 0) {
+                                                zeros++;
+                                                continue;
+                                        }
+                                        writeUnsigned(&stream, zeros);
+                                        writeSigned(&stream, coeff);
+                                        zeros = 0;
+                                        nonZero--;
+                                }
+                        }
+                }
+        }
+        flushBits(&stream);
+}
+
+/******** readWordsTransform ********
+ *
+ * Reads format 7 data into an array of transform blocks.
+ *
+ * Parameters:
+ *      FILE *input:            File pointer positioned after the header
+ *      A2Methods_T methods:    The method suite for the result
+ *      unsigned width:         The width of the image in pixels
+ *      unsigned height:        The height of the image in pixels
+ *      int *size:              Where to store the block size
+ * Returns:
+ *      A UArray2_T of transformBlock structs, which the caller must free.
+ * Expects:
+ *      input, methods and size are not NULL.
+ * Notes:
+ *      Throws a CRE if an argument is NULL or allocation fails.
+ *      Throws a CRE if the block size is not 4 or 8, the dimensions are
+ *        not multiples of it, the data ends early, or a block has more
+ *        coefficients than fit.
+ ************************/
+UArray2_T readWordsTransform(FILE *input, A2Methods_T methods, unsigned width,
+                             unsigned height, int *size)
+{
+        assert(input != NULL);
+        assert(methods != NULL);
+        assert(size != NULL);
+
+        *size = getc(input);
+        assert(validTransformSize(*size));
+        assert(width % *size == 0 && height % *size == 0);
+
+        int blocksWide = width / *size;
+        int blocksHigh = height / *size;
+        UArray2_T blocks = methods->new(blocksWide, blocksHigh,
+                                        sizeof(struct transformBlock));
+        assert(blocks != NULL);
+
+        const uint8_t *zigzag = zigzagOrder(*size);
+        uint32_t numCoeffs = *size * *size;
+        struct bitStream stream = { input, 0, 0 };
+        int32_t previousDC[CHANNELS] = { 0, 0, 0 };
+
+        for (int row = 0; row < blocksHigh; row++) {
+                for (int col = 0; col < blocksWide; col++) {
+                        struct transformBlock *block =
+                                methods->at(blocks, col, row);
+                        for (int ch = 0; ch < CHANNELS; ch++) {
+                                int16_t *coeffs = block->coeffs[ch];
+                                for (uint32_t i = 0; i < numCoeffs; i++) {
+                                        coeffs[i] = 0;
+                                }
+                                previousDC[ch] += readSigned(&stream);
+                                coeffs[0] = previousDC[ch];
+
+                                uint32_t nonZero = readUnsigned(&stream);
+                                uint32_t i = 0;
+                                while (nonZero-- > 0) {
+                                        i += readUnsigned(&stream) + 1;
+                                        assert(i < numCoeffs);
+                                        coeffs[zigzag[i]] =
+                                                readSigned(&stream);
+                                }
+                        }
+                }
+        }
+        return blocks;
+}
+
+/******** writeUnsigned ********
+ *
+ * Writes value as an order-0 Exp-Golomb codeword.
+ ************************/
+static void writeUnsigned(struct bitStream *stream, uint32_t value)
+{
+        uint64_t code = (uint64_t) value + 1;
+        int bits = 0;
+        while ((code >> bits) > 1) {
+                bits++;
+        }
+        putBits(stream, 0, bits);
+        putBits(stream, code, bits + 1);
+}
+
+/******** writeSigned ********
+ *
+ * Writes value as a signed Exp-Golomb codeword.
+ ************************/
+static void writeSigned(struct bitStream *stream, int32_t value)
+{
+        writeUnsigned(stream, value > 0 ? 2 * (uint32_t) value - 1 :
+                                          2 * (uint32_t) -value);
+}
+
+/******** readUnsigned ********
+ *
+ * Reads an order-0 Exp-Golomb codeword. Throws a CRE if the stream ends
+ * first or the codeword is longer than any writeUnsigned writes.
+ ************************/
+static uint32_t readUnsigned(struct bitStream *stream)
+{
+        uint64_t bit = 0;
+        int bits = 0;
+        bool read;
+        while ((read = getBits(stream, 1, &bit)) && bit == 0) {
+                bits++;
+                assert(bits < MAX_CODE_BITS);
+        }
+        assert(read);
+
+        uint64_t rest = 0;
+        read = getBits(stream, bits, &rest);
+        assert(read);
+        return ((1u << bits) | rest) - 1;
+}
+
+/******** readSigned ********
+ *
+ * Reads a signed Exp-Golomb codeword.
+ ************************/
+static int32_t readSigned(struct bitStream *stream)
+{
+        uint32_t code = readUnsigned(stream);
+        return code % 2 == 1 ? (int32_t) (code / 2 + 1) :
+                               -(int32_t) (code / 2);
+}
@@ -0,0 +1,28 @@
+/*
+ *      transformCoding.h
+ *      Kevin Lu (klu07), Justin Paik (jpaik03)
+ *      October 18, 2026
+ *      arith
+ *
+ *      Interface for compressed image format 7, the codewords of 4x4 and
+ *      8x8 transform blocks (see blockTransform.h). Each block's quantized
+ *      coefficients are written as variable-width Exp-Golomb codewords, so
+ *      a block whose high frequencies quantize to 0 takes a few bits
+ *      rather than a fixed 32 per 2x2 of pixels.
+ */
+
+#include <stdio.h>
+
+#include "uarray2.h"
+#include "a2methods.h"
+
+/* Compression: writes the header too */
+void printWordsTransform(FILE *output, UArray2_T blocks, A2Methods_T methods,
+                         int size);
+
+/*
+ *  Decompression: input is positioned just past the header. Stores the
+ *  block size in *size.
+ */
+UArray2_T readWordsTransform(FILE *input, A2Methods_T methods, unsigned width,
+                             unsigned height, int *size);